@@ -0,0 +1,184 @@
+#include "binary_protocol.h"
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+using json = nlohmann::json;
+
+namespace {
+    constexpr int ITERATIONS = 200000;
+
+    // Keeps results observable so the optimizer cannot drop the measured work
+    volatile int64_t sink = 0;
+
+    /**
+     * @brief Time a callable and return nanoseconds per call
+     */
+    double measure(const std::function<void()>& body) {
+        for (int i = 0; i < ITERATIONS / 10; ++i) body();
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < ITERATIONS; ++i) body();
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        return std::chrono::duration<double, std::nano>(elapsed).count() / ITERATIONS;
+    }
+
+    json makeBookChange(std::mt19937& rng, int levels) {
+        std::uniform_int_distribution<int> offset(1, 400);
+        std::uniform_int_distribution<int> size(1, 50000);
+        json bids = json::array();
+        json asks = json::array();
+        for (int i = 0; i < levels; ++i) {
+            bids.push_back({i % 5 == 0 ? "delete" : "change", 95000.0 - offset(rng) * 0.5, size(rng) * 10.0});
+            asks.push_back({i % 7 == 0 ? "new" : "change", 95000.5 + offset(rng) * 0.5, size(rng) * 10.0});
+        }
+        return {
+            {"type", "change"},
+            {"timestamp", 1735308192500},
+            {"prev_change_id", 68723117213},
+            {"change_id", 68723117214},
+            {"instrument_name", "BTC-PERPETUAL"},
+            {"bids", bids},
+            {"asks", asks}
+        };
+    }
+
+    json makeTicker() {
+        return {
+            {"timestamp", 1735308192500},
+            {"instrument_name", "BTC-PERPETUAL"},
+            {"best_bid_price", 95000.0},
+            {"best_bid_amount", 125430.0},
+            {"best_ask_price", 95000.5},
+            {"best_ask_amount", 2010.0},
+            {"last_price", 95000.5},
+            {"mark_price", 95000.27},
+            {"index_price", 94987.61},
+            {"open_interest", 1023418230.0}
+        };
+    }
+
+    json makeTrades(int count) {
+        json trades = json::array();
+        for (int i = 0; i < count; ++i) {
+            trades.push_back({
+                {"trade_seq", 189233712 + i},
+                {"trade_id", "3312" + std::to_string(i)},
+                {"timestamp", 1735308192500 + i},
+                {"tick_direction", 1},
+                {"price", 95000.5 + i},
+                {"mark_price", 95000.27},
+                {"instrument_name", "BTC-PERPETUAL"},
+                {"index_price", 94987.61},
+                {"direction", i % 2 ? "sell" : "buy"},
+                {"amount", 1250.0}
+            });
+        }
+        return trades;
+    }
+
+    /**
+     * @brief Compare the JSON and binary paths for one message kind
+     *
+     * Both encoders start from the parsed Deribit data, as the manager does;
+     * decoding reads every price and amount so neither side can skip work.
+     */
+    void compare(const char* name, const json& data,
+                 void (BinaryEncoder::*encode)(const json&, std::string&) const,
+                 const std::function<int64_t(const json&)>& readJson,
+                 const std::function<int64_t(const BinaryMessageView&)>& readBinary) {
+        BinaryEncoder encoder;
+        std::string text = data.dump();
+        std::string binary;
+        (encoder.*encode)(data, binary);
+
+        double jsonEncode = measure([&] {
+            std::string out = data.dump();
+            sink = sink + static_cast<int64_t>(out.size());
+        });
+        double binaryEncode = measure([&] {
+            (encoder.*encode)(data, binary);
+            sink = sink + static_cast<int64_t>(binary.size());
+        });
+        double jsonDecode = measure([&] {
+            json parsed = json::parse(text);
+            sink = sink + readJson(parsed);
+        });
+        double binaryDecode = measure([&] {
+            BinaryMessageView view;
+            if (view.parse(binary.data(), binary.size())) {
+                sink = sink + readBinary(view);
+            }
+        });
+
+        std::printf("%-12s %8zu %8zu %12.1f %12.1f %12.1f %12.1f\n", name,
+                    text.size(), binary.size(), jsonEncode, binaryEncode, jsonDecode, binaryDecode);
+    }
+}
+
+int main() {
+    std::mt19937 rng(42);
+
+    std::printf("%-12s %8s %8s %12s %12s %12s %12s\n", "message", "json B", "bin B",
+                "json enc ns", "bin enc ns", "json dec ns", "bin dec ns");
+
+    auto readBookJson = [](const json& book) {
+        int64_t total = 0;
+        for (const char* side : {"bids", "asks"}) {
+            for (const auto& level : book[side]) {
+                total += static_cast<int64_t>(level[1].get<double>() + level[2].get<double>());
+            }
+        }
+        return total;
+    };
+    auto readBookBinary = [](const BinaryMessageView& view) {
+        auto book = view.body<BinaryBook>();
+        int64_t total = 0;
+        for (std::size_t i = 0; i < static_cast<std::size_t>(book.bidCount + book.askCount); ++i) {
+            auto level = view.record<BinaryBook, BinaryLevel>(i);
+            total += level.priceTicks + level.amount;
+        }
+        return total;
+    };
+
+    compare("book x1", makeBookChange(rng, 1), &BinaryEncoder::encodeBook, readBookJson, readBookBinary);
+    compare("book x10", makeBookChange(rng, 10), &BinaryEncoder::encodeBook, readBookJson, readBookBinary);
+    compare("book x100", makeBookChange(rng, 100), &BinaryEncoder::encodeBook, readBookJson, readBookBinary);
+
+    compare("ticker", makeTicker(), &BinaryEncoder::encodeTicker,
+            [](const json& ticker) {
+                return static_cast<int64_t>(ticker["best_bid_price"].get<double>() +
+                                            ticker["best_ask_price"].get<double>() +
+                                            ticker["mark_price"].get<double>());
+            },
+            [](const BinaryMessageView& view) {
+                auto ticker = view.body<BinaryTicker>();
+                return ticker.bestBidTicks + ticker.bestAskTicks + ticker.markPriceE8;
+            });
+
+    auto readTradesJson = [](const json& trades) {
+        int64_t total = 0;
+        for (const auto& trade : trades) {
+            total += static_cast<int64_t>(trade["price"].get<double>() + trade["amount"].get<double>());
+        }
+        return total;
+    };
+    auto readTradesBinary = [](const BinaryMessageView& view) {
+        auto trades = view.body<BinaryTrades>();
+        int64_t total = 0;
+        for (std::size_t i = 0; i < trades.count; ++i) {
+            auto trade = view.record<BinaryTrades, BinaryTrade>(i);
+            total += trade.priceTicks + trade.amount;
+        }
+        return total;
+    };
+
+    compare("trades x1", makeTrades(1), &BinaryEncoder::encodeTrades, readTradesJson, readTradesBinary);
+    compare("trades x20", makeTrades(20), &BinaryEncoder::encodeTrades, readTradesJson, readTradesBinary);
+
+    return 0;
+}
@@ -0,0 +1,147 @@
+#include "message_deflate.h"
+#include <boost/beast/zlib/deflate_stream.hpp>
+#include <chrono>
+#include <cstdio>
+#include <malloc.h>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+using json = nlohmann::json;
+namespace zlib = boost::beast::zlib;
+
+/*
+ * Cost of compressing broadcasts for N local sessions.
+ *
+ * "per-session" models negotiated permessage-deflate as Beast runs it: one
+ * beast::zlib::deflate_stream per session, each compressing every message
+ * (with context takeover, or reset after each message). "shared" is the
+ * SHARED compression mode: one MessageDeflate compressing each message once.
+ * Socket writes are the same in every mode and are left out.
+ */
+
+namespace {
+    constexpr int MESSAGES = 20;
+
+    // Large allocations are served by mmap and only show up in hblkhd
+    std::size_t heapInUse() {
+        struct mallinfo2 info = mallinfo2();
+        return info.uordblks + info.hblkhd;
+    }
+
+    std::vector<std::string> makeUpdates(int count) {
+        std::mt19937 rng(7);
+        std::uniform_int_distribution<int> offset(1, 400);
+        std::uniform_int_distribution<int> size(1, 50000);
+        std::vector<std::string> updates;
+        for (int n = 0; n < count; ++n) {
+            json bids = json::array();
+            json asks = json::array();
+            for (int i = 0; i < 20; ++i) {
+                bids.push_back({"change", 95000.0 - offset(rng) * 0.5, size(rng) * 10.0});
+                asks.push_back({"change", 95000.5 + offset(rng) * 0.5, size(rng) * 10.0});
+            }
+            json update = {
+                {"type", "change"},
+                {"timestamp", 1735308192500 + n * 100},
+                {"prev_change_id", 68723117213 + n},
+                {"change_id", 68723117214 + n},
+                {"instrument_name", "BTC-PERPETUAL"},
+                {"bids", bids},
+                {"asks", asks}
+            };
+            updates.push_back(update.dump());
+        }
+        return updates;
+    }
+
+    struct Result {
+        double cpuUsPerBroadcast; /**< Compression CPU time per broadcast */
+        double bytesPerSession; /**< Compressor memory per session */
+        double compressedBytes; /**< Average compressed size of one update */
+    };
+
+    Result perSession(const std::vector<std::string>& updates, std::size_t sessions,
+                      const CompressionConfig& config) {
+        std::size_t before = heapInUse();
+        std::vector<std::unique_ptr<zlib::deflate_stream>> streams;
+        streams.reserve(sessions);
+        for (std::size_t i = 0; i < sessions; ++i) {
+            streams.push_back(std::make_unique<zlib::deflate_stream>());
+            streams.back()->reset(config.level, config.windowBits, config.memLevel, zlib::Strategy::normal);
+        }
+
+        std::vector<char> out(64 * 1024);
+        std::size_t compressed = 0;
+        double totalUs = 0;
+        for (const auto& update : updates) {
+            auto start = std::chrono::steady_clock::now();
+            for (auto& stream : streams) {
+                zlib::z_params zs;
+                zs.next_in = update.data();
+                zs.avail_in = update.size();
+                zs.next_out = out.data();
+                zs.avail_out = out.size();
+                boost::beast::error_code ec;
+                stream->write(zs, zlib::Flush::sync, ec);
+                if (stream.get() == streams.front().get()) {
+                    compressed += out.size() - zs.avail_out;
+                }
+                if (config.noContextTakeover) {
+                    stream->reset();
+                }
+            }
+            totalUs += std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+        }
+
+        // Compressor state is allocated on first use, so measure after the first messages
+        double bytes = static_cast<double>(heapInUse() - before) / sessions;
+        return {totalUs / updates.size(), bytes, static_cast<double>(compressed) / updates.size()};
+    }
+
+    Result shared(const std::vector<std::string>& updates, std::size_t sessions,
+                  const CompressionConfig& config) {
+        std::size_t before = heapInUse();
+        MessageDeflate deflater(config);
+        std::string out;
+
+        std::size_t compressed = 0;
+        double totalUs = 0;
+        for (const auto& update : updates) {
+            auto start = std::chrono::steady_clock::now();
+            deflater.compress(update, out);
+            totalUs += std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+            compressed += out.size();
+        }
+
+        double bytes = static_cast<double>(heapInUse() - before) / sessions;
+        return {totalUs / updates.size(), bytes, static_cast<double>(compressed) / updates.size()};
+    }
+
+    void print(const char* mode, std::size_t sessions, std::size_t raw, const Result& result) {
+        std::printf("%-24s %8zu %12.0f %14.0f %10zu %10.0f\n", mode, sessions,
+                    result.cpuUsPerBroadcast, result.bytesPerSession, raw, result.compressedBytes);
+    }
+}
+
+int main() {
+    auto updates = makeUpdates(MESSAGES);
+    std::size_t raw = 0;
+    for (const auto& update : updates) raw += update.size();
+    raw /= updates.size();
+
+    CompressionConfig config;
+    CompressionConfig resetting = config;
+    resetting.noContextTakeover = true;
+
+    std::printf("%-24s %8s %12s %14s %10s %10s\n", "mode", "sessions", "cpu us/bcast",
+                "bytes/session", "raw B", "wire B");
+    for (std::size_t sessions : {1000, 10000}) {
+        print("per-session", sessions, raw, perSession(updates, sessions, config));
+        print("per-session no-context", sessions, raw, perSession(updates, sessions, resetting));
+        print("shared", sessions, raw, shared(updates, sessions, config));
+    }
+    return 0;
+}
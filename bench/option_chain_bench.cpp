@@ -0,0 +1,113 @@
+#include "option_chain.h"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+    constexpr int ROUNDS = 50;
+    constexpr int64_t NOW_MS = 1735308192500;
+    constexpr double FORWARD = 95000.0;
+
+    // Keeps results observable so the optimizer cannot drop the measured work
+    volatile double sink = 0;
+
+    double normalCdf(double x) {
+        return 0.5 * std::erfc(-x / std::sqrt(2.0));
+    }
+
+    double black(double forward, double strike, double years, double vol, bool call) {
+        double spread = vol * std::sqrt(years);
+        double d1 = (std::log(forward / strike) + 0.5 * spread * spread) / spread;
+        double d2 = d1 - spread;
+        return call ? forward * normalCdf(d1) - strike * normalCdf(d2)
+                    : strike * normalCdf(-d2) - forward * normalCdf(-d1);
+    }
+
+    /**
+     * @brief Build a chain shaped like Deribit's BTC options: expiries from a day to a year, strikes every 1000
+     */
+    void makeChain(OptionChain& chain, std::vector<double>& vols, std::vector<double>& prices, std::mt19937& rng) {
+        std::uniform_real_distribution<double> smile(-0.05, 0.05);
+        const int days[] = {1, 2, 3, 7, 14, 21, 28, 56, 91, 119, 182, 273, 364};
+        for (int day : days) {
+            int64_t expiry = NOW_MS + static_cast<int64_t>(day) * 24 * 3600 * 1000;
+            double years = day / 365.0;
+            for (double strike = 40000; strike <= 200000; strike += 1000) {
+                for (bool call : {true, false}) {
+                    std::string name = "BTC-" + std::to_string(day) + "D-" + std::to_string(static_cast<int>(strike)) +
+                                       (call ? "-C" : "-P");
+                    std::size_t index = chain.add(name, strike, expiry, call);
+                    double moneyness = std::log(strike / FORWARD);
+                    double vol = 0.5 + 0.4 * moneyness * moneyness + smile(rng);
+                    // Deribit's smallest option tick is 0.0001 BTC; floored or deep in-the-money prices say little about the vol
+                    double price = black(FORWARD, strike, years, vol, call) / FORWARD;
+                    bool outOfMoney = call == (strike >= FORWARD);
+                    vols.push_back(outOfMoney && price > 0.0001 ? vol : std::nan(""));
+                    prices.push_back(std::max(price, 0.0001));
+                    chain.setForward(index, FORWARD);
+                    chain.setPrice(index, prices.back());
+                }
+            }
+        }
+    }
+
+    /**
+     * @brief Time a callable and return microseconds per call
+     */
+    double measure(const std::function<void()>& body) {
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < ROUNDS; ++i) body();
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        return std::chrono::duration<double, std::micro>(elapsed).count() / ROUNDS;
+    }
+}
+
+int main() {
+    std::mt19937 rng(42);
+    OptionChain chain;
+    std::vector<double> vols;
+    std::vector<double> prices;
+    makeChain(chain, vols, prices, rng);
+    chain.recompute(NOW_MS);
+
+    double maxError = 0;
+    std::size_t solved = 0;
+    for (std::size_t i = 0; i < chain.size(); ++i) {
+        double iv = chain.greeks(i).iv;
+        if (!std::isnan(iv)) {
+            ++solved;
+        }
+        if (!std::isnan(vols[i])) {
+            maxError = std::max(maxError, std::fabs(iv - vols[i]));
+        }
+    }
+
+    // The forward moves every round, so every instrument is dirty
+    double shift = 0;
+    double full = measure([&]() {
+        shift = shift > 0 ? -0.5 : 0.5;
+        chain.setForwardAll(FORWARD + shift);
+        sink = sink + chain.recompute(NOW_MS).size();
+    });
+
+    // One book in twenty moves, as between two 100 ms book notifications
+    std::uniform_int_distribution<std::size_t> pick(0, chain.size() - 1);
+    double partial = measure([&]() {
+        for (std::size_t i = 0; i < chain.size() / 20; ++i) {
+            std::size_t index = pick(rng);
+            prices[index] *= 1.001;
+            chain.setPrice(index, prices[index]);
+        }
+        sink = sink + chain.recompute(NOW_MS).size();
+    });
+
+    std::printf("%zu instruments, %zu solved, max IV error %.2e out of the money\n", chain.size(), solved, maxError);
+    std::printf("%-24s %12s %12s\n", "recompute", "us", "ns/option");
+    std::printf("%-24s %12.1f %12.1f\n", "full chain", full, full * 1000 / chain.size());
+    std::printf("%-24s %12.1f %12.1f\n", "5% of books", partial, partial * 1000 / (chain.size() / 20));
+    return 0;
+}
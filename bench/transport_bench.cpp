@@ -0,0 +1,94 @@
+#include "websocket_server.h"
+#include <boost/asio/connect.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+/*
+ * Local client transports: loopback TCP against a Unix domain socket.
+ *
+ * Both clients talk to the same in-process WebSocketServer. Latency is the
+ * round trip of a small request echoed back by the server's message handler;
+ * throughput is a stream of broadcasts read by a single client.
+ */
+
+namespace {
+    constexpr unsigned short PORT = 18765;
+    constexpr const char* SOCKET_PATH = "/tmp/deribit_transport_bench.sock";
+    constexpr int ROUND_TRIPS = 20000;
+    constexpr int BROADCASTS = 100000;
+
+    using Clock = std::chrono::steady_clock;
+
+    template <typename Socket>
+    void measure(const char* name, WebSocketServer& server, websocket::stream<Socket>& ws, std::size_t payload) {
+        std::string request(payload, 'x');
+        beast::flat_buffer buffer;
+        std::vector<double> samples;
+        samples.reserve(ROUND_TRIPS);
+
+        for (int i = 0; i < ROUND_TRIPS; ++i) {
+            auto start = Clock::now();
+            ws.write(net::buffer(request));
+            ws.read(buffer);
+            samples.push_back(std::chrono::duration<double, std::micro>(Clock::now() - start).count());
+            buffer.consume(buffer.size());
+        }
+        std::sort(samples.begin(), samples.end());
+
+        SharedBuffer update = makeSharedBuffer(std::string(payload, 'u'));
+        auto start = Clock::now();
+        for (int i = 0; i < BROADCASTS; ++i) {
+            server.broadcast(update);
+        }
+        for (int i = 0; i < BROADCASTS; ++i) {
+            ws.read(buffer);
+            buffer.consume(buffer.size());
+        }
+        double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+        std::printf("%-5s %6zu B  rtt p50 %7.1f us  p99 %7.1f us  | %9.0f msg/s %8.1f MB/s\n",
+                    name, payload, samples[samples.size() / 2], samples[samples.size() * 99 / 100],
+                    BROADCASTS / seconds, BROADCASTS * payload / seconds / 1e6);
+    }
+
+    template <typename Socket>
+    void handshake(websocket::stream<Socket>& ws) {
+        ws.handshake("localhost", "/");
+        ws.text(true);
+    }
+}
+
+int main() {
+    WebSocketServer server("127.0.0.1", PORT);
+    server.listenLocal(SOCKET_PATH);
+    server.onMessage([](std::shared_ptr<WebSocketSession> session, const std::string& message) {
+        session->send(message, false);
+    });
+    server.run();
+
+    for (std::size_t payload : {64, 1024, 16384}) {
+        {
+            net::io_context ioc;
+            websocket::stream<tcp::socket> ws(ioc);
+            ws.next_layer().connect(tcp::endpoint(net::ip::make_address("127.0.0.1"), PORT));
+            ws.next_layer().set_option(tcp::no_delay(true));
+            handshake(ws);
+            measure("tcp", server, ws, payload);
+            ws.close(websocket::close_code::normal);
+        }
+        {
+            net::io_context ioc;
+            websocket::stream<net::local::stream_protocol::socket> ws(ioc);
+            ws.next_layer().connect(net::local::stream_protocol::endpoint(SOCKET_PATH));
+            handshake(ws);
+            measure("unix", server, ws, payload);
+            ws.close(websocket::close_code::normal);
+        }
+    }
+
+    server.stop();
+    return 0;
+}
@@ -0,0 +1,144 @@
+#include "capture_dictionary.h"
+#include <zlib.h>
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+namespace {
+    constexpr std::size_t DMER_SIZE = 8;       // substring length used for scoring
+    constexpr std::size_t SEGMENT_SIZE = 64;   // bytes copied into the dictionary per pick
+    constexpr unsigned TABLE_BITS = 20;
+
+    inline uint32_t dmerHash(const char* p) {
+        uint64_t value;
+        std::memcpy(&value, p, sizeof(value));
+        return static_cast<uint32_t>((value * 0x9E3779B97F4A7C15ULL) >> (64 - TABLE_BITS));
+    }
+
+    struct Segment {
+        std::size_t offset;
+        uint64_t score;
+    };
+}
+
+CaptureDictionary CaptureDictionary::train(const std::vector<std::string>& samples, std::size_t capacity) {
+    CaptureDictionary dictionary;
+    capacity = std::min(capacity, MAX_SIZE);
+
+    std::string corpus;
+    std::size_t sampleCount = 0;
+    for (const auto& sample : samples) {
+        if (sample.empty()) continue;
+        corpus.append(sample);
+        ++sampleCount;
+    }
+
+    // Too little traffic to say anything useful; compress without a dictionary
+    if (sampleCount < 8 || corpus.size() < 2 * capacity || capacity < SEGMENT_SIZE) {
+        return dictionary;
+    }
+
+    const std::size_t n = corpus.size();
+    const char* bytes = corpus.data();
+
+    std::vector<uint32_t> frequency(std::size_t(1) << TABLE_BITS, 0);
+    for (std::size_t i = 0; i + DMER_SIZE <= n; ++i) {
+        ++frequency[dmerHash(bytes + i)];
+    }
+
+    // One pick per slice of the corpus keeps the dictionary representative of
+    // all message types seen during training, not just the most common one.
+    const std::size_t picks = capacity / SEGMENT_SIZE;
+    const std::size_t sliceSize = n / picks;
+    const std::size_t dmersPerSegment = SEGMENT_SIZE - DMER_SIZE + 1;
+
+    std::vector<Segment> chosen;
+    chosen.reserve(picks);
+    for (std::size_t slice = 0; slice < picks; ++slice) {
+        std::size_t begin = slice * sliceSize;
+        std::size_t end = std::min(begin + sliceSize, n);
+        if (end - begin < SEGMENT_SIZE) continue;
+
+        uint64_t score = 0;
+        for (std::size_t i = 0; i < dmersPerSegment; ++i) {
+            score += frequency[dmerHash(bytes + begin + i)];
+        }
+
+        uint64_t bestScore = score;
+        std::size_t bestOffset = begin;
+        for (std::size_t p = begin + 1; p + SEGMENT_SIZE <= end; ++p) {
+            score += frequency[dmerHash(bytes + p + dmersPerSegment - 1)];
+            score -= frequency[dmerHash(bytes + p - 1)];
+            if (score > bestScore) {
+                bestScore = score;
+                bestOffset = p;
+            }
+        }
+
+        if (bestScore == 0) continue;
+        chosen.push_back({bestOffset, bestScore});
+
+        // Substrings already in the dictionary gain nothing from a second copy
+        for (std::size_t i = 0; i < dmersPerSegment; ++i) {
+            frequency[dmerHash(bytes + bestOffset + i)] = 0;
+        }
+    }
+
+    if (chosen.empty()) {
+        return dictionary;
+    }
+
+    std::stable_sort(chosen.begin(), chosen.end(),
+                     [](const Segment& a, const Segment& b) { return a.score < b.score; });
+
+    std::string trained;
+    trained.reserve(chosen.size() * SEGMENT_SIZE);
+    for (const auto& segment : chosen) {
+        trained.append(bytes + segment.offset, SEGMENT_SIZE);
+    }
+    if (trained.size() > capacity) {
+        trained.erase(0, trained.size() - capacity);
+    }
+
+    dictionary.assign(std::move(trained));
+    return dictionary;
+}
+
+CaptureDictionary CaptureDictionary::load(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        throw Exception("Failed to open dictionary " + path);
+    }
+
+    std::stringstream contents;
+    contents << file.rdbuf();
+
+    CaptureDictionary dictionary;
+    dictionary.assign(contents.str());
+    if (dictionary.empty() || dictionary.size() > MAX_SIZE) {
+        throw Exception("Invalid dictionary size in " + path);
+    }
+    return dictionary;
+}
+
+void CaptureDictionary::save(const std::string& path) const {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        throw Exception("Failed to write dictionary " + path);
+    }
+    file.write(data.data(), static_cast<std::streamsize>(data.size()));
+}
+
+std::string CaptureDictionary::fileName(uint32_t id) {
+    return "dict-" + std::to_string(id) + ".zdict";
+}
+
+void CaptureDictionary::assign(std::string bytes) {
+    data = std::move(bytes);
+    dictionaryId = data.empty()
+        ? 0
+        : static_cast<uint32_t>(adler32(adler32(0L, Z_NULL, 0),
+                                        reinterpret_cast<const Bytef*>(data.data()),
+                                        static_cast<uInt>(data.size())));
+}
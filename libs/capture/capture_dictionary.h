@@ -0,0 +1,106 @@
+#ifndef CAPTURE_DICTIONARY_H
+#define CAPTURE_DICTIONARY_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <stdexcept>
+
+/**
+ * @brief Preset deflate dictionary trained on captured Deribit frames
+ *
+ * Deribit frames repeat the same keys, channel names and JSON-RPC envelope, so
+ * priming every block's deflate stream with a dictionary of the most frequent
+ * byte sequences in our own traffic lets small blocks compress almost as well
+ * as large ones, while each block stays independently decodable.
+ */
+class CaptureDictionary {
+public:
+    /**
+     * @brief Largest dictionary deflate can make use of (its window size)
+     */
+    static constexpr std::size_t MAX_SIZE = 32 * 1024;
+
+    /**
+     * @brief Construct an empty dictionary (blocks are compressed without one)
+     */
+    CaptureDictionary() = default;
+
+    /**
+     * @brief Train a dictionary from sample frames
+     *
+     * Picks, from each slice of the samples, the segment whose 8-byte
+     * substrings occur most often across all samples and that is not already
+     * covered, then lays the segments out with the most valuable ones last
+     * (closest to the data, so deflate can reach them with short distances).
+     *
+     * @param samples Sample frames, typically the first megabytes of a capture
+     * @param capacity Maximum dictionary size in bytes (at most MAX_SIZE)
+     * @return CaptureDictionary The trained dictionary, empty if there was too little data
+     */
+    static CaptureDictionary train(const std::vector<std::string>& samples, std::size_t capacity);
+
+    /**
+     * @brief Load a dictionary from a file
+     *
+     * @param path Path of the dictionary file
+     * @return CaptureDictionary The loaded dictionary
+     */
+    static CaptureDictionary load(const std::string& path);
+
+    /**
+     * @brief Save the dictionary to a file
+     *
+     * @param path Path of the dictionary file
+     */
+    void save(const std::string& path) const;
+
+    /**
+     * @brief Get the canonical file name for a dictionary id
+     *
+     * @param id The dictionary id
+     * @return std::string File name of the form "dict-<id>.zdict"
+     */
+    static std::string fileName(uint32_t id);
+
+    /**
+     * @brief Check whether the dictionary holds any data
+     */
+    bool empty() const { return data.empty(); }
+
+    /**
+     * @brief Get the dictionary id (Adler-32 of its bytes, 0 when empty)
+     */
+    uint32_t id() const { return dictionaryId; }
+
+    /**
+     * @brief Get the size of the dictionary in bytes
+     */
+    std::size_t size() const { return data.size(); }
+
+    /**
+     * @brief Get the dictionary bytes
+     */
+    const std::string& bytes() const { return data; }
+
+    /**
+     * @brief Exception class for dictionary errors
+     */
+    class Exception : public std::runtime_error {
+    public:
+        explicit Exception(const std::string& message) : std::runtime_error(message) {}
+    };
+
+private:
+    /**
+     * @brief Set the dictionary bytes and compute the id
+     *
+     * @param bytes The dictionary bytes
+     */
+    void assign(std::string bytes);
+
+    std::string data; /**< Raw dictionary bytes */
+    uint32_t dictionaryId = 0; /**< Adler-32 of the dictionary, as in the zlib header */
+};
+
+#endif // CAPTURE_DICTIONARY_H
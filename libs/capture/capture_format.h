@@ -0,0 +1,168 @@
+#ifndef CAPTURE_FORMAT_H
+#define CAPTURE_FORMAT_H
+
+#include <cstdint>
+#include <string_view>
+
+/*
+ * On-disk layout of a capture segment (all integers little-endian):
+ *
+ *   capture-<first_ts_ns>.dcap      CaptureSegmentHeader, then repeated
+ *                                   { CaptureBlockHeader, deflate payload }
+ *   capture-<first_ts_ns>.dcap.idx  one CaptureIndexEntry per block
+ *   capture-<first_ts_ns>.dcap.iidx CaptureInstrumentEntry records sorted by
+ *                                   (instrumentHash, block), written when the
+ *                                   segment is closed
+ *   dict-<id>.zdict                 preset deflate dictionary shared by segments
+ *
+ * A decompressed block payload is a run of { CaptureFrameHeader, frame bytes }.
+ * Blocks are independent raw deflate streams primed with the dictionary, so any
+ * block can be located through the index and decoded on its own.
+ */
+
+constexpr uint32_t CAPTURE_SEGMENT_MAGIC = 0x50414344; /**< "DCAP" */
+constexpr uint32_t CAPTURE_BLOCK_MAGIC = 0x4B4C4244;   /**< "DBLK" */
+constexpr uint16_t CAPTURE_FORMAT_VERSION = 1;
+
+/** Channel kinds recorded per instrument and block in the instrument index */
+constexpr uint32_t CAPTURE_CHANNEL_BOOK = 1 << 0;
+constexpr uint32_t CAPTURE_CHANNEL_BOOK_SNAPSHOT = 1 << 1;
+constexpr uint32_t CAPTURE_CHANNEL_TRADES = 1 << 2;
+constexpr uint32_t CAPTURE_CHANNEL_TICKER = 1 << 3;
+constexpr uint32_t CAPTURE_CHANNEL_OTHER = 1 << 4;
+
+#pragma pack(push, 1)
+
+/**
+ * @brief Header written once at the start of every segment file
+ */
+struct CaptureSegmentHeader {
+    uint32_t magic; /**< CAPTURE_SEGMENT_MAGIC */
+    uint16_t version; /**< CAPTURE_FORMAT_VERSION */
+    uint16_t flags; /**< Reserved, zero */
+    uint32_t dictionaryId; /**< Dictionary id (Adler-32), 0 when no dictionary is used */
+    uint32_t reserved; /**< Reserved, zero */
+    uint64_t createdNs; /**< Wall-clock creation time in nanoseconds since epoch */
+};
+
+/**
+ * @brief Header preceding every compressed block in a segment file
+ */
+struct CaptureBlockHeader {
+    uint32_t magic; /**< CAPTURE_BLOCK_MAGIC */
+    uint32_t compressedSize; /**< Size of the deflate payload that follows */
+    uint32_t rawSize; /**< Size of the payload once decompressed */
+    uint32_t frameCount; /**< Number of frames in the block */
+    uint64_t firstTimestampNs; /**< Timestamp of the first frame */
+    uint64_t lastTimestampNs; /**< Timestamp of the last frame */
+};
+
+/**
+ * @brief Header preceding every frame inside a decompressed block
+ */
+struct CaptureFrameHeader {
+    uint64_t timestampNs; /**< Receive time in nanoseconds since epoch */
+    uint32_t length; /**< Length of the frame bytes that follow */
+};
+
+/**
+ * @brief Fixed-size entry of the per-segment block index
+ */
+struct CaptureIndexEntry {
+    uint64_t firstTimestampNs; /**< Timestamp of the first frame in the block */
+    uint64_t lastTimestampNs; /**< Timestamp of the last frame in the block */
+    uint64_t offset; /**< File offset of the block header */
+    uint32_t compressedSize; /**< Size of the deflate payload */
+    uint32_t rawSize; /**< Size of the decompressed payload */
+    uint32_t frameCount; /**< Number of frames in the block */
+    uint32_t reserved; /**< Reserved, zero */
+};
+
+/**
+ * @brief Entry of the per-segment instrument index
+ */
+struct CaptureInstrumentEntry {
+    uint64_t instrumentHash; /**< captureInstrumentHash() of the instrument name */
+    uint32_t block; /**< Block number within the segment */
+    uint32_t channels; /**< CAPTURE_CHANNEL_* bits seen for the instrument in the block */
+};
+
+#pragma pack(pop)
+
+static_assert(sizeof(CaptureSegmentHeader) == 24, "unexpected segment header size");
+static_assert(sizeof(CaptureBlockHeader) == 32, "unexpected block header size");
+static_assert(sizeof(CaptureFrameHeader) == 12, "unexpected frame header size");
+static_assert(sizeof(CaptureIndexEntry) == 40, "unexpected index entry size");
+static_assert(sizeof(CaptureInstrumentEntry) == 16, "unexpected instrument entry size");
+
+/**
+ * @brief Hash an instrument name for the instrument index (64-bit FNV-1a)
+ *
+ * @param instrument The instrument name
+ * @return uint64_t The hash
+ */
+inline uint64_t captureInstrumentHash(std::string_view instrument) {
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (unsigned char c : instrument) {
+        hash ^= c;
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+/**
+ * @brief Extract the channel of a Deribit subscription notification
+ *
+ * Only looks at the raw text, so it is cheap enough to run on every frame.
+ *
+ * @param frame The raw frame
+ * @return std::string_view The channel, empty if the frame is not a notification
+ */
+inline std::string_view captureFrameChannel(std::string_view frame) {
+    constexpr std::string_view key = "\"channel\":\"";
+    auto start = frame.find(key);
+    if (start == std::string_view::npos) return {};
+    start += key.size();
+    auto end = frame.find('"', start);
+    if (end == std::string_view::npos) return {};
+    return frame.substr(start, end - start);
+}
+
+/**
+ * @brief Classify a frame for the instrument index
+ *
+ * Market channels look like "<kind>.<instrument>.<interval>"; private user
+ * channels are not indexed.
+ *
+ * @param frame The raw frame
+ * @param instrument Receives the instrument name on success
+ * @return uint32_t CAPTURE_CHANNEL_* bits, 0 if the frame is not indexed
+ */
+inline uint32_t captureClassifyFrame(std::string_view frame, std::string_view& instrument) {
+    std::string_view channel = captureFrameChannel(frame);
+    auto kindEnd = channel.find('.');
+    if (kindEnd == std::string_view::npos) return 0;
+
+    std::string_view kind = channel.substr(0, kindEnd);
+    if (kind == "user") return 0;
+
+    auto instrumentEnd = channel.find('.', kindEnd + 1);
+    instrument = channel.substr(kindEnd + 1,
+        instrumentEnd == std::string_view::npos ? std::string_view::npos : instrumentEnd - kindEnd - 1);
+
+    if (kind == "book") {
+        // Grouped books ("book.X.none.10.100ms") are full books every time, but not
+        // a starting point for the raw book's changes, so they are not flagged as snapshots
+        bool grouped = instrumentEnd != std::string_view::npos &&
+                       channel.find('.', instrumentEnd + 1) != std::string_view::npos;
+        if (!grouped && frame.find("\"type\":\"snapshot\"") != std::string_view::npos) {
+            return CAPTURE_CHANNEL_BOOK | CAPTURE_CHANNEL_BOOK_SNAPSHOT;
+        }
+        return CAPTURE_CHANNEL_BOOK;
+    }
+    if (kind == "trades") return CAPTURE_CHANNEL_TRADES;
+    if (kind == "ticker" || kind == "incremental_ticker") return CAPTURE_CHANNEL_TICKER;
+    return CAPTURE_CHANNEL_OTHER;
+}
+
+#endif // CAPTURE_FORMAT_H
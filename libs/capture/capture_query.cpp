@@ -0,0 +1,160 @@
+#include "capture_query.h"
+#include <algorithm>
+#include <filesystem>
+
+CaptureQuery::CaptureQuery(const std::string& dir)
+    : directory(dir) {
+    if (!std::filesystem::is_directory(directory)) {
+        throw std::runtime_error("Not a capture directory: " + directory);
+    }
+
+    std::vector<std::pair<uint64_t, std::string>> found;
+    for (const auto& entry : std::filesystem::directory_iterator(directory)) {
+        const std::string name = entry.path().filename().string();
+        if (entry.path().extension() != ".dcap" || name.rfind("capture-", 0) != 0) continue;
+        try {
+            uint64_t start = std::stoull(name.substr(8, name.size() - 8 - 5));
+            found.emplace_back(start, entry.path().string());
+        } catch (const std::exception&) {
+            // Not one of ours
+        }
+    }
+    std::sort(found.begin(), found.end());
+
+    for (auto& segment : found) {
+        segmentStarts.push_back(segment.first);
+        segmentPaths.push_back(std::move(segment.second));
+    }
+    readers.resize(segmentPaths.size());
+}
+
+CaptureReader& CaptureQuery::reader(std::size_t segment) {
+    if (!readers[segment]) {
+        readers[segment] = std::make_unique<CaptureReader>(segmentPaths[segment], directory);
+    }
+    return *readers[segment];
+}
+
+std::size_t CaptureQuery::segmentFor(uint64_t timestampNs) const {
+    auto it = std::upper_bound(segmentStarts.begin(), segmentStarts.end(), timestampNs);
+    if (it == segmentStarts.begin()) return segmentStarts.size();
+    return static_cast<std::size_t>(it - segmentStarts.begin()) - 1;
+}
+
+bool CaptureQuery::bookAt(const std::string& instrument, uint64_t timestampNs, OrderBook& book) {
+    std::size_t lastSegment = segmentFor(timestampNs);
+    if (lastSegment == segmentStarts.size()) {
+        return false;
+    }
+
+    // Walk back to the most recent block holding a snapshot of this book
+    std::size_t snapshotSegment = segmentStarts.size();
+    std::size_t snapshotBlock = 0;
+    for (std::size_t segment = lastSegment + 1; segment-- > 0;) {
+        CaptureReader& segmentReader = reader(segment);
+        auto entries = segmentReader.instrumentBlocks(instrument);
+        for (auto it = entries.rbegin(); it != entries.rend(); ++it) {
+            if ((it->channels & CAPTURE_CHANNEL_BOOK_SNAPSHOT) &&
+                segmentReader.block(it->block).firstTimestampNs <= timestampNs) {
+                snapshotSegment = segment;
+                snapshotBlock = it->block;
+                break;
+            }
+        }
+        if (snapshotSegment != segmentStarts.size()) break;
+    }
+    if (snapshotSegment == segmentStarts.size()) {
+        return false;
+    }
+
+    // Only the raw book; grouped books ("book.X.none.10.100ms") share the instrument's blocks
+    book = OrderBook(instrument);
+    scanInstrument(instrument, CAPTURE_CHANNEL_BOOK, {"book." + instrument + ".100ms", "book." + instrument + ".raw"},
+                   snapshotSegment, snapshotBlock, 0, timestampNs,
+                   [&book](uint64_t, std::string_view frame) {
+                       json message = json::parse(frame.begin(), frame.end(), nullptr, false);
+                       if (!message.is_discarded() && message.contains("params") &&
+                           message["params"].contains("data")) {
+                           book.apply(message["params"]["data"]);
+                       }
+                       return true;
+                   });
+    return book.isValid();
+}
+
+void CaptureQuery::trades(const std::string& instrument, uint64_t fromNs, uint64_t toNs,
+                          const std::function<bool(uint64_t, const json&)>& visitor) {
+    std::size_t firstSegment = segmentFor(fromNs);
+    if (firstSegment == segmentStarts.size()) {
+        firstSegment = 0;
+    }
+
+    scanInstrument(instrument, CAPTURE_CHANNEL_TRADES, {"trades." + instrument + ".100ms", "trades." + instrument + ".raw"},
+                   firstSegment, 0, fromNs, toNs,
+                   [&visitor](uint64_t timestampNs, std::string_view frame) {
+                       json message = json::parse(frame.begin(), frame.end(), nullptr, false);
+                       if (message.is_discarded() || !message.contains("params")) return true;
+                       const json& data = message["params"]["data"];
+                       if (!data.is_array()) return true;
+                       for (const auto& trade : data) {
+                           if (!visitor(timestampNs, trade)) return false;
+                       }
+                       return true;
+                   });
+}
+
+void CaptureQuery::frames(uint64_t fromNs, uint64_t toNs, const std::string& channelFilter,
+                          const std::function<bool(uint64_t, std::string_view)>& visitor) {
+    std::size_t firstSegment = segmentFor(fromNs);
+    if (firstSegment == segmentStarts.size()) {
+        firstSegment = 0;
+    }
+
+    for (std::size_t segment = firstSegment; segment < segmentStarts.size(); ++segment) {
+        if (segmentStarts[segment] > toNs) break;
+
+        bool keepGoing = reader(segment).forEachFrame(fromNs, toNs, [&](uint64_t ts, std::string_view frame) {
+            if (!channelFilter.empty() &&
+                captureFrameChannel(frame).find(channelFilter) == std::string_view::npos) {
+                return true;
+            }
+            return visitor(ts, frame);
+        });
+        if (!keepGoing) break;
+    }
+}
+
+void CaptureQuery::scanInstrument(const std::string& instrument, uint32_t channelBits,
+                                  const std::vector<std::string>& channels,
+                                  std::size_t firstSegment, std::size_t firstBlock,
+                                  uint64_t fromNs, uint64_t toNs,
+                                  const std::function<bool(uint64_t, std::string_view)>& visitor) {
+    std::string raw;
+    for (std::size_t segment = firstSegment; segment < segmentStarts.size(); ++segment) {
+        if (segmentStarts[segment] > toNs) return;
+
+        CaptureReader& segmentReader = reader(segment);
+        for (const auto& entry : segmentReader.instrumentBlocks(instrument)) {
+            if (segment == firstSegment && entry.block < firstBlock) continue;
+            if (!(entry.channels & channelBits)) continue;
+
+            const auto& block = segmentReader.block(entry.block);
+            if (block.lastTimestampNs < fromNs) continue;
+            if (block.firstTimestampNs > toNs) return;
+
+            segmentReader.readBlock(entry.block, raw);
+            bool pastEnd = false;
+            bool keepGoing = CaptureReader::forEachFrameInBlock(raw, [&](uint64_t ts, std::string_view frame) {
+                if (ts < fromNs) return true;
+                if (ts > toNs) {
+                    pastEnd = true;
+                    return false;
+                }
+                std::string_view channel = captureFrameChannel(frame);
+                if (std::find(channels.begin(), channels.end(), channel) == channels.end()) return true;
+                return visitor(ts, frame);
+            });
+            if (pastEnd || !keepGoing) return;
+        }
+    }
+}
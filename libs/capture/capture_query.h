@@ -0,0 +1,125 @@
+#ifndef CAPTURE_QUERY_H
+#define CAPTURE_QUERY_H
+
+#include "capture_reader.h"
+#include "order_book.h"
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+using json = nlohmann::json;
+
+/**
+ * @brief Answers market data queries over a directory of capture segments
+ *
+ * Segments are opened lazily and located by their start time; within a
+ * segment the time and instrument indexes select the blocks to decode, so a
+ * query touches only the blocks that can contain its answer and results are
+ * streamed to a visitor one frame at a time.
+ */
+class CaptureQuery {
+public:
+    /**
+     * @brief Construct a new CaptureQuery object
+     *
+     * @param directory Directory written by a CaptureWriter
+     */
+    explicit CaptureQuery(const std::string& directory);
+
+    /**
+     * @brief Get the number of segments found
+     */
+    std::size_t segmentCount() const { return segmentPaths.size(); }
+
+    /**
+     * @brief Get the path of a segment
+     *
+     * @param segment The segment number, in time order
+     */
+    const std::string& segmentPath(std::size_t segment) const { return segmentPaths[segment]; }
+
+    /**
+     * @brief Get the timestamp of the first recorded frame (0 if empty)
+     */
+    uint64_t firstTimestamp() const { return segmentStarts.empty() ? 0 : segmentStarts.front(); }
+
+    /**
+     * @brief Open (or reuse) the reader for a segment
+     *
+     * @param segment The segment number, in time order
+     * @return CaptureReader& The reader
+     */
+    CaptureReader& reader(std::size_t segment);
+
+    /**
+     * @brief Rebuild the order book of an instrument as it was at a timestamp
+     *
+     * Starts from the nearest book snapshot at or before the timestamp and
+     * applies the recorded changes up to it.
+     *
+     * @param instrument The instrument name
+     * @param timestampNs The timestamp in nanoseconds since epoch
+     * @param book Receives the rebuilt book
+     * @return true if a consistent book was rebuilt
+     */
+    bool bookAt(const std::string& instrument, uint64_t timestampNs, OrderBook& book);
+
+    /**
+     * @brief Stream the trades of an instrument recorded in a time range
+     *
+     * @param instrument The instrument name
+     * @param fromNs Inclusive lower bound
+     * @param toNs Inclusive upper bound
+     * @param visitor Called per trade with its receive time; return false to stop
+     */
+    void trades(const std::string& instrument, uint64_t fromNs, uint64_t toNs,
+                const std::function<bool(uint64_t, const json&)>& visitor);
+
+    /**
+     * @brief Stream raw frames in a time range
+     *
+     * @param fromNs Inclusive lower bound
+     * @param toNs Inclusive upper bound
+     * @param channelFilter Only frames whose channel contains this text (empty for all)
+     * @param visitor Called per frame; return false to stop
+     */
+    void frames(uint64_t fromNs, uint64_t toNs, const std::string& channelFilter,
+                const std::function<bool(uint64_t, std::string_view)>& visitor);
+
+private:
+    /**
+     * @brief Visit the frames of one instrument's channel, block by block
+     *
+     * @param instrument The instrument name
+     * @param channelBits CAPTURE_CHANNEL_* bits a block must have
+     * @param channels Channels a frame must match exactly
+     * @param firstSegment Segment to start in
+     * @param firstBlock Block to start at within firstSegment
+     * @param fromNs Inclusive lower bound
+     * @param toNs Inclusive upper bound
+     * @param visitor Called per matching frame; return false to stop
+     */
+    void scanInstrument(const std::string& instrument, uint32_t channelBits,
+                        const std::vector<std::string>& channels,
+                        std::size_t firstSegment, std::size_t firstBlock,
+                        uint64_t fromNs, uint64_t toNs,
+                        const std::function<bool(uint64_t, std::string_view)>& visitor);
+
+    /**
+     * @brief Find the last segment starting at or before a timestamp
+     *
+     * @param timestampNs The timestamp
+     * @return std::size_t Segment number, or segmentCount() if none
+     */
+    std::size_t segmentFor(uint64_t timestampNs) const;
+
+    std::string directory; /**< Capture directory */
+    std::vector<std::string> segmentPaths; /**< Segment files, in time order */
+    std::vector<uint64_t> segmentStarts; /**< First frame timestamp per segment */
+    std::vector<std::unique_ptr<CaptureReader>> readers; /**< Lazily opened readers */
+};
+
+#endif // CAPTURE_QUERY_H
@@ -0,0 +1,197 @@
+#include "capture_reader.h"
+#include <zlib.h>
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <unordered_map>
+
+CaptureReader::CaptureReader(const std::string& segmentPath, const std::string& dictionaryDirectory)
+    : path(segmentPath) {
+    // Map the index before the segment: the writer appends an index entry only
+    // after its block is on disk, so every mapped entry has its block mapped too.
+    try {
+        timeIndex = MappedFile(segmentPath + ".idx");
+        segment = MappedFile(segmentPath);
+    } catch (const std::runtime_error& e) {
+        throw Exception(e.what());
+    }
+
+    if (std::filesystem::exists(segmentPath + ".iidx")) {
+        instrumentIndex = MappedFile(segmentPath + ".iidx");
+    }
+
+    if (segment.size() < sizeof(segmentHeader)) {
+        throw Exception("Not a capture segment: " + segmentPath);
+    }
+    std::memcpy(&segmentHeader, segment.data(), sizeof(segmentHeader));
+    if (segmentHeader.magic != CAPTURE_SEGMENT_MAGIC) {
+        throw Exception("Not a capture segment: " + segmentPath);
+    }
+    if (segmentHeader.version != CAPTURE_FORMAT_VERSION) {
+        throw Exception("Unsupported capture version " + std::to_string(segmentHeader.version));
+    }
+
+    blocks = timeIndex.as<CaptureIndexEntry>();
+    blockTotal = timeIndex.count<CaptureIndexEntry>();
+    while (blockTotal > 0) {
+        const auto& last = blocks[blockTotal - 1];
+        if (last.offset + sizeof(CaptureBlockHeader) + last.compressedSize <= segment.size()) break;
+        --blockTotal;
+    }
+
+    if (segmentHeader.dictionaryId != 0) {
+        std::filesystem::path directory = dictionaryDirectory.empty()
+            ? std::filesystem::path(segmentPath).parent_path()
+            : std::filesystem::path(dictionaryDirectory);
+        dictionary = CaptureDictionary::load(
+            (directory / CaptureDictionary::fileName(segmentHeader.dictionaryId)).string());
+    }
+
+    inflater = new z_stream{};
+    if (inflateInit2(inflater, -15) != Z_OK) {
+        delete inflater;
+        inflater = nullptr;
+        throw Exception("Failed to initialise inflate stream");
+    }
+}
+
+CaptureReader::~CaptureReader() {
+    if (inflater) {
+        inflateEnd(inflater);
+        delete inflater;
+    }
+}
+
+std::size_t CaptureReader::findBlock(uint64_t timestampNs) const {
+    // Blocks are written in time order, so the last timestamps are sorted too
+    auto it = std::lower_bound(blocks, blocks + blockTotal, timestampNs,
+                               [](const CaptureIndexEntry& entry, uint64_t ts) {
+                                   return entry.lastTimestampNs < ts;
+                               });
+    return static_cast<std::size_t>(it - blocks);
+}
+
+std::vector<CaptureInstrumentEntry> CaptureReader::instrumentBlocks(const std::string& instrument) {
+    const CaptureInstrumentEntry* begin;
+    const CaptureInstrumentEntry* end;
+
+    if (instrumentIndex.size() > 0) {
+        begin = instrumentIndex.as<CaptureInstrumentEntry>();
+        end = begin + instrumentIndex.count<CaptureInstrumentEntry>();
+    } else {
+        if (!instrumentsScanned) {
+            scanInstruments();
+        }
+        begin = scannedInstruments.data();
+        end = begin + scannedInstruments.size();
+    }
+
+    uint64_t hash = captureInstrumentHash(instrument);
+    auto range = std::equal_range(begin, end, CaptureInstrumentEntry{hash, 0, 0},
+                                  [](const CaptureInstrumentEntry& a, const CaptureInstrumentEntry& b) {
+                                      return a.instrumentHash < b.instrumentHash;
+                                  });
+
+    std::vector<CaptureInstrumentEntry> result(range.first, range.second);
+    result.erase(std::remove_if(result.begin(), result.end(),
+                                [this](const CaptureInstrumentEntry& entry) { return entry.block >= blockTotal; }),
+                 result.end());
+    return result;
+}
+
+void CaptureReader::scanInstruments() {
+    std::string raw;
+    for (std::size_t block = 0; block < blockTotal; ++block) {
+        std::unordered_map<uint64_t, uint32_t> channels;
+        readBlock(block, raw);
+        forEachFrameInBlock(raw, [&](uint64_t, std::string_view frame) {
+            std::string_view instrument;
+            uint32_t bits = captureClassifyFrame(frame, instrument);
+            if (bits != 0) {
+                channels[captureInstrumentHash(instrument)] |= bits;
+            }
+            return true;
+        });
+        for (const auto& entry : channels) {
+            scannedInstruments.push_back({entry.first, static_cast<uint32_t>(block), entry.second});
+        }
+    }
+
+    std::sort(scannedInstruments.begin(), scannedInstruments.end(),
+              [](const CaptureInstrumentEntry& a, const CaptureInstrumentEntry& b) {
+                  return a.instrumentHash != b.instrumentHash
+                      ? a.instrumentHash < b.instrumentHash
+                      : a.block < b.block;
+              });
+    instrumentsScanned = true;
+}
+
+void CaptureReader::readBlock(std::size_t blockNumber, std::string& raw) {
+    if (blockNumber >= blockTotal) {
+        throw Exception("Block " + std::to_string(blockNumber) + " out of range");
+    }
+    const auto& entry = blocks[blockNumber];
+
+    CaptureBlockHeader header;
+    std::memcpy(&header, segment.data() + entry.offset, sizeof(header));
+    if (header.magic != CAPTURE_BLOCK_MAGIC || header.compressedSize != entry.compressedSize) {
+        throw Exception("Corrupt block " + std::to_string(blockNumber) + " in " + path);
+    }
+
+    // Inflate straight out of the mapping; only the raw block is materialised
+    raw.resize(header.rawSize);
+    inflateReset(inflater);
+    if (!dictionary.empty()) {
+        inflateSetDictionary(inflater,
+                             reinterpret_cast<const Bytef*>(dictionary.bytes().data()),
+                             static_cast<uInt>(dictionary.size()));
+    }
+    inflater->next_in = reinterpret_cast<Bytef*>(const_cast<char*>(segment.data() + entry.offset + sizeof(header)));
+    inflater->avail_in = header.compressedSize;
+    inflater->next_out = reinterpret_cast<Bytef*>(&raw[0]);
+    inflater->avail_out = static_cast<uInt>(raw.size());
+    int result = inflate(inflater, Z_FINISH);
+    if (result != Z_STREAM_END || inflater->avail_out != 0) {
+        throw Exception("Failed to decompress block " + std::to_string(blockNumber) + " in " + path);
+    }
+}
+
+bool CaptureReader::forEachFrame(uint64_t fromNs, uint64_t toNs,
+                                 const std::function<bool(uint64_t, std::string_view)>& visitor) {
+    std::string raw;
+    for (std::size_t block = findBlock(fromNs); block < blockTotal; ++block) {
+        if (blocks[block].firstTimestampNs > toNs) break;
+
+        readBlock(block, raw);
+        bool pastEnd = false;
+        bool keepGoing = forEachFrameInBlock(raw, [&](uint64_t ts, std::string_view frame) {
+            if (ts < fromNs) return true;
+            if (ts > toNs) {
+                pastEnd = true;
+                return false;
+            }
+            return visitor(ts, frame);
+        });
+        if (pastEnd) return true;
+        if (!keepGoing) return false;
+    }
+    return true;
+}
+
+bool CaptureReader::forEachFrameInBlock(std::string_view raw,
+                                        const std::function<bool(uint64_t, std::string_view)>& visitor) {
+    std::size_t offset = 0;
+    while (offset + sizeof(CaptureFrameHeader) <= raw.size()) {
+        CaptureFrameHeader header;
+        std::memcpy(&header, raw.data() + offset, sizeof(header));
+        offset += sizeof(header);
+        if (offset + header.length > raw.size()) {
+            throw Exception("Frame overruns its block");
+        }
+        if (!visitor(header.timestampNs, raw.substr(offset, header.length))) {
+            return false;
+        }
+        offset += header.length;
+    }
+    return true;
+}
@@ -0,0 +1,134 @@
+#ifndef CAPTURE_READER_H
+#define CAPTURE_READER_H
+
+#include "capture_format.h"
+#include "capture_dictionary.h"
+#include "mapped_file.h"
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+struct z_stream_s;
+
+/**
+ * @brief Reads a capture segment with random access by time and instrument
+ *
+ * The segment and its indexes are memory-mapped; blocks are decompressed one
+ * at a time on demand, so memory use is bounded by the block size rather than
+ * the file.
+ */
+class CaptureReader {
+public:
+    /**
+     * @brief Open a capture segment
+     *
+     * @param segmentPath Path of the .dcap file
+     * @param dictionaryDirectory Directory holding dict-<id>.zdict files
+     *        (defaults to the segment's directory)
+     */
+    explicit CaptureReader(const std::string& segmentPath,
+                           const std::string& dictionaryDirectory = "");
+
+    /**
+     * @brief Destroy the CaptureReader object
+     */
+    ~CaptureReader();
+
+    /**
+     * @brief Get the segment header
+     */
+    const CaptureSegmentHeader& header() const { return segmentHeader; }
+
+    /**
+     * @brief Get the number of blocks in the time index
+     */
+    std::size_t blockCount() const { return blockTotal; }
+
+    /**
+     * @brief Get a time index entry
+     *
+     * @param blockNumber The block number
+     */
+    const CaptureIndexEntry& block(std::size_t blockNumber) const { return blocks[blockNumber]; }
+
+    /**
+     * @brief Find the first block that may hold frames at or after a timestamp
+     *
+     * @param timestampNs The timestamp in nanoseconds since epoch
+     * @return std::size_t Block number, or blockCount() if none
+     */
+    std::size_t findBlock(uint64_t timestampNs) const;
+
+    /**
+     * @brief Get the blocks holding frames for an instrument, in block order
+     *
+     * Uses the segment's instrument index when present; segments still being
+     * written have none yet, and are indexed by scanning them once.
+     *
+     * @param instrument The instrument name
+     * @return std::vector<CaptureInstrumentEntry> Matching entries
+     */
+    std::vector<CaptureInstrumentEntry> instrumentBlocks(const std::string& instrument);
+
+    /**
+     * @brief Decompress a block
+     *
+     * @param blockNumber The block number
+     * @param raw Receives the decompressed frames
+     */
+    void readBlock(std::size_t blockNumber, std::string& raw);
+
+    /**
+     * @brief Visit frames in a time range
+     *
+     * @param fromNs Inclusive lower bound
+     * @param toNs Inclusive upper bound
+     * @param visitor Called per frame; return false to stop
+     * @return false if the visitor stopped early
+     */
+    bool forEachFrame(uint64_t fromNs, uint64_t toNs,
+                      const std::function<bool(uint64_t, std::string_view)>& visitor);
+
+    /**
+     * @brief Visit every frame of a decompressed block
+     *
+     * @param raw The decompressed block
+     * @param visitor Called per frame; return false to stop
+     * @return false if the visitor stopped early
+     */
+    static bool forEachFrameInBlock(std::string_view raw,
+                                    const std::function<bool(uint64_t, std::string_view)>& visitor);
+
+    /**
+     * @brief Exception class for malformed captures
+     */
+    class Exception : public std::runtime_error {
+    public:
+        explicit Exception(const std::string& message) : std::runtime_error(message) {}
+    };
+
+private:
+    /**
+     * @brief Build the instrument index of a segment without one by scanning it
+     */
+    void scanInstruments();
+
+    std::string path; /**< Path of the segment */
+    MappedFile segment; /**< Mapped segment file */
+    MappedFile timeIndex; /**< Mapped .idx file */
+    MappedFile instrumentIndex; /**< Mapped .iidx file, empty if not written yet */
+    CaptureSegmentHeader segmentHeader{}; /**< Segment header */
+    const CaptureIndexEntry* blocks = nullptr; /**< Time index entries */
+    std::size_t blockTotal = 0; /**< Number of complete blocks */
+    std::vector<CaptureInstrumentEntry> scannedInstruments; /**< Instrument index built by scanning */
+    bool instrumentsScanned = false; /**< True once scannedInstruments is built */
+    CaptureDictionary dictionary; /**< Dictionary used by the segment */
+    z_stream_s* inflater = nullptr; /**< Reused inflate stream */
+
+    // Prevent copying
+    CaptureReader(const CaptureReader&) = delete;
+    CaptureReader& operator=(const CaptureReader&) = delete;
+};
+
+#endif // CAPTURE_READER_H
@@ -0,0 +1,365 @@
+#include "capture_writer.h"
+#include <zlib.h>
+#include <algorithm>
+#include <filesystem>
+#include <iostream>
+
+CaptureWriter::CaptureWriter(CaptureConfig cfg)
+    : config(std::move(cfg))
+    , running(false) {
+    if (config.directory.empty()) {
+        throw std::invalid_argument("Capture directory must not be empty");
+    }
+    std::filesystem::create_directories(config.directory);
+
+    // Raw deflate (negative window bits): the block header already carries
+    // sizes, so the zlib wrapper would only add bytes to every block.
+    deflater = new z_stream{};
+    if (deflateInit2(deflater, config.compressionLevel, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+        delete deflater;
+        throw std::runtime_error("Failed to initialise deflate stream");
+    }
+
+    if (!config.dictionaryPath.empty()) {
+        dictionary = CaptureDictionary::load(config.dictionaryPath);
+
+        // Readers look dictionaries up by id next to the segments
+        auto target = std::filesystem::path(config.directory) / CaptureDictionary::fileName(dictionary.id());
+        if (!std::filesystem::exists(target)) {
+            dictionary.save(target.string());
+        }
+    } else {
+        training = true;
+    }
+
+    running = true;
+    writerThread = std::thread(&CaptureWriter::processFrames, this);
+}
+
+CaptureWriter::~CaptureWriter() {
+    stop();
+    deflateEnd(deflater);
+    delete deflater;
+}
+
+uint64_t CaptureWriter::nowNs() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count());
+}
+
+void CaptureWriter::record(const std::string& frame) {
+    record(nowNs(), frame);
+}
+
+void CaptureWriter::record(uint64_t timestampNs, const std::string& frame) {
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        if (!running) return;
+        if (queuedBytes + frame.size() > config.maxQueuedBytes) {
+            // Reported once per stall, not once per frame
+            if (!dropping) {
+                std::cerr << "Capture writer behind, dropping frames" << std::endl;
+                dropping = true;
+            }
+            ++droppedFrames;
+            return;
+        }
+        dropping = false;
+        queuedBytes += frame.size();
+        queue.push_back({timestampNs, frame});
+    }
+    queueCV.notify_one();
+}
+
+void CaptureWriter::stop() {
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        running = false;
+    }
+    queueCV.notify_one();
+    if (writerThread.joinable()) {
+        writerThread.join();
+    }
+}
+
+CaptureStats CaptureWriter::stats() const {
+    CaptureStats snapshot;
+    {
+        std::lock_guard<std::mutex> lock(statsMutex);
+        snapshot = counters;
+    }
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        snapshot.pendingFrames = queue.size();
+        snapshot.droppedFrames = droppedFrames;
+    }
+    return snapshot;
+}
+
+void CaptureWriter::processFrames() {
+    std::vector<PendingFrame> batch;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(queueMutex);
+            queueCV.wait_for(lock, config.blockInterval, [this]
+                             { return !queue.empty() || !running; });
+
+            if (!running && queue.empty()) {
+                break;
+            }
+            batch.swap(queue);
+            queuedBytes = 0;
+        }
+
+        try {
+            writeFrames(batch);
+
+            // A quiet feed still gets its first segment within trainingInterval
+            if (training && !trainingFrames.empty() &&
+                std::chrono::steady_clock::now() - trainingStarted >= config.trainingInterval) {
+                finishTraining();
+            }
+
+            // Close out an idle block so readers see recent data within one interval
+            auto interval = static_cast<uint64_t>(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(config.blockInterval).count());
+            if (!training && blockFrames > 0 && nowNs() - blockFirstNs >= interval) {
+                flushBlock();
+            }
+        } catch (const std::exception& e) {
+            std::cerr << "Capture write failed: " << e.what() << std::endl;
+        }
+        batch.clear();
+    }
+
+    try {
+        if (training) {
+            finishTraining();
+        }
+        if (blockFrames > 0) {
+            flushBlock();
+        }
+        closeSegment();
+    } catch (const std::exception& e) {
+        std::cerr << "Capture shutdown failed: " << e.what() << std::endl;
+    }
+}
+
+void CaptureWriter::writeFrames(std::vector<PendingFrame>& frames) {
+    for (auto& frame : frames) {
+        if (training) {
+            if (trainingFrames.empty()) {
+                trainingStarted = std::chrono::steady_clock::now();
+            }
+            trainingSize += frame.data.size();
+            trainingFrames.push_back(std::move(frame));
+            if (trainingSize >= config.trainingBytes ||
+                std::chrono::steady_clock::now() - trainingStarted >= config.trainingInterval) {
+                finishTraining();
+            }
+        } else {
+            appendFrame(frame);
+        }
+    }
+}
+
+void CaptureWriter::finishTraining() {
+    std::vector<std::string> samples;
+    samples.reserve(trainingFrames.size());
+    for (const auto& frame : trainingFrames) {
+        samples.push_back(frame.data);
+    }
+
+    dictionary = CaptureDictionary::train(samples, config.dictionaryBytes);
+    if (!dictionary.empty()) {
+        auto path = std::filesystem::path(config.directory) / CaptureDictionary::fileName(dictionary.id());
+        dictionary.save(path.string());
+        std::cout << "Capture dictionary trained: " << dictionary.size() << " bytes from "
+                  << samples.size() << " frames (id " << dictionary.id() << ")" << std::endl;
+    } else {
+        std::cout << "Capture dictionary training skipped, compressing without dictionary" << std::endl;
+    }
+
+    training = false;
+    for (const auto& frame : trainingFrames) {
+        appendFrame(frame);
+    }
+    trainingFrames.clear();
+    trainingFrames.shrink_to_fit();
+    trainingSize = 0;
+}
+
+void CaptureWriter::appendFrame(const PendingFrame& frame) {
+    // Frames are stamped by the producing threads, so keep the file monotonic
+    // for the time index even if two producers race.
+    uint64_t timestampNs = std::max(frame.timestampNs, blockLastNs);
+
+    auto interval = static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(config.blockInterval).count());
+    if (blockFrames > 0 && timestampNs - blockFirstNs >= interval) {
+        flushBlock();
+    }
+
+    if (!segmentFile.is_open()) {
+        openSegment(timestampNs);
+    }
+
+    if (blockFrames == 0) {
+        blockFirstNs = timestampNs;
+    }
+
+    CaptureFrameHeader header{timestampNs, static_cast<uint32_t>(frame.data.size())};
+    block.append(reinterpret_cast<const char*>(&header), sizeof(header));
+    block.append(frame.data);
+    blockLastNs = timestampNs;
+    ++blockFrames;
+    indexFrame(frame.data);
+
+    if (block.size() >= config.blockBytes) {
+        flushBlock();
+    }
+}
+
+void CaptureWriter::indexFrame(const std::string& frame) {
+    std::string_view instrument;
+    uint32_t bits = captureClassifyFrame(frame, instrument);
+    if (bits != 0) {
+        blockChannels[captureInstrumentHash(instrument)] |= bits;
+    }
+}
+
+void CaptureWriter::flushBlock() {
+    if (blockFrames == 0) return;
+
+    auto start = std::chrono::steady_clock::now();
+
+    // Every block is its own deflate stream primed with the dictionary, so a
+    // reader can decode any block without touching the ones before it.
+    deflateReset(deflater);
+    if (!dictionary.empty()) {
+        deflateSetDictionary(deflater,
+                             reinterpret_cast<const Bytef*>(dictionary.bytes().data()),
+                             static_cast<uInt>(dictionary.size()));
+    }
+
+    compressed.resize(deflateBound(deflater, static_cast<uLong>(block.size())));
+    deflater->next_in = reinterpret_cast<Bytef*>(&block[0]);
+    deflater->avail_in = static_cast<uInt>(block.size());
+    deflater->next_out = reinterpret_cast<Bytef*>(&compressed[0]);
+    deflater->avail_out = static_cast<uInt>(compressed.size());
+    int result = deflate(deflater, Z_FINISH);
+    std::size_t size = compressed.size() - deflater->avail_out;
+    auto elapsed = std::chrono::steady_clock::now() - start;
+
+    if (result != Z_STREAM_END) {
+        block.clear();
+        blockFrames = 0;
+        blockChannels.clear();
+        throw std::runtime_error("Block compression failed: " + std::to_string(result));
+    }
+
+    CaptureBlockHeader header{
+        CAPTURE_BLOCK_MAGIC,
+        static_cast<uint32_t>(size),
+        static_cast<uint32_t>(block.size()),
+        blockFrames,
+        blockFirstNs,
+        blockLastNs};
+
+    CaptureIndexEntry entry{
+        blockFirstNs,
+        blockLastNs,
+        segmentOffset,
+        static_cast<uint32_t>(size),
+        static_cast<uint32_t>(block.size()),
+        blockFrames,
+        0};
+
+    segmentFile.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    segmentFile.write(compressed.data(), static_cast<std::streamsize>(size));
+    segmentFile.flush();
+
+    // The index entry is written only once its block is on disk, so a reader
+    // never follows an entry into a partially written block.
+    indexFile.write(reinterpret_cast<const char*>(&entry), sizeof(entry));
+    indexFile.flush();
+
+    segmentOffset += sizeof(header) + size;
+
+    {
+        std::lock_guard<std::mutex> lock(statsMutex);
+        counters.frames += blockFrames;
+        counters.rawBytes += block.size() - blockFrames * sizeof(CaptureFrameHeader);
+        counters.compressedBytes += sizeof(header) + size;
+        counters.blocks += 1;
+        counters.compressNs += static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+    }
+
+    for (const auto& channels : blockChannels) {
+        instrumentEntries.push_back({channels.first, segmentBlocks, channels.second});
+    }
+    blockChannels.clear();
+    ++segmentBlocks;
+
+    block.clear();
+    blockFrames = 0;
+
+    if (segmentOffset >= config.segmentBytes) {
+        closeSegment();
+    }
+}
+
+void CaptureWriter::openSegment(uint64_t timestampNs) {
+    auto path = std::filesystem::path(config.directory) /
+                ("capture-" + std::to_string(timestampNs) + ".dcap");
+    segmentPath = path.string();
+
+    segmentFile.open(path, std::ios::binary | std::ios::trunc);
+    indexFile.open(path.string() + ".idx", std::ios::binary | std::ios::trunc);
+    if (!segmentFile.is_open() || !indexFile.is_open()) {
+        segmentFile.close();
+        indexFile.close();
+        throw std::runtime_error("Failed to open capture segment " + path.string());
+    }
+
+    CaptureSegmentHeader header{
+        CAPTURE_SEGMENT_MAGIC,
+        CAPTURE_FORMAT_VERSION,
+        0,
+        dictionary.id(),
+        0,
+        nowNs()};
+    segmentFile.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    segmentOffset = sizeof(header);
+    segmentBlocks = 0;
+
+    std::lock_guard<std::mutex> lock(statsMutex);
+    counters.segments += 1;
+}
+
+void CaptureWriter::closeSegment() {
+    if (!segmentFile.is_open()) return;
+
+    segmentFile.close();
+    indexFile.close();
+
+    // Sorted by instrument so a reader can binary-search one instrument's blocks
+    std::sort(instrumentEntries.begin(), instrumentEntries.end(),
+              [](const CaptureInstrumentEntry& a, const CaptureInstrumentEntry& b) {
+                  return a.instrumentHash != b.instrumentHash
+                      ? a.instrumentHash < b.instrumentHash
+                      : a.block < b.block;
+              });
+
+    std::ofstream instrumentFile(segmentPath + ".iidx", std::ios::binary | std::ios::trunc);
+    instrumentFile.write(reinterpret_cast<const char*>(instrumentEntries.data()),
+                         static_cast<std::streamsize>(instrumentEntries.size() * sizeof(CaptureInstrumentEntry)));
+    if (!instrumentFile) {
+        std::cerr << "Failed to write instrument index for " << segmentPath << std::endl;
+    }
+
+    instrumentEntries.clear();
+    segmentOffset = 0;
+    segmentBlocks = 0;
+}
@@ -0,0 +1,202 @@
+#ifndef CAPTURE_WRITER_H
+#define CAPTURE_WRITER_H
+
+#include "capture_format.h"
+#include "capture_dictionary.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+struct z_stream_s;
+
+/**
+ * @brief Configuration for a CaptureWriter
+ */
+struct CaptureConfig {
+    std::string directory; /**< Directory receiving segments, indexes and dictionaries */
+    std::string dictionaryPath; /**< Existing dictionary to use; trained from traffic if empty */
+    std::size_t blockBytes = 256 * 1024; /**< Raw bytes per block before it is compressed */
+    std::chrono::milliseconds blockInterval{1000}; /**< Maximum time span of one block */
+    std::size_t segmentBytes = 256 * 1024 * 1024; /**< Compressed bytes per segment before rotating */
+    int compressionLevel = 4; /**< deflate compression level */
+    std::size_t dictionaryBytes = CaptureDictionary::MAX_SIZE; /**< Capacity of a trained dictionary */
+    std::size_t trainingBytes = 4 * 1024 * 1024; /**< Traffic held back to train the dictionary */
+    std::chrono::milliseconds trainingInterval{30000}; /**< Longest time traffic is held back for training */
+    std::size_t maxQueuedBytes = 64 * 1024 * 1024; /**< Frame bytes waiting for the writer thread before frames are dropped */
+};
+
+/**
+ * @brief Counters describing the writer's progress
+ */
+struct CaptureStats {
+    uint64_t frames = 0; /**< Frames written */
+    uint64_t rawBytes = 0; /**< Frame bytes written before compression */
+    uint64_t compressedBytes = 0; /**< Compressed block bytes written */
+    uint64_t blocks = 0; /**< Blocks written */
+    uint64_t segments = 0; /**< Segments opened */
+    uint64_t compressNs = 0; /**< Time spent compressing */
+    uint64_t pendingFrames = 0; /**< Frames queued for the writer thread */
+    uint64_t droppedFrames = 0; /**< Frames dropped because the queue was full */
+};
+
+/**
+ * @brief Records raw Deribit frames into dictionary-compressed capture segments
+ *
+ * record() only appends to an in-memory queue; a dedicated writer thread
+ * batches frames into blocks, compresses each block with the shared dictionary
+ * and appends a fixed-size entry to the segment's time index. The queue is
+ * bounded by maxQueuedBytes: a writer that falls behind loses frames, counted
+ * in droppedFrames, rather than the process growing without limit.
+ */
+class CaptureWriter {
+public:
+    /**
+     * @brief Construct a new CaptureWriter object and start the writer thread
+     *
+     * @param config Writer configuration
+     */
+    explicit CaptureWriter(CaptureConfig config);
+
+    /**
+     * @brief Destroy the CaptureWriter object, flushing any pending frames
+     */
+    ~CaptureWriter();
+
+    /**
+     * @brief Record a frame stamped with the current wall-clock time
+     *
+     * The frame is dropped if the queue is full.
+     *
+     * @param frame The raw frame
+     */
+    void record(const std::string& frame);
+
+    /**
+     * @brief Record a frame with an explicit timestamp
+     *
+     * @param timestampNs Receive time in nanoseconds since epoch
+     * @param frame The raw frame
+     */
+    void record(uint64_t timestampNs, const std::string& frame);
+
+    /**
+     * @brief Flush pending frames and stop the writer thread
+     */
+    void stop();
+
+    /**
+     * @brief Get a snapshot of the writer counters
+     *
+     * @return CaptureStats The counters
+     */
+    CaptureStats stats() const;
+
+    /**
+     * @brief Get the current wall-clock time in nanoseconds since epoch
+     */
+    static uint64_t nowNs();
+
+private:
+    /**
+     * @brief Frame waiting to be written
+     */
+    struct PendingFrame {
+        uint64_t timestampNs; /**< Receive time */
+        std::string data; /**< Raw frame */
+    };
+
+    /**
+     * @brief Thread worker function draining the queue
+     */
+    void processFrames();
+
+    /**
+     * @brief Write frames, training the dictionary first if needed
+     *
+     * @param frames The frames to write
+     */
+    void writeFrames(std::vector<PendingFrame>& frames);
+
+    /**
+     * @brief Append a frame to the current block
+     *
+     * @param frame The frame to append
+     */
+    void appendFrame(const PendingFrame& frame);
+
+    /**
+     * @brief Train the dictionary from held-back frames and write them out
+     */
+    void finishTraining();
+
+    /**
+     * @brief Note which instrument and channel kind a frame belongs to
+     *
+     * @param frame The raw frame
+     */
+    void indexFrame(const std::string& frame);
+
+    /**
+     * @brief Compress the current block and append it to the segment
+     */
+    void flushBlock();
+
+    /**
+     * @brief Open a new segment starting at a timestamp
+     *
+     * @param timestampNs Timestamp of the first frame in the segment
+     */
+    void openSegment(uint64_t timestampNs);
+
+    /**
+     * @brief Close the current segment and write its instrument index
+     */
+    void closeSegment();
+
+    CaptureConfig config; /**< Writer configuration */
+    CaptureDictionary dictionary; /**< Dictionary shared by all blocks */
+    z_stream_s* deflater = nullptr; /**< Reused deflate stream */
+    bool training = false; /**< True while frames are held back for training */
+    std::vector<PendingFrame> trainingFrames; /**< Frames held back for training */
+    std::size_t trainingSize = 0; /**< Bytes held back for training */
+    std::chrono::steady_clock::time_point trainingStarted; /**< When the first frame was held back for training */
+
+    std::ofstream segmentFile; /**< Current segment file */
+    std::ofstream indexFile; /**< Current segment index file */
+    std::string segmentPath; /**< Path of the current segment */
+    uint64_t segmentOffset = 0; /**< Write offset in the current segment */
+    uint32_t segmentBlocks = 0; /**< Blocks written to the current segment */
+    std::unordered_map<uint64_t, uint32_t> blockChannels; /**< Instrument hash -> channel bits in the current block */
+    std::vector<CaptureInstrumentEntry> instrumentEntries; /**< Instrument index of the current segment */
+
+    std::string block; /**< Raw bytes of the block being built */
+    std::string compressed; /**< Scratch buffer for the compressed block */
+    uint32_t blockFrames = 0; /**< Frames in the block being built */
+    uint64_t blockFirstNs = 0; /**< Timestamp of the first frame in the block */
+    uint64_t blockLastNs = 0; /**< Timestamp of the last frame in the block */
+
+    // Thread management
+    std::thread writerThread; /**< Writer thread */
+    std::vector<PendingFrame> queue; /**< Frames waiting for the writer thread */
+    std::size_t queuedBytes = 0; /**< Frame bytes in queue */
+    uint64_t droppedFrames = 0; /**< Frames dropped since the start; guarded by queueMutex */
+    bool dropping = false; /**< True while frames are being dropped; guarded by queueMutex */
+    mutable std::mutex queueMutex; /**< Mutex for synchronizing access to the queue */
+    std::condition_variable queueCV; /**< Condition variable for queue synchronization */
+    bool running; /**< Flag to indicate if the writer thread is running */
+
+    mutable std::mutex statsMutex; /**< Mutex for synchronizing access to stats */
+    CaptureStats counters; /**< Writer counters */
+
+    // Prevent copying
+    CaptureWriter(const CaptureWriter&) = delete;
+    CaptureWriter& operator=(const CaptureWriter&) = delete;
+};
+
+#endif // CAPTURE_WRITER_H
@@ -0,0 +1,60 @@
+#include "mapped_file.h"
+#include <fcntl.h>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+MappedFile::MappedFile(const std::string& path) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        throw std::runtime_error("Failed to open " + path);
+    }
+
+    struct stat info;
+    if (::fstat(fd, &info) != 0) {
+        ::close(fd);
+        throw std::runtime_error("Failed to stat " + path);
+    }
+
+    length = static_cast<std::size_t>(info.st_size);
+    if (length > 0) {
+        void* mapping = ::mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+        if (mapping == MAP_FAILED) {
+            ::close(fd);
+            throw std::runtime_error("Failed to map " + path);
+        }
+        address = static_cast<const char*>(mapping);
+    }
+    ::close(fd);
+}
+
+MappedFile::~MappedFile() {
+    unmap();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+    : address(other.address)
+    , length(other.length) {
+    other.address = nullptr;
+    other.length = 0;
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+    if (this != &other) {
+        unmap();
+        address = other.address;
+        length = other.length;
+        other.address = nullptr;
+        other.length = 0;
+    }
+    return *this;
+}
+
+void MappedFile::unmap() {
+    if (address) {
+        ::munmap(const_cast<char*>(address), length);
+        address = nullptr;
+        length = 0;
+    }
+}
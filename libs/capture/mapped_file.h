@@ -0,0 +1,74 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cstddef>
+#include <string>
+
+/**
+ * @brief Read-only memory mapping of a file
+ *
+ * Pages are faulted in on access, so large captures and their indexes can be
+ * searched without reading them into memory first.
+ */
+class MappedFile {
+public:
+    /**
+     * @brief Construct an unmapped MappedFile object
+     */
+    MappedFile() = default;
+
+    /**
+     * @brief Map a file read-only
+     *
+     * @param path Path of the file
+     * @throws std::runtime_error if the file cannot be opened or mapped
+     */
+    explicit MappedFile(const std::string& path);
+
+    /**
+     * @brief Unmap the file
+     */
+    ~MappedFile();
+
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+
+    /**
+     * @brief Get the start of the mapping (nullptr for empty files)
+     */
+    const char* data() const { return address; }
+
+    /**
+     * @brief Get the size of the mapping in bytes
+     */
+    std::size_t size() const { return length; }
+
+    /**
+     * @brief View the mapping as an array of fixed-size records
+     *
+     * @return const T* First record
+     */
+    template <typename T>
+    const T* as() const { return reinterpret_cast<const T*>(address); }
+
+    /**
+     * @brief Get the number of whole records of type T in the mapping
+     */
+    template <typename T>
+    std::size_t count() const { return length / sizeof(T); }
+
+private:
+    /**
+     * @brief Release the mapping
+     */
+    void unmap();
+
+    const char* address = nullptr; /**< Start of the mapping */
+    std::size_t length = 0; /**< Size of the mapping */
+
+    // Prevent copying
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+};
+
+#endif // MAPPED_FILE_H
@@ -0,0 +1,340 @@
+#include "execution_engine.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace {
+    constexpr unsigned MAX_CHILD_FAILURES = 3;
+
+    // Amounts within this share of a lot count as a whole lot, absorbing floating point error
+    constexpr double LOT_EPSILON = 1e-9;
+
+    double wholeLots(double amount, double lot) {
+        return std::floor(amount / lot + LOT_EPSILON) * lot;
+    }
+}
+
+ExecutionEngine::ExecutionEngine(OrderPlacement& orders, std::chrono::milliseconds sliceInterval)
+    : orders(orders), sliceInterval(std::max(sliceInterval, std::chrono::milliseconds(10))) {
+}
+
+ExecutionEngine::~ExecutionEngine() {
+    stop();
+}
+
+void ExecutionEngine::setFollow(std::function<void(const std::string&)> follow) {
+    std::lock_guard<std::mutex> lock(mutex);
+    this->follow = std::move(follow);
+}
+
+void ExecutionEngine::start() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (running) {
+        return;
+    }
+    running = true;
+    timerThread = std::thread(&ExecutionEngine::run, this);
+}
+
+void ExecutionEngine::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        running = false;
+    }
+    cv.notify_all();
+    if (timerThread.joinable()) {
+        timerThread.join();
+    }
+}
+
+ExecutionEngine::Algorithm ExecutionEngine::algorithmFromString(const std::string& name) {
+    if (name == "twap") {
+        return Algorithm::TWAP;
+    }
+    if (name == "vwap") {
+        return Algorithm::VWAP;
+    }
+    throw std::invalid_argument("Unknown algorithm '" + name + "'. Must be 'twap' or 'vwap'");
+}
+
+uint64_t ExecutionEngine::submit(const ParentSpec& spec) {
+    if (spec.instrument.empty()) {
+        throw std::invalid_argument("Parent order needs an instrument");
+    }
+    if (spec.side != "buy" && spec.side != "sell") {
+        throw std::invalid_argument("Invalid side. Must be 'buy' or 'sell'");
+    }
+    if (!(spec.lotSize > 0) || !(spec.amount >= spec.lotSize)) {
+        throw std::invalid_argument("Amount must be at least one lot, and the lot size positive");
+    }
+    if (spec.duration.count() <= 0) {
+        throw std::invalid_argument("Duration must be positive");
+    }
+    if (spec.algorithm == Algorithm::VWAP && !(spec.participation > 0 && spec.participation <= 1)) {
+        throw std::invalid_argument("Participation must be above 0 and at most 1");
+    }
+    if (spec.limitPrice < 0) {
+        throw std::invalid_argument("Limit price must not be negative");
+    }
+
+    uint64_t id;
+    bool newInstrument;
+    std::function<void(const std::string&)> subscribe;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        newInstrument = markets.find(spec.instrument) == markets.end();
+        const Market& market = markets[spec.instrument];
+
+        auto now = Clock::now();
+        id = nextId++;
+        Parent& parent = parents[id];
+        parent.id = id;
+        parent.spec = spec;
+        parent.startTime = now;
+        parent.endTime = now + spec.duration;
+        parent.volumeStart = market.volume;
+
+        // An idle wheel's clock stands still; bring it to now before scheduling against it
+        if (wheel.empty()) {
+            wheel.advance(now);
+        }
+        parent.timer = wheel.schedule(now, [this, id]() { slice(id, Clock::now()); });
+        subscribe = follow;
+    }
+    cv.notify_all();
+
+    if (newInstrument && subscribe) {
+        subscribe(spec.instrument);
+    }
+    return id;
+}
+
+bool ExecutionEngine::cancel(uint64_t id) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = parents.find(id);
+    if (it == parents.end() || it->second.state != State::Running) {
+        return false;
+    }
+    finish(it->second, State::Cancelled, "cancelled");
+    return true;
+}
+
+std::size_t ExecutionEngine::cancelAll(const std::string& reason) {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::size_t cancelled = 0;
+    for (auto& entry : parents) {
+        if (entry.second.state == State::Running) {
+            finish(entry.second, State::Cancelled, reason);
+            ++cancelled;
+        }
+    }
+    return cancelled;
+}
+
+void ExecutionEngine::onBook(const std::string& instrument, double bestBid, double bestAsk) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = markets.find(instrument);
+    if (it != markets.end()) {
+        it->second.bestBid = bestBid;
+        it->second.bestAsk = bestAsk;
+    }
+}
+
+void ExecutionEngine::onTrades(const std::string& instrument, double volume) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = markets.find(instrument);
+    if (it != markets.end()) {
+        it->second.volume += volume;
+    }
+}
+
+void ExecutionEngine::run() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (running) {
+        if (wheel.empty()) {
+            cv.wait(lock);
+        } else {
+            cv.wait_until(lock, wheel.nextTick());
+        }
+        if (!running) {
+            break;
+        }
+
+        wheel.advance(Clock::now());
+        if (outbox.empty()) {
+            continue;
+        }
+
+        // Order callbacks can run on this thread when a request fails at once, and they take the lock
+        std::vector<Child> sending;
+        sending.swap(outbox);
+        lock.unlock();
+        for (const Child& child : sending) {
+            send(child);
+        }
+        lock.lock();
+    }
+}
+
+void ExecutionEngine::slice(uint64_t id, Clock::time_point now) {
+    auto it = parents.find(id);
+    if (it == parents.end() || it->second.state != State::Running) {
+        return;
+    }
+    Parent& parent = it->second;
+    const ParentSpec& spec = parent.spec;
+    const Market& market = markets[spec.instrument];
+    parent.timer = 0;
+
+    double remaining = wholeLots(spec.amount - parent.filled, spec.lotSize);
+    if (remaining < spec.lotSize) {
+        finish(parent, State::Done, "filled");
+        return;
+    }
+
+    // TWAP gets one slice at its end time for the remainder; VWAP stops there
+    bool twap = spec.algorithm == Algorithm::TWAP;
+    if (now >= parent.endTime + (twap ? Clock::duration(sliceInterval) : Clock::duration::zero())) {
+        finish(parent, State::Expired, "end time reached");
+        return;
+    }
+
+    if (parent.working == 0) {
+        double target;
+        if (twap) {
+            double elapsed = std::chrono::duration<double>(now - parent.startTime).count();
+            double duration = std::chrono::duration<double>(spec.duration).count();
+            target = spec.amount * std::min(elapsed / duration, 1.0);
+        } else {
+            target = std::min(spec.amount, spec.participation * (market.volume - parent.volumeStart));
+        }
+
+        double amount = std::min(wholeLots(target - parent.filled, spec.lotSize), remaining);
+        bool buy = spec.side == "buy";
+        double price = buy ? market.bestAsk : market.bestBid;
+        bool withinLimit = spec.limitPrice == 0 || (buy ? price <= spec.limitPrice : price >= spec.limitPrice);
+        if (amount >= spec.lotSize && price > 0 && withinLimit) {
+            outbox.push_back(Child{id, spec.instrument, spec.side, amount, price});
+            parent.working = amount;
+            ++parent.children;
+        }
+    }
+
+    auto next = now + sliceInterval;
+    if (now < parent.endTime) {
+        next = std::min(next, parent.endTime);
+    }
+    parent.timer = wheel.schedule(next, [this, id]() { slice(id, Clock::now()); });
+}
+
+void ExecutionEngine::send(const Child& child) {
+    auto self = shared_from_this();
+    uint64_t id = child.parentId;
+    try {
+        orders.placeOrder(child.instrument, child.side, "limit", child.amount, child.price, false,
+                          "algo-" + std::to_string(id), "immediate_or_cancel",
+                          [self, id](const json& response, std::exception_ptr error) {
+                              self->onChildDone(id, response, error);
+                          });
+    } catch (const std::exception&) {
+        onChildDone(id, json(), std::current_exception());
+    }
+}
+
+void ExecutionEngine::onChildDone(uint64_t id, const json& response, std::exception_ptr error) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = parents.find(id);
+    if (it == parents.end()) {
+        return;
+    }
+    Parent& parent = it->second;
+    parent.working = 0;
+
+    std::string failure;
+    if (error) {
+        try {
+            std::rethrow_exception(error);
+        } catch (const std::exception& e) {
+            failure = e.what();
+        }
+    } else if (response.contains("error")) {
+        const json& detail = response["error"];
+        failure = detail.is_object() ? detail.value("message", detail.dump()) : detail.dump();
+    } else if (!response.contains("result") || !response["result"].contains("order")) {
+        failure = "No order in the response";
+    }
+
+    if (!failure.empty()) {
+        parent.reason = failure;
+        if (++parent.failures >= MAX_CHILD_FAILURES && parent.state == State::Running) {
+            finish(parent, State::Failed, "child orders failed " + std::to_string(parent.failures) +
+                                          " times in a row: " + failure);
+        }
+        return;
+    }
+
+    // Immediate-or-cancel children are final in their response; fills of a cancelled parent still count
+    const json& order = response["result"]["order"];
+    double filled = order.value("filled_amount", 0.0);
+    parent.failures = 0;
+    parent.filled += filled;
+    parent.notional += filled * order.value("average_price", 0.0);
+    if (parent.state == State::Running && wholeLots(parent.spec.amount - parent.filled, parent.spec.lotSize) <
+                                              parent.spec.lotSize) {
+        finish(parent, State::Done, "filled");
+    }
+}
+
+void ExecutionEngine::finish(Parent& parent, State state, const std::string& reason) {
+    parent.state = state;
+    parent.reason = reason;
+    if (parent.timer) {
+        wheel.cancel(parent.timer);
+        parent.timer = 0;
+    }
+}
+
+const char* ExecutionEngine::stateName(State state) {
+    switch (state) {
+        case State::Running: return "running";
+        case State::Done: return "done";
+        case State::Expired: return "expired";
+        case State::Cancelled: return "cancelled";
+        case State::Failed: return "failed";
+    }
+    return "unknown";
+}
+
+json ExecutionEngine::status() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto now = Clock::now();
+    json result = json::array();
+    for (const auto& entry : parents) {
+        const Parent& parent = entry.second;
+        const ParentSpec& spec = parent.spec;
+        json item = {
+            {"id", parent.id},
+            {"algorithm", spec.algorithm == Algorithm::TWAP ? "twap" : "vwap"},
+            {"instrument_name", spec.instrument},
+            {"side", spec.side},
+            {"amount", spec.amount},
+            {"lot_size", spec.lotSize},
+            {"duration_ms", spec.duration.count()},
+            {"limit_price", spec.limitPrice},
+            {"filled", parent.filled},
+            {"average_price", parent.filled > 0 ? json(parent.notional / parent.filled) : json()},
+            {"working", parent.working},
+            {"children", parent.children},
+            {"elapsed_ms", std::chrono::duration_cast<std::chrono::milliseconds>(now - parent.startTime).count()},
+            {"state", stateName(parent.state)},
+            {"reason", parent.reason}
+        };
+        if (spec.algorithm == Algorithm::VWAP) {
+            item["participation"] = spec.participation;
+            auto market = markets.find(spec.instrument);
+            item["market_volume"] = market != markets.end() ? market->second.volume - parent.volumeStart : 0.0;
+        }
+        result.push_back(item);
+    }
+    return result;
+}
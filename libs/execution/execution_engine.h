@@ -0,0 +1,270 @@
+#ifndef EXECUTION_ENGINE_H
+#define EXECUTION_ENGINE_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <nlohmann/json.hpp>
+#include "order_placement.h"
+#include "timer_wheel.h"
+
+using json = nlohmann::json;
+
+/**
+ * @brief Slices parent orders into child orders over time (TWAP) or volume (VWAP)
+ *
+ * Every parent order has one timer on a shared TimerWheel that fires once
+ * per slice interval, so a single thread drives any number of parents.
+ * At each slice the parent compares what it has filled with its target:
+ * - TWAP: the amount times the share of the duration elapsed
+ * - VWAP: the participation rate times the market volume traded since the
+ *   parent started, from the trade stream
+ *
+ * When the shortfall is at least one lot, the parent sends one child for
+ * it: an immediate-or-cancel limit order at the opposite best price from
+ * the book stream, never beyond the parent's limit price. Fills come from
+ * the child's response, so a parent has at most one child in flight.
+ * Children carry the label "algo-<id>" and go through OrderPlacement, so
+ * pre-trade checks, the kill switch and the circuit breaker apply to them.
+ *
+ * A TWAP parent gets one last slice at its end time for whatever is left;
+ * a VWAP parent stops at its end time. A parent fails after three child
+ * errors in a row.
+ *
+ * Create with std::make_shared: child callbacks hold the engine alive
+ * until the order handler has answered them.
+ */
+class ExecutionEngine : public std::enable_shared_from_this<ExecutionEngine> {
+public:
+    using Clock = TimerWheel::Clock;
+
+    /**
+     * @brief Slicing algorithm of a parent order
+     */
+    enum class Algorithm {
+        TWAP, /**< Evenly over time */
+        VWAP /**< In proportion to market volume */
+    };
+
+    /**
+     * @brief Parent order request
+     */
+    struct ParentSpec {
+        Algorithm algorithm = Algorithm::TWAP; /**< Slicing algorithm */
+        std::string instrument; /**< Instrument name */
+        std::string side; /**< "buy" or "sell" */
+        double amount = 0; /**< Total amount */
+        double lotSize = 1; /**< Child amounts are multiples of this, e.g. the instrument's min_trade_amount */
+        std::chrono::milliseconds duration{0}; /**< TWAP: time to spread over; VWAP: the longest it runs */
+        double participation = 0; /**< VWAP: share of the market volume to trade, e.g. 0.1 */
+        double limitPrice = 0; /**< Worst child price, 0 for none */
+    };
+
+    /**
+     * @brief Construct a new ExecutionEngine object
+     *
+     * @param orders Handler the children are sent through
+     * @param sliceInterval Time between a parent's slices
+     */
+    ExecutionEngine(OrderPlacement& orders, std::chrono::milliseconds sliceInterval);
+
+    /**
+     * @brief Destroy the ExecutionEngine object, stopping the timer thread
+     */
+    ~ExecutionEngine();
+
+    /**
+     * @brief Set the function called with an instrument when a parent starts on it
+     *
+     * The owner uses it to subscribe the instrument's book and trades. It is
+     * called without the engine's lock held.
+     *
+     * @param follow Receives the instrument name
+     */
+    void setFollow(std::function<void(const std::string& instrument)> follow);
+
+    /**
+     * @brief Start the timer thread
+     */
+    void start();
+
+    /**
+     * @brief Stop the timer thread; running parents stop slicing
+     */
+    void stop();
+
+    /**
+     * @brief Start a parent order
+     *
+     * @param spec The parent order
+     * @return uint64_t The parent id
+     * @throws std::invalid_argument if the spec is inconsistent
+     */
+    uint64_t submit(const ParentSpec& spec);
+
+    /**
+     * @brief Cancel a running parent; a child in flight still reports its fill
+     *
+     * @param id The parent id
+     * @return true if the parent was running
+     */
+    bool cancel(uint64_t id);
+
+    /**
+     * @brief Cancel every running parent
+     *
+     * @param reason Recorded on each parent
+     * @return std::size_t The number of parents cancelled
+     */
+    std::size_t cancelAll(const std::string& reason);
+
+    /**
+     * @brief Update the best prices of an instrument, from the book stream
+     *
+     * @param instrument The instrument name
+     * @param bestBid The best bid, 0 while the side is empty
+     * @param bestAsk The best ask, 0 while the side is empty
+     */
+    void onBook(const std::string& instrument, double bestBid, double bestAsk);
+
+    /**
+     * @brief Add traded volume of an instrument, from the trade stream
+     *
+     * @param instrument The instrument name
+     * @param volume The amount traded
+     */
+    void onTrades(const std::string& instrument, double volume);
+
+    /**
+     * @brief Get every parent order, running or finished
+     *
+     * @return json Array of parents with their progress and state
+     */
+    json status() const;
+
+    /**
+     * @brief Parse an algorithm name
+     *
+     * @param name "twap" or "vwap"
+     * @return Algorithm The algorithm
+     * @throws std::invalid_argument for any other name
+     */
+    static Algorithm algorithmFromString(const std::string& name);
+
+private:
+    /**
+     * @brief Lifecycle of a parent order
+     */
+    enum class State {
+        Running, /**< Slicing */
+        Done, /**< Filled */
+        Expired, /**< Reached its end time unfilled */
+        Cancelled, /**< Cancelled by the user or the kill switch */
+        Failed /**< Too many child errors in a row */
+    };
+
+    /**
+     * @brief Live market figures of an instrument
+     */
+    struct Market {
+        double bestBid = 0; /**< Best bid, 0 until known */
+        double bestAsk = 0; /**< Best ask, 0 until known */
+        double volume = 0; /**< Volume traded since the instrument was first followed */
+    };
+
+    /**
+     * @brief A running or finished parent order
+     */
+    struct Parent {
+        uint64_t id = 0; /**< Parent id */
+        ParentSpec spec; /**< The request */
+        State state = State::Running; /**< Lifecycle state */
+        std::string reason; /**< Why the parent stopped, or the last child error */
+        Clock::time_point startTime; /**< When slicing started */
+        Clock::time_point endTime; /**< Start plus the duration */
+        double volumeStart = 0; /**< Market volume when the parent started */
+        double filled = 0; /**< Amount filled by children */
+        double notional = 0; /**< Sum of fill amount times price, for the average price */
+        double working = 0; /**< Amount of the child in flight, 0 for none */
+        uint64_t children = 0; /**< Children sent */
+        unsigned failures = 0; /**< Child errors in a row */
+        uint64_t timer = 0; /**< Pending slice timer, 0 for none */
+    };
+
+    /**
+     * @brief A child order decided under the lock and sent after it
+     */
+    struct Child {
+        uint64_t parentId; /**< Parent id */
+        std::string instrument; /**< Instrument name */
+        std::string side; /**< "buy" or "sell" */
+        double amount; /**< Child amount */
+        double price; /**< Limit price */
+    };
+
+    /**
+     * @brief Timer thread: advances the wheel and sends the children it decides
+     */
+    void run();
+
+    /**
+     * @brief Decide a parent's next child, if any, and schedule its next slice
+     *
+     * @param id The parent id
+     * @param now The current time
+     */
+    void slice(uint64_t id, Clock::time_point now);
+
+    /**
+     * @brief Send a child through the order handler, without the lock held
+     *
+     * @param child The child order
+     */
+    void send(const Child& child);
+
+    /**
+     * @brief Record a child's response
+     *
+     * @param id The parent id
+     * @param response The order handler's response
+     * @param error The error, if the child failed
+     */
+    void onChildDone(uint64_t id, const json& response, std::exception_ptr error);
+
+    /**
+     * @brief Move a parent to a final state and drop its timer
+     *
+     * @param parent The parent
+     * @param state The final state
+     * @param reason Why it stopped
+     */
+    void finish(Parent& parent, State state, const std::string& reason);
+
+    /**
+     * @brief Convert a state to its name
+     */
+    static const char* stateName(State state);
+
+    OrderPlacement& orders; /**< Handler the children are sent through */
+    std::chrono::milliseconds sliceInterval; /**< Time between a parent's slices */
+    std::function<void(const std::string&)> follow; /**< Subscribes an instrument's book and trades */
+    TimerWheel wheel; /**< Slice timers of every running parent */
+    std::map<uint64_t, Parent> parents; /**< Parents by id, finished ones included */
+    std::unordered_map<std::string, Market> markets; /**< Market figures of followed instruments */
+    std::vector<Child> outbox; /**< Children decided by the timers, waiting to be sent */
+    uint64_t nextId = 1; /**< Id of the next parent */
+    mutable std::mutex mutex; /**< Mutex for synchronizing access to everything above */
+    std::condition_variable cv; /**< Wakes the timer thread for new timers and on stop */
+    std::thread timerThread; /**< Runs the wheel */
+    bool running = false; /**< True while the timer thread runs */
+};
+
+#endif // EXECUTION_ENGINE_H
@@ -0,0 +1,77 @@
+#include "timer_wheel.h"
+#include <algorithm>
+
+TimerWheel::TimerWheel(Clock::duration tick, std::size_t slots, Clock::time_point start)
+    : tick(std::max(tick, Clock::duration(1))), slots(std::max<std::size_t>(slots, 1)), current(start) {
+}
+
+uint64_t TimerWheel::schedule(Clock::time_point when, Callback callback) {
+    // Ticks until the first boundary at or after when, at least the next one
+    uint64_t ticks = 1;
+    if (when > current) {
+        ticks = static_cast<uint64_t>((when - current + tick - Clock::duration(1)) / tick);
+        ticks = std::max<uint64_t>(ticks, 1);
+    }
+
+    uint64_t id = nextId++;
+    std::size_t slot = (cursor + ticks) % slots.size();
+    slots[slot].push_back(Timer{id, (ticks - 1) / slots.size(), std::move(callback)});
+    slotOf[id] = slot;
+    return id;
+}
+
+bool TimerWheel::cancel(uint64_t id) {
+    auto it = slotOf.find(id);
+    if (it == slotOf.end()) {
+        return false;
+    }
+
+    // A timer already taken out for firing is skipped once its entry is gone
+    std::vector<Timer>& slot = slots[it->second];
+    auto timer = std::find_if(slot.begin(), slot.end(), [id](const Timer& t) { return t.id == id; });
+    if (timer != slot.end()) {
+        *timer = std::move(slot.back());
+        slot.pop_back();
+    }
+    slotOf.erase(it);
+    return true;
+}
+
+std::size_t TimerWheel::advance(Clock::time_point now) {
+    std::size_t fired = 0;
+    while (now - current >= tick) {
+        if (slotOf.empty()) {
+            // Nothing left to visit; jump straight to the tick holding now
+            auto ticks = static_cast<uint64_t>((now - current) / tick);
+            current += tick * ticks;
+            cursor = (cursor + ticks) % slots.size();
+            break;
+        }
+
+        current += tick;
+        cursor = (cursor + 1) % slots.size();
+
+        std::vector<Timer>& slot = slots[cursor];
+        for (std::size_t i = 0; i < slot.size();) {
+            if (slot[i].turns > 0) {
+                --slot[i].turns;
+                ++i;
+            } else {
+                due.push_back(std::move(slot[i]));
+                slot[i] = std::move(slot.back());
+                slot.pop_back();
+            }
+        }
+
+        for (Timer& timer : due) {
+            // Cancelled by an earlier callback of the same tick
+            if (slotOf.erase(timer.id) == 0) {
+                continue;
+            }
+            ++fired;
+            timer.callback();
+        }
+        due.clear();
+    }
+    return fired;
+}
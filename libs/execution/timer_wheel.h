@@ -0,0 +1,98 @@
+#ifndef TIMER_WHEEL_H
+#define TIMER_WHEEL_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief Hashed timer wheel: many one-shot timers driven by one thread
+ *
+ * Time is cut into ticks. A timer due in n ticks goes in slot
+ * (cursor + n) % slots with n / slots full turns still to wait, so
+ * scheduling and cancelling cost O(1) whatever the number of timers. Each
+ * advanced tick visits one slot and fires the timers whose turns are
+ * done. Timers fire at the first tick boundary at or after their due time,
+ * so they are late by up to one tick, never early.
+ *
+ * Not thread-safe: the owner serializes calls. Callbacks may schedule and
+ * cancel timers, including rescheduling themselves.
+ */
+class TimerWheel {
+public:
+    using Clock = std::chrono::steady_clock;
+    using Callback = std::function<void()>;
+
+    /**
+     * @brief Construct a new TimerWheel object
+     *
+     * @param tick The resolution of the wheel
+     * @param slots The number of slots; a turn lasts tick * slots
+     * @param start The time of the current tick
+     */
+    explicit TimerWheel(Clock::duration tick = std::chrono::milliseconds(10), std::size_t slots = 512,
+                        Clock::time_point start = Clock::now());
+
+    /**
+     * @brief Schedule a one-shot timer
+     *
+     * @param when The time the callback is due; times already past fire on the next tick
+     * @param callback Called once from advance()
+     * @return uint64_t The timer id, for cancel()
+     */
+    uint64_t schedule(Clock::time_point when, Callback callback);
+
+    /**
+     * @brief Cancel a timer that has not fired
+     *
+     * @param id The timer id
+     * @return true if the timer was pending
+     */
+    bool cancel(uint64_t id);
+
+    /**
+     * @brief Advance the wheel to a time, firing every timer due by then
+     *
+     * @param now The current time
+     * @return std::size_t The number of timers fired
+     */
+    std::size_t advance(Clock::time_point now);
+
+    /**
+     * @brief Get the time the next tick ends, when advance() next has work to do
+     */
+    Clock::time_point nextTick() const { return current + tick; }
+
+    /**
+     * @brief Get the number of pending timers
+     */
+    std::size_t size() const { return slotOf.size(); }
+
+    /**
+     * @brief Check if no timer is pending
+     */
+    bool empty() const { return slotOf.empty(); }
+
+private:
+    /**
+     * @brief A pending timer
+     */
+    struct Timer {
+        uint64_t id; /**< Timer id */
+        uint64_t turns; /**< Full turns of the wheel still to wait */
+        Callback callback; /**< Called when due */
+    };
+
+    Clock::duration tick; /**< Duration of one tick */
+    std::vector<std::vector<Timer>> slots; /**< Timers by slot */
+    std::unordered_map<uint64_t, std::size_t> slotOf; /**< Slot of each pending timer, by id */
+    std::vector<Timer> due; /**< Timers being fired by advance() */
+    Clock::time_point current; /**< Start of the current tick */
+    std::size_t cursor = 0; /**< Slot of the current tick */
+    uint64_t nextId = 1; /**< Id of the next timer */
+};
+
+#endif // TIMER_WHEEL_H
@@ -0,0 +1,106 @@
+#include "bar_aggregator.h"
+#include <algorithm>
+#include <stdexcept>
+
+BarSeries::BarSeries(int64_t resolutionMs, std::size_t capacity)
+    : resolutionMs(std::max<int64_t>(resolutionMs, 1)), bars(std::max<std::size_t>(capacity, 1)) {
+}
+
+bool BarSeries::add(double price, double amount, int64_t timestampMs) {
+    int64_t start = timestampMs - timestampMs % resolutionMs;
+    if (count > 0 && start <= current().startMs) {
+        Bar& bar = bars[(head + count - 1) % bars.size()];
+        bar.high = std::max(bar.high, price);
+        bar.low = std::min(bar.low, price);
+        bar.close = price;
+        bar.volume += amount;
+        bar.notional += price * amount;
+        ++bar.trades;
+        return false;
+    }
+
+    Bar bar;
+    bar.startMs = start;
+    bar.open = bar.high = bar.low = bar.close = price;
+    bar.volume = amount;
+    bar.notional = price * amount;
+    bar.trades = 1;
+
+    if (count < bars.size()) {
+        bars[(head + count) % bars.size()] = bar;
+        ++count;
+    } else {
+        bars[head] = bar;
+        head = (head + 1) % bars.size();
+    }
+    return count > 1;
+}
+
+BarAggregator::BarAggregator(const std::vector<int64_t>& resolutionsMs, std::size_t history) {
+    if (resolutionsMs.size() > MAX_RESOLUTIONS) {
+        throw std::invalid_argument("Too many bar resolutions");
+    }
+    allSeries.reserve(resolutionsMs.size());
+    for (int64_t resolution : resolutionsMs) {
+        allSeries.emplace_back(resolution, history);
+    }
+}
+
+uint32_t BarAggregator::add(double price, double amount, int64_t timestampMs) {
+    uint32_t closed = 0;
+    for (std::size_t i = 0; i < allSeries.size(); ++i) {
+        if (allSeries[i].add(price, amount, timestampMs)) {
+            closed |= 1u << i;
+        }
+    }
+    return closed;
+}
+
+json BarAggregator::toJson(const std::string& instrument, int64_t resolutionMs, const Bar& bar, bool closed) {
+    return json{
+        {"instrument_name", instrument},
+        {"resolution", resolutionName(resolutionMs)},
+        {"resolution_ms", resolutionMs},
+        {"timestamp", bar.startMs},
+        {"open", bar.open},
+        {"high", bar.high},
+        {"low", bar.low},
+        {"close", bar.close},
+        {"volume", bar.volume},
+        {"vwap", bar.vwap()},
+        {"trades", bar.trades},
+        {"closed", closed}
+    };
+}
+
+int64_t BarAggregator::parseResolution(const std::string& name) {
+    std::size_t digits = 0;
+    while (digits < name.size() && name[digits] >= '0' && name[digits] <= '9') {
+        ++digits;
+    }
+
+    std::string unit = name.substr(digits);
+    int64_t scale = unit == "ms" ? 1 : unit == "s" ? 1000 : unit == "m" ? 60000 : unit == "h" ? 3600000 : 0;
+    if (digits == 0 || digits > 9 || scale == 0) {
+        throw std::invalid_argument("Invalid bar resolution '" + name + "'");
+    }
+
+    int64_t value = std::stoll(name.substr(0, digits)) * scale;
+    if (value <= 0) {
+        throw std::invalid_argument("Invalid bar resolution '" + name + "'");
+    }
+    return value;
+}
+
+std::string BarAggregator::resolutionName(int64_t resolutionMs) {
+    if (resolutionMs % 3600000 == 0) {
+        return std::to_string(resolutionMs / 3600000) + "h";
+    }
+    if (resolutionMs % 60000 == 0) {
+        return std::to_string(resolutionMs / 60000) + "m";
+    }
+    if (resolutionMs % 1000 == 0) {
+        return std::to_string(resolutionMs / 1000) + "s";
+    }
+    return std::to_string(resolutionMs) + "ms";
+}
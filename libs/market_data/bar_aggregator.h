@@ -0,0 +1,155 @@
+#ifndef BAR_AGGREGATOR_H
+#define BAR_AGGREGATOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+using json = nlohmann::json;
+
+/**
+ * @brief OHLCV bar of one time interval
+ */
+struct Bar {
+    int64_t startMs = 0; /**< Start of the interval in milliseconds */
+    double open = 0; /**< First trade price */
+    double high = 0; /**< Highest trade price */
+    double low = 0; /**< Lowest trade price */
+    double close = 0; /**< Last trade price */
+    double volume = 0; /**< Sum of trade amounts */
+    double notional = 0; /**< Sum of trade amount times price, for the VWAP */
+    uint32_t trades = 0; /**< Number of trades */
+
+    /**
+     * @brief Get the volume-weighted average price
+     */
+    double vwap() const { return volume > 0 ? notional / volume : close; }
+};
+
+/**
+ * @brief Bars of one resolution in a fixed-size ring buffer
+ *
+ * The newest bar is the open one. A trade in a later interval closes it and
+ * opens the next; intervals without trades get no bar. The oldest bar is
+ * overwritten once the ring is full. Late trades, stamped before the open
+ * bar, are folded into it rather than reopening a closed bar.
+ */
+class BarSeries {
+public:
+    /**
+     * @brief Construct a new BarSeries object
+     *
+     * @param resolutionMs Interval of each bar in milliseconds
+     * @param capacity Bars kept, the open one included
+     */
+    BarSeries(int64_t resolutionMs, std::size_t capacity);
+
+    /**
+     * @brief Add a trade
+     *
+     * @param price The trade price
+     * @param amount The trade amount
+     * @param timestampMs The trade timestamp in milliseconds
+     * @return true if the trade closed the previous bar, now at(size() - 2)
+     */
+    bool add(double price, double amount, int64_t timestampMs);
+
+    /**
+     * @brief Get the interval of each bar in milliseconds
+     */
+    int64_t resolution() const { return resolutionMs; }
+
+    /**
+     * @brief Get the number of bars held
+     */
+    std::size_t size() const { return count; }
+
+    /**
+     * @brief Get a bar, 0 being the oldest held
+     */
+    const Bar& at(std::size_t index) const { return bars[(head + index) % bars.size()]; }
+
+    /**
+     * @brief Get the open bar; only valid when size() > 0
+     */
+    const Bar& current() const { return at(count - 1); }
+
+private:
+    int64_t resolutionMs; /**< Interval of each bar in milliseconds */
+    std::vector<Bar> bars; /**< Ring storage */
+    std::size_t head = 0; /**< Index of the oldest bar in bars */
+    std::size_t count = 0; /**< Bars held */
+};
+
+/**
+ * @brief Bars of one instrument at several resolutions, updated per trade
+ */
+class BarAggregator {
+public:
+    /**
+     * @brief Most resolutions an aggregator can hold, one bit each in add()'s result
+     */
+    static constexpr std::size_t MAX_RESOLUTIONS = 32;
+
+    /**
+     * @brief Construct a new BarAggregator object
+     *
+     * @param resolutionsMs Bar intervals in milliseconds, at most MAX_RESOLUTIONS
+     * @param history Bars kept per resolution
+     */
+    BarAggregator(const std::vector<int64_t>& resolutionsMs, std::size_t history);
+
+    /**
+     * @brief Add a trade to every resolution
+     *
+     * @param price The trade price
+     * @param amount The trade amount
+     * @param timestampMs The trade timestamp in milliseconds
+     * @return uint32_t Bit i set if the trade closed a bar of series(i)
+     */
+    uint32_t add(double price, double amount, int64_t timestampMs);
+
+    /**
+     * @brief Get the number of resolutions
+     */
+    std::size_t size() const { return allSeries.size(); }
+
+    /**
+     * @brief Get the bars of one resolution, in the order given to the constructor
+     */
+    const BarSeries& series(std::size_t index) const { return allSeries[index]; }
+
+    /**
+     * @brief Serialize a bar
+     *
+     * @param instrument The instrument name
+     * @param resolutionMs The bar interval in milliseconds
+     * @param bar The bar
+     * @param closed True once no more trades can change the bar
+     * @return json Object with instrument_name, resolution, timestamp (the bar start), OHLC, volume, vwap, trades and closed
+     */
+    static json toJson(const std::string& instrument, int64_t resolutionMs, const Bar& bar, bool closed);
+
+    /**
+     * @brief Parse a resolution such as "500ms", "1s", "1m" or "1h"
+     *
+     * @param name The resolution
+     * @return int64_t The interval in milliseconds
+     * @throws std::invalid_argument if the name is not a positive count with one of those units
+     */
+    static int64_t parseResolution(const std::string& name);
+
+    /**
+     * @brief Name a resolution in its largest whole unit, as parseResolution reads it
+     *
+     * @param resolutionMs The interval in milliseconds
+     */
+    static std::string resolutionName(int64_t resolutionMs);
+
+private:
+    std::vector<BarSeries> allSeries; /**< Bars by resolution */
+};
+
+#endif // BAR_AGGREGATOR_H
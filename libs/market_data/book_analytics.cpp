@@ -0,0 +1,117 @@
+#include "book_analytics.h"
+#include <algorithm>
+#include <functional>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace {
+    // out[i] = carry + in[0] * scale[0] + ... + in[i] * scale[i]; scale may be null for 1
+    void prefixSum(const double* in, const double* scale, double* out, std::size_t count, double carry) {
+        std::size_t i = 0;
+#if defined(__SSE2__)
+        __m128d total = _mm_set1_pd(carry);
+        for (; i + 2 <= count; i += 2) {
+            __m128d pair = _mm_loadu_pd(in + i);
+            if (scale) {
+                pair = _mm_mul_pd(pair, _mm_loadu_pd(scale + i));
+            }
+            // [a, b] + [0, a] + carry = [carry + a, carry + a + b]
+            pair = _mm_add_pd(pair, _mm_unpacklo_pd(_mm_setzero_pd(), pair));
+            pair = _mm_add_pd(pair, total);
+            _mm_storeu_pd(out + i, pair);
+            total = _mm_unpackhi_pd(pair, pair);
+        }
+        carry = _mm_cvtsd_f64(total);
+#endif
+        for (; i < count; ++i) {
+            carry += scale ? in[i] * scale[i] : in[i];
+            out[i] = carry;
+        }
+    }
+}
+
+BookAnalytics::BookAnalytics(std::size_t depth)
+    : levels(std::max<std::size_t>(depth, 1)), weights(levels), scratch(levels) {
+    for (std::size_t i = 0; i < levels; ++i) {
+        weights[i] = 1.0 / static_cast<double>(i + 1);
+    }
+    for (SideSums* sums : {&bidSide, &askSide}) {
+        sums->cumulative.assign(levels, 0.0);
+        sums->weighted.assign(levels, 0.0);
+    }
+}
+
+std::size_t BookAnalytics::firstChanged(const OrderBook::Side& side, const OrderBook::LevelChanges& changes) const {
+    // A changed level is at, or was removed from, the position its price sorts to
+    std::size_t first = levels;
+    for (double price : changes.prices) {
+        auto it = side.descending
+            ? std::lower_bound(side.prices.begin(), side.prices.end(), price, std::greater<double>())
+            : std::lower_bound(side.prices.begin(), side.prices.end(), price);
+        first = std::min(first, static_cast<std::size_t>(it - side.prices.begin()));
+    }
+    return first;
+}
+
+void BookAnalytics::recompute(const OrderBook::Side& side, SideSums& sums, std::size_t from) {
+    std::size_t filled = std::min(side.size(), levels);
+    std::fill(scratch.begin() + from, scratch.end(), 0.0);
+    if (filled > from) {
+        std::copy(side.amounts.begin() + from, side.amounts.begin() + filled, scratch.begin() + from);
+    }
+
+    std::size_t count = levels - from;
+    prefixSum(scratch.data() + from, nullptr, sums.cumulative.data() + from, count,
+              from ? sums.cumulative[from - 1] : 0.0);
+    prefixSum(scratch.data() + from, weights.data() + from, sums.weighted.data() + from, count,
+              from ? sums.weighted[from - 1] : 0.0);
+}
+
+bool BookAnalytics::update(const OrderBook& book, const OrderBook::Changes* changes) {
+    const OrderBook::Side& bids = book.bids();
+    const OrderBook::Side& asks = book.asks();
+
+    std::size_t bidFrom = changes ? firstChanged(bids, changes->bids) : 0;
+    std::size_t askFrom = changes ? firstChanged(asks, changes->asks) : 0;
+    if (bidFrom >= levels && askFrom >= levels) {
+        return false;
+    }
+    if (bidFrom < levels) {
+        recompute(bids, bidSide, bidFrom);
+    }
+    if (askFrom < levels) {
+        recompute(asks, askSide, askFrom);
+    }
+
+    if (bids.size() > 0 && asks.size() > 0) {
+        double bid = bids.prices[0];
+        double ask = asks.prices[0];
+        double top = bids.amounts[0] + asks.amounts[0];
+        midPrice = (bid + ask) / 2;
+        spreadPrice = ask - bid;
+        microPrice = top > 0 ? (bid * asks.amounts[0] + ask * bids.amounts[0]) / top : midPrice;
+    } else {
+        midPrice = microPrice = spreadPrice = 0;
+    }
+
+    double bidWeight = bidSide.weighted.back();
+    double askWeight = askSide.weighted.back();
+    bookImbalance = bidWeight + askWeight > 0 ? (bidWeight - askWeight) / (bidWeight + askWeight) : 0;
+    return true;
+}
+
+json BookAnalytics::toJson(const OrderBook& book) const {
+    return json{
+        {"instrument_name", book.instrument()},
+        {"timestamp", book.timestamp()},
+        {"change_id", book.changeId()},
+        {"mid", midPrice},
+        {"microprice", microPrice},
+        {"spread", spreadPrice},
+        {"imbalance", bookImbalance},
+        {"bid_depth", bidSide.cumulative},
+        {"ask_depth", askSide.cumulative}
+    };
+}
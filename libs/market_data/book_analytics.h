@@ -0,0 +1,119 @@
+#ifndef BOOK_ANALYTICS_H
+#define BOOK_ANALYTICS_H
+
+#include <cstddef>
+#include <vector>
+#include "order_book.h"
+
+/**
+ * @brief Top-of-book analytics of one OrderBook, kept up to date per update
+ *
+ * Covers the mid, the microprice, the spread, the depth-weighted imbalance
+ * and the cumulative depth of the first N levels of each side. Level i
+ * weighs 1 / (i + 1) in the imbalance.
+ *
+ * Each side keeps prefix sums of its top N amounts and weighted amounts in
+ * contiguous arrays. An update recomputes them from the first changed level
+ * down, two levels per SSE2 instruction, and leaves a side untouched when
+ * all of its changes are deeper than N.
+ */
+class BookAnalytics {
+public:
+    /**
+     * @brief Construct a new BookAnalytics object
+     *
+     * @param depth Levels per side covered by the imbalance and cumulative depth
+     */
+    explicit BookAnalytics(std::size_t depth = 10);
+
+    /**
+     * @brief Bring the analytics up to date with the book
+     *
+     * @param book The book, after the update was applied
+     * @param changes The levels the update changed, or nullptr to recompute everything
+     * @return true if any figure may have changed, false if every change was deeper than depth
+     */
+    bool update(const OrderBook& book, const OrderBook::Changes* changes);
+
+    /**
+     * @brief Get the number of levels per side covered
+     */
+    std::size_t depth() const { return levels; }
+
+    /**
+     * @brief Get the mid price, 0 while a side is empty
+     */
+    double mid() const { return midPrice; }
+
+    /**
+     * @brief Get the microprice: the best prices weighted by the opposite best amounts, 0 while a side is empty
+     */
+    double microprice() const { return microPrice; }
+
+    /**
+     * @brief Get the best ask minus the best bid, 0 while a side is empty
+     */
+    double spread() const { return spreadPrice; }
+
+    /**
+     * @brief Get the depth-weighted imbalance, from -1 (all asks) to 1 (all bids)
+     */
+    double imbalance() const { return bookImbalance; }
+
+    /**
+     * @brief Get the cumulative bid amounts of the first depth levels
+     */
+    const std::vector<double>& bidDepth() const { return bidSide.cumulative; }
+
+    /**
+     * @brief Get the cumulative ask amounts of the first depth levels
+     */
+    const std::vector<double>& askDepth() const { return askSide.cumulative; }
+
+    /**
+     * @brief Serialize the analytics
+     *
+     * @param book The book they were computed from
+     * @return json Object with instrument_name, timestamp, change_id, the figures and the depth arrays
+     */
+    json toJson(const OrderBook& book) const;
+
+private:
+    /**
+     * @brief Prefix sums of one side
+     */
+    struct SideSums {
+        std::vector<double> cumulative; /**< Sum of the amounts of levels 0..i */
+        std::vector<double> weighted; /**< Sum of the weighted amounts of levels 0..i */
+    };
+
+    /**
+     * @brief Find the first level of a side an update touched
+     *
+     * @param side The side after the update
+     * @param changes The side's changed levels
+     * @return std::size_t The level index, at least depth if none is in the top levels
+     */
+    std::size_t firstChanged(const OrderBook::Side& side, const OrderBook::LevelChanges& changes) const;
+
+    /**
+     * @brief Recompute the prefix sums of a side from a level down
+     *
+     * @param side The side
+     * @param sums The side's prefix sums
+     * @param from The first level to recompute
+     */
+    void recompute(const OrderBook::Side& side, SideSums& sums, std::size_t from);
+
+    std::size_t levels; /**< Levels per side covered */
+    std::vector<double> weights; /**< Weight of each level in the imbalance */
+    std::vector<double> scratch; /**< Top amounts of the side being recomputed, zero padded */
+    SideSums bidSide; /**< Bid prefix sums */
+    SideSums askSide; /**< Ask prefix sums */
+    double midPrice = 0; /**< Mid price */
+    double microPrice = 0; /**< Microprice */
+    double spreadPrice = 0; /**< Spread */
+    double bookImbalance = 0; /**< Depth-weighted imbalance */
+};
+
+#endif // BOOK_ANALYTICS_H
@@ -0,0 +1,156 @@
+#include "order_book.h"
+#include <algorithm>
+
+void OrderBook::Side::set(double price, double amount, LevelChanges* changes) {
+    auto it = descending
+        ? std::lower_bound(prices.begin(), prices.end(), price, std::greater<double>())
+        : std::lower_bound(prices.begin(), prices.end(), price);
+    auto index = static_cast<std::size_t>(it - prices.begin());
+    bool exists = it != prices.end() && *it == price;
+
+    if (amount == 0.0) {
+        if (exists) {
+            prices.erase(it);
+            amounts.erase(amounts.begin() + index);
+            if (changes) changes->add(price, 0.0);
+        }
+        return;
+    }
+
+    if (exists) {
+        if (amounts[index] == amount) return;
+        amounts[index] = amount;
+    } else {
+        prices.insert(it, price);
+        amounts.insert(amounts.begin() + index, amount);
+    }
+    if (changes) changes->add(price, amount);
+}
+
+void OrderBook::Side::clear() {
+    prices.clear();
+    amounts.clear();
+}
+
+OrderBook::OrderBook(std::string instrument)
+    : instrumentName(std::move(instrument)) {
+    bidSide.descending = true;
+    askSide.descending = false;
+}
+
+bool OrderBook::apply(const json& data, Changes* changes) {
+    if (changes) {
+        changes->clear();
+    }
+
+    if (instrumentName.empty() && data.contains("instrument_name")) {
+        instrumentName = data["instrument_name"].get<std::string>();
+    }
+
+    const json* bidEntries = data.contains("bids") ? &data["bids"] : nullptr;
+    const json* askEntries = data.contains("asks") ? &data["asks"] : nullptr;
+
+    // Grouped books ([price, amount] entries) always carry the full book
+    auto isGrouped = [](const json* entries) {
+        return entries && !entries->empty() && (*entries)[0].is_array() &&
+               !(*entries)[0].empty() && (*entries)[0][0].is_number();
+    };
+    bool grouped = isGrouped(bidEntries) || isGrouped(askEntries);
+    bool snapshot = grouped || data.value("type", "") == "snapshot";
+
+    if (!snapshot) {
+        // Incremental updates are only meaningful on top of the previous one
+        if (!valid || (data.contains("prev_change_id") &&
+                       data["prev_change_id"].get<uint64_t>() != lastChangeId)) {
+            clear();
+            return false;
+        }
+        if (bidEntries) applyEntries(bidSide, *bidEntries, changes ? &changes->bids : nullptr);
+        if (askEntries) applyEntries(askSide, *askEntries, changes ? &changes->asks : nullptr);
+    } else if (changes) {
+        // Keep the previous levels aside to report what the snapshot changed
+        Side previousBids = std::move(bidSide);
+        Side previousAsks = std::move(askSide);
+        bidSide.clear();
+        askSide.clear();
+        if (bidEntries) applyEntries(bidSide, *bidEntries, nullptr);
+        if (askEntries) applyEntries(askSide, *askEntries, nullptr);
+        diffSides(previousBids, bidSide, changes->bids);
+        diffSides(previousAsks, askSide, changes->asks);
+    } else {
+        bidSide.clear();
+        askSide.clear();
+        if (bidEntries) applyEntries(bidSide, *bidEntries, nullptr);
+        if (askEntries) applyEntries(askSide, *askEntries, nullptr);
+    }
+
+    if (data.contains("change_id")) {
+        lastChangeId = data["change_id"].get<uint64_t>();
+    }
+    if (data.contains("timestamp")) {
+        lastTimestamp = data["timestamp"].get<int64_t>();
+    }
+    valid = true;
+    return true;
+}
+
+void OrderBook::applyEntries(Side& side, const json& entries, LevelChanges* changes) {
+    for (const auto& entry : entries) {
+        if (!entry.is_array() || entry.size() < 2) continue;
+
+        if (entry[0].is_string()) {
+            if (entry.size() < 3) continue;
+            const std::string& action = entry[0].get_ref<const std::string&>();
+            double price = entry[1].get<double>();
+            double amount = action == "delete" ? 0.0 : entry[2].get<double>();
+            side.set(price, amount, changes);
+        } else {
+            side.set(entry[0].get<double>(), entry[1].get<double>(), changes);
+        }
+    }
+}
+
+void OrderBook::diffSides(const Side& before, const Side& after, LevelChanges& changes) {
+    // Both sides are sorted best-first, so a single merge pass finds every difference
+    auto better = [&after](double a, double b) { return after.descending ? a > b : a < b; };
+    std::size_t i = 0, j = 0;
+    while (i < before.size() || j < after.size()) {
+        if (j == after.size() || (i < before.size() && better(before.prices[i], after.prices[j]))) {
+            changes.add(before.prices[i++], 0.0);
+        } else if (i == before.size() || better(after.prices[j], before.prices[i])) {
+            changes.add(after.prices[j], after.amounts[j]);
+            ++j;
+        } else {
+            if (before.amounts[i] != after.amounts[j]) {
+                changes.add(after.prices[j], after.amounts[j]);
+            }
+            ++i;
+            ++j;
+        }
+    }
+}
+
+void OrderBook::clear() {
+    bidSide.clear();
+    askSide.clear();
+    valid = false;
+}
+
+json OrderBook::toJson(std::size_t depth) const {
+    auto sideToJson = [depth](const Side& side) {
+        std::size_t levels = depth == 0 ? side.size() : std::min(depth, side.size());
+        json result = json::array();
+        for (std::size_t i = 0; i < levels; ++i) {
+            result.push_back({side.prices[i], side.amounts[i]});
+        }
+        return result;
+    };
+
+    return {
+        {"instrument_name", instrumentName},
+        {"timestamp", lastTimestamp},
+        {"change_id", lastChangeId},
+        {"bids", sideToJson(bidSide)},
+        {"asks", sideToJson(askSide)}
+    };
+}
@@ -0,0 +1,191 @@
+#ifndef ORDER_BOOK_H
+#define ORDER_BOOK_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+using json = nlohmann::json;
+
+/**
+ * @brief Local copy of a Deribit order book built from book channel notifications
+ *
+ * Each side keeps prices and amounts in separate contiguous arrays sorted
+ * best-first, so consumers can walk levels without chasing pointers.
+ */
+class OrderBook {
+public:
+    /**
+     * @brief Levels of one side changed by an update, as (price, new amount) pairs
+     *
+     * A new amount of zero means the level was removed.
+     */
+    struct LevelChanges {
+        std::vector<double> prices; /**< Changed level prices, in update order */
+        std::vector<double> amounts; /**< New amounts, parallel to prices */
+
+        /**
+         * @brief Record a changed level
+         *
+         * @param price The level price
+         * @param amount The new amount (zero if removed)
+         */
+        void add(double price, double amount) {
+            prices.push_back(price);
+            amounts.push_back(amount);
+        }
+
+        /**
+         * @brief Get the number of changed levels
+         */
+        std::size_t size() const { return prices.size(); }
+    };
+
+    /**
+     * @brief Levels changed on both sides by one applied notification
+     */
+    struct Changes {
+        LevelChanges bids; /**< Changed bid levels */
+        LevelChanges asks; /**< Changed ask levels */
+
+        /**
+         * @brief Remove all recorded changes, keeping capacity
+         */
+        void clear() {
+            bids.prices.clear();
+            bids.amounts.clear();
+            asks.prices.clear();
+            asks.amounts.clear();
+        }
+
+        /**
+         * @brief Check whether no level changed
+         */
+        bool empty() const { return bids.size() == 0 && asks.size() == 0; }
+    };
+
+    /**
+     * @brief One side of the book, best level first
+     */
+    struct Side {
+        std::vector<double> prices; /**< Level prices, best first */
+        std::vector<double> amounts; /**< Level amounts, parallel to prices */
+        bool descending; /**< True for bids (highest price first) */
+
+        /**
+         * @brief Set the amount at a price, removing the level when amount is zero
+         *
+         * @param price The level price
+         * @param amount The new amount
+         * @param changes Receives the level if its amount actually changed (optional)
+         */
+        void set(double price, double amount, LevelChanges* changes = nullptr);
+
+        /**
+         * @brief Remove all levels
+         */
+        void clear();
+
+        /**
+         * @brief Get the number of levels
+         */
+        std::size_t size() const { return prices.size(); }
+    };
+
+    /**
+     * @brief Construct an empty OrderBook object
+     *
+     * @param instrument The instrument name
+     */
+    explicit OrderBook(std::string instrument = "");
+
+    /**
+     * @brief Apply the data of a book channel notification
+     *
+     * Handles both the incremental form (type "snapshot"/"change" with
+     * [action, price, amount] entries) and the grouped form ([price, amount]
+     * entries, always a full book).
+     *
+     * When changes is given it receives every level whose amount differs
+     * after the update; for snapshots this is the difference from the
+     * previous state of the book.
+     *
+     * @param data The "data" member of the notification
+     * @param changes Receives the changed levels (optional, cleared first)
+     * @return true if applied, false if a change_id gap was detected
+     *         (the book is then invalid until the next snapshot)
+     */
+    bool apply(const json& data, Changes* changes = nullptr);
+
+    /**
+     * @brief Remove all levels and mark the book invalid
+     */
+    void clear();
+
+    /**
+     * @brief Check whether the book holds a consistent state
+     */
+    bool isValid() const { return valid; }
+
+    /**
+     * @brief Get the instrument name
+     */
+    const std::string& instrument() const { return instrumentName; }
+
+    /**
+     * @brief Get the bid side
+     */
+    const Side& bids() const { return bidSide; }
+
+    /**
+     * @brief Get the ask side
+     */
+    const Side& asks() const { return askSide; }
+
+    /**
+     * @brief Get the change_id of the last applied notification
+     */
+    uint64_t changeId() const { return lastChangeId; }
+
+    /**
+     * @brief Get the exchange timestamp (ms) of the last applied notification
+     */
+    int64_t timestamp() const { return lastTimestamp; }
+
+    /**
+     * @brief Serialize the book as a Deribit-style snapshot
+     *
+     * @param depth Maximum levels per side (0 for all)
+     * @return json Object with instrument_name, timestamp, change_id, bids and asks
+     */
+    json toJson(std::size_t depth = 0) const;
+
+private:
+    /**
+     * @brief Apply a list of book entries to one side
+     *
+     * @param side The side to update
+     * @param entries The entries from the notification
+     * @param changes Receives the changed levels (optional)
+     */
+    static void applyEntries(Side& side, const json& entries, LevelChanges* changes);
+
+    /**
+     * @brief Record the levels that differ between two states of a side
+     *
+     * @param before The previous state
+     * @param after The new state, sorted in the same direction
+     * @param changes Receives the changed levels
+     */
+    static void diffSides(const Side& before, const Side& after, LevelChanges& changes);
+
+    std::string instrumentName; /**< Instrument name */
+    Side bidSide; /**< Bids, highest price first */
+    Side askSide; /**< Asks, lowest price first */
+    uint64_t lastChangeId = 0; /**< change_id of the last applied notification */
+    int64_t lastTimestamp = 0; /**< Exchange timestamp of the last applied notification */
+    bool valid = false; /**< True once a snapshot has been applied without gaps since */
+};
+
+#endif // ORDER_BOOK_H
@@ -0,0 +1,67 @@
+#ifndef MULTICAST_FORMAT_H
+#define MULTICAST_FORMAT_H
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+/*
+ * Market data multicast packets.
+ *
+ * Every datagram holds one MulticastPacketHeader followed by one binary
+ * protocol message (see binary_protocol.h). Sequence numbers are contiguous
+ * per publisher, so a receiver detects loss from the sequence alone.
+ *
+ * Recovery runs over TCP on a separate port. The client sends one request
+ * line and reads back frames of [uint32 length][packet], ending with a
+ * zero-length frame:
+ *
+ *   RETRANSMIT <from> <to>\n   packets from..to still held by the publisher
+ *   SNAPSHOT <instrument>\n    the current book as a BOOK snapshot packet
+ *
+ * Retransmitted and snapshot packets carry the RETRANSMIT / SNAPSHOT flags.
+ * A snapshot's book change_id tells the receiver which multicast book
+ * changes follow it (their prev_change_id).
+ */
+
+constexpr uint32_t MULTICAST_MAGIC = 0x4344424d; /**< "MBDC" */
+constexpr uint16_t MULTICAST_VERSION = 1;
+constexpr uint16_t MULTICAST_FLAG_RETRANSMIT = 1; /**< Sent again over the recovery service */
+constexpr uint16_t MULTICAST_FLAG_SNAPSHOT = 2; /**< Book snapshot from the recovery service */
+constexpr std::size_t MULTICAST_MAX_PACKET = 65507; /**< Largest UDP payload over IPv4 */
+
+#pragma pack(push, 1)
+
+/**
+ * @brief Header of every multicast packet
+ */
+struct MulticastPacketHeader {
+    uint32_t magic; /**< MULTICAST_MAGIC */
+    uint16_t version; /**< MULTICAST_VERSION */
+    uint16_t flags; /**< MULTICAST_FLAG_* bits */
+    uint64_t sequence; /**< Publisher sequence number, contiguous from 1 */
+    uint64_t sendTimeNs; /**< Publisher wall clock when first sent */
+    uint32_t payloadLength; /**< Length of the binary protocol message that follows */
+    uint32_t reserved; /**< Zero */
+};
+
+#pragma pack(pop)
+
+static_assert(sizeof(MulticastPacketHeader) == 32, "unexpected multicast header size");
+
+/**
+ * @brief Read and validate the header of a received packet
+ *
+ * @param data The packet
+ * @param size Size of the packet
+ * @param header Receives the header
+ * @return true if the packet is a complete packet of a known version
+ */
+inline bool parseMulticastPacket(const char* data, std::size_t size, MulticastPacketHeader& header) {
+    if (size < sizeof(MulticastPacketHeader)) return false;
+    std::memcpy(&header, data, sizeof(header));
+    return header.magic == MULTICAST_MAGIC && header.version == MULTICAST_VERSION &&
+           sizeof(MulticastPacketHeader) + header.payloadLength == size;
+}
+
+#endif // MULTICAST_FORMAT_H
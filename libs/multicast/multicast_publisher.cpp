@@ -0,0 +1,212 @@
+#include "multicast_publisher.h"
+#include <boost/asio/ip/multicast.hpp>
+#include <boost/asio/read_until.hpp>
+#include <boost/asio/write.hpp>
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <istream>
+
+namespace {
+    uint64_t wallClockNs() {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count());
+    }
+
+    // Recovery frames are copied out in batches of about this many bytes per write
+    constexpr std::size_t RECOVERY_BATCH_BYTES = 256 * 1024;
+
+    void appendFrame(std::string& out, const std::string& packet) {
+        uint32_t length = static_cast<uint32_t>(packet.size());
+        out.append(reinterpret_cast<const char*>(&length), sizeof(length));
+        out.append(packet);
+    }
+}
+
+MulticastPublisher::MulticastPublisher(const MulticastConfig& config, SnapshotProvider snapshotProvider)
+    : config(config)
+    , snapshotProvider(std::move(snapshotProvider))
+    , socket(ioc)
+    , acceptor(ioc)
+    , history(std::max<std::size_t>(config.retransmitDepth, 1)) {
+
+    auto group = net::ip::make_address(config.group);
+    destination = net::ip::udp::endpoint(group, config.port);
+
+    socket.open(destination.protocol());
+    socket.set_option(net::ip::multicast::hops(config.ttl));
+    socket.set_option(net::ip::multicast::enable_loopback(config.loopback));
+    if (!config.interfaceAddress.empty()) {
+        socket.set_option(net::ip::multicast::outbound_interface(
+            net::ip::make_address_v4(config.interfaceAddress)));
+    }
+
+    auto endpoint = net::ip::tcp::endpoint(net::ip::tcp::v4(), config.recoveryPort);
+    acceptor.open(endpoint.protocol());
+    acceptor.set_option(net::socket_base::reuse_address(true));
+    acceptor.bind(endpoint);
+    acceptor.listen();
+
+    doAccept();
+    recoveryThread = std::thread([this] { ioc.run(); });
+}
+
+MulticastPublisher::~MulticastPublisher() {
+    ioc.stop();
+    if (recoveryThread.joinable()) {
+        recoveryThread.join();
+    }
+}
+
+bool MulticastPublisher::publish(std::string_view payload) {
+    if (sizeof(MulticastPacketHeader) + payload.size() > MULTICAST_MAX_PACKET) {
+        return false;
+    }
+
+    MulticastPacketHeader header{};
+    header.magic = MULTICAST_MAGIC;
+    header.version = MULTICAST_VERSION;
+    header.sequence = lastSequence.load(std::memory_order_relaxed) + 1;
+    header.sendTimeNs = wallClockNs();
+    header.payloadLength = static_cast<uint32_t>(payload.size());
+
+    // The packet is built in its history slot and sent from there; only this thread replaces slots
+    std::string* packet;
+    {
+        std::lock_guard<std::mutex> lock(historyMutex);
+        packet = &history[header.sequence % history.size()];
+        packet->resize(sizeof(header) + payload.size());
+        std::memcpy(&(*packet)[0], &header, sizeof(header));
+        std::memcpy(&(*packet)[sizeof(header)], payload.data(), payload.size());
+        lastSequence.store(header.sequence, std::memory_order_relaxed);
+    }
+
+    boost::system::error_code ec;
+    socket.send_to(net::buffer(*packet), destination, 0, ec);
+    if (ec) {
+        std::cerr << "Multicast send error: " << ec.message() << std::endl;
+    }
+    return true;
+}
+
+void MulticastPublisher::doAccept() {
+    acceptor.async_accept([this](boost::system::error_code ec, net::ip::tcp::socket client) {
+        if (ec) {
+            if (ec != net::error::operation_aborted) {
+                std::cerr << "Recovery accept error: " << ec.message() << std::endl;
+            }
+            return;
+        }
+
+        // Clients are served concurrently on the recovery thread; none can block the others
+        auto connection = std::make_shared<RecoveryConnection>(std::move(client));
+        armDeadline(connection);
+        net::async_read_until(connection->socket, connection->request, '\n',
+            [this, connection](boost::system::error_code ec, std::size_t) {
+                if (ec) {
+                    if (ec != net::error::operation_aborted && ec != net::error::eof) {
+                        std::cerr << "Recovery request failed: " << ec.message() << std::endl;
+                    }
+                    return;
+                }
+                handleRecovery(connection);
+            });
+        doAccept();
+    });
+}
+
+void MulticastPublisher::armDeadline(const std::shared_ptr<RecoveryConnection>& connection) {
+    // Re-arming cancels the previous wait, which then completes with operation_aborted
+    connection->deadline.expires_after(config.recoveryTimeout);
+    connection->deadline.async_wait([connection](boost::system::error_code ec) {
+        if (!ec) {
+            boost::system::error_code closeError;
+            connection->socket.close(closeError);
+        }
+    });
+}
+
+void MulticastPublisher::handleRecovery(const std::shared_ptr<RecoveryConnection>& connection) {
+    std::istream stream(&connection->request);
+    std::string command;
+    stream >> command;
+
+    if (command == "RETRANSMIT") {
+        uint64_t from = 0, to = 0;
+        stream >> from >> to;
+        uint64_t last = lastSequence.load(std::memory_order_relaxed);
+        to = std::min(to, last);
+        from = std::max<uint64_t>(from, 1);
+        if (to >= from && to - from >= history.size()) {
+            from = to - history.size() + 1;
+        }
+        connection->next = from;
+        connection->last = to;
+    } else if (command == "SNAPSHOT") {
+        std::string instrument;
+        stream >> instrument;
+
+        std::string payload;
+        if (snapshotProvider && snapshotProvider(instrument, payload)) {
+            MulticastPacketHeader header{};
+            header.magic = MULTICAST_MAGIC;
+            header.version = MULTICAST_VERSION;
+            header.flags = MULTICAST_FLAG_SNAPSHOT;
+            header.sequence = lastSequence.load(std::memory_order_relaxed);
+            header.sendTimeNs = wallClockNs();
+            header.payloadLength = static_cast<uint32_t>(payload.size());
+
+            std::string packet(sizeof(header) + payload.size(), '\0');
+            std::memcpy(&packet[0], &header, sizeof(header));
+            std::memcpy(&packet[sizeof(header)], payload.data(), payload.size());
+            appendFrame(connection->out, packet);
+        }
+    }
+
+    writeNext(connection);
+}
+
+void MulticastPublisher::writeNext(const std::shared_ptr<RecoveryConnection>& connection) {
+    std::string packet;
+    while (connection->next != 0 && connection->next <= connection->last &&
+           connection->out.size() < RECOVERY_BATCH_BYTES) {
+        uint64_t sequence = connection->next++;
+        {
+            std::lock_guard<std::mutex> lock(historyMutex);
+            packet = history[sequence % history.size()];
+        }
+
+        // Slots already reused for a newer packet are skipped; the receiver counts them lost
+        MulticastPacketHeader header;
+        if (!parseMulticastPacket(packet.data(), packet.size(), header) || header.sequence != sequence) {
+            continue;
+        }
+        header.flags |= MULTICAST_FLAG_RETRANSMIT;
+        std::memcpy(&packet[0], &header, sizeof(header));
+        appendFrame(connection->out, packet);
+    }
+    if (!connection->finished && (connection->next == 0 || connection->next > connection->last)) {
+        appendFrame(connection->out, std::string());
+        connection->finished = true;
+    }
+
+    if (connection->out.empty()) {
+        // Answer complete; the client closes its end after the zero-length frame
+        connection->deadline.cancel();
+        return;
+    }
+
+    armDeadline(connection);
+    net::async_write(connection->socket, net::buffer(connection->out),
+        [this, connection](boost::system::error_code ec, std::size_t) {
+            if (ec) {
+                connection->deadline.cancel();
+                if (ec != net::error::operation_aborted) {
+                    std::cerr << "Recovery write failed: " << ec.message() << std::endl;
+                }
+                return;
+            }
+            connection->out.clear();
+            writeNext(connection);
+        });
+}
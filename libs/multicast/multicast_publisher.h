@@ -0,0 +1,142 @@
+#ifndef MULTICAST_PUBLISHER_H
+#define MULTICAST_PUBLISHER_H
+
+#include "multicast_format.h"
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/asio/ip/udp.hpp>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/asio/streambuf.hpp>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace net = boost::asio;
+
+/**
+ * @brief Configuration of the multicast publisher
+ */
+struct MulticastConfig {
+    std::string group; /**< Multicast group address, e.g. 239.255.0.1 */
+    unsigned short port = 30001; /**< Multicast destination port */
+    unsigned short recoveryPort = 30002; /**< TCP port of the retransmission/snapshot service */
+    std::string interfaceAddress; /**< Local interface address to send from (empty for the default) */
+    int ttl = 1; /**< Multicast TTL; 1 keeps packets on the local segment */
+    bool loopback = true; /**< Deliver packets to receivers on this host too */
+    std::size_t retransmitDepth = 65536; /**< Packets kept for retransmission */
+    std::chrono::milliseconds recoveryTimeout{5000}; /**< Recovery clients idle this long in a read or write are dropped */
+};
+
+/**
+ * @brief Publishes sequenced packets to a multicast group and serves recovery over TCP
+ *
+ * Egress is one datagram per message whatever the number of receivers. The
+ * last retransmitDepth packets are kept so receivers can fill gaps, and book
+ * snapshots are produced on request by a callback.
+ */
+class MulticastPublisher {
+public:
+    /**
+     * @brief Builds the snapshot of an instrument's book
+     *
+     * Receives the instrument name and a buffer for a binary protocol BOOK
+     * snapshot message; returns false if there is no book for it.
+     */
+    using SnapshotProvider = std::function<bool(const std::string&, std::string&)>;
+
+    /**
+     * @brief Construct a new MulticastPublisher object and start the recovery service
+     *
+     * @param config The configuration
+     * @param snapshotProvider Callback answering SNAPSHOT requests
+     */
+    MulticastPublisher(const MulticastConfig& config, SnapshotProvider snapshotProvider);
+
+    /**
+     * @brief Stop the recovery service
+     */
+    ~MulticastPublisher();
+
+    MulticastPublisher(const MulticastPublisher&) = delete;
+    MulticastPublisher& operator=(const MulticastPublisher&) = delete;
+
+    /**
+     * @brief Send a message to the group; only one thread may publish
+     *
+     * @param payload A binary protocol message
+     * @return false if the message does not fit in a datagram
+     */
+    bool publish(std::string_view payload);
+
+    /**
+     * @brief Get the sequence of the last published packet
+     */
+    uint64_t sequence() const { return lastSequence.load(std::memory_order_relaxed); }
+
+private:
+    /**
+     * @brief State of one recovery client, kept alive by its pending operations
+     */
+    struct RecoveryConnection {
+        explicit RecoveryConnection(net::ip::tcp::socket socket)
+            : socket(std::move(socket)), deadline(this->socket.get_executor()) {}
+
+        net::ip::tcp::socket socket; /**< The connected client */
+        net::steady_timer deadline; /**< Closes the socket when a read or write takes too long */
+        net::streambuf request; /**< Request line being read */
+        std::string out; /**< Frames being written */
+        uint64_t next = 0; /**< Next sequence to retransmit */
+        uint64_t last = 0; /**< Last sequence to retransmit */
+        bool finished = false; /**< True once the end frame is queued */
+    };
+
+    /**
+     * @brief Accept the next recovery connection
+     */
+    void doAccept();
+
+    /**
+     * @brief Restart a connection's deadline for its next read or write
+     *
+     * @param connection The recovery client
+     */
+    void armDeadline(const std::shared_ptr<RecoveryConnection>& connection);
+
+    /**
+     * @brief Parse a recovery request and start answering it
+     *
+     * @param connection The recovery client, with its request line read
+     */
+    void handleRecovery(const std::shared_ptr<RecoveryConnection>& connection);
+
+    /**
+     * @brief Write the next batch of frames, ending with the zero-length frame
+     *
+     * Retransmissions are copied out of the history a batch at a time, so a
+     * large range neither holds the history lock nor buffers every packet.
+     *
+     * @param connection The recovery client
+     */
+    void writeNext(const std::shared_ptr<RecoveryConnection>& connection);
+
+    MulticastConfig config; /**< Configuration */
+    SnapshotProvider snapshotProvider; /**< Answers SNAPSHOT requests */
+
+    net::io_context ioc; /**< IO context for both sockets */
+    net::ip::udp::socket socket; /**< Multicast sender */
+    net::ip::udp::endpoint destination; /**< Group and port */
+    net::ip::tcp::acceptor acceptor; /**< Recovery service listener */
+    std::thread recoveryThread; /**< Runs the recovery service */
+
+    std::vector<std::string> history; /**< Last packets, indexed by sequence % size */
+    std::mutex historyMutex; /**< Mutex for synchronizing access to history */
+    std::atomic<uint64_t> lastSequence{0}; /**< Sequence of the last published packet */
+};
+
+#endif // MULTICAST_PUBLISHER_H
@@ -0,0 +1,181 @@
+#include "multicast_receiver.h"
+#include <boost/asio/connect.hpp>
+#include <boost/asio/ip/multicast.hpp>
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/asio/read.hpp>
+#include <boost/asio/write.hpp>
+#include <iostream>
+
+MulticastReceiver::MulticastReceiver(const MulticastReceiverConfig& config, Handler handler)
+    : config(config)
+    , handler(std::move(handler))
+    , socket(ioc) {
+}
+
+MulticastReceiver::~MulticastReceiver() {
+    stop();
+}
+
+void MulticastReceiver::start() {
+    auto group = net::ip::make_address_v4(config.group);
+
+    socket.open(net::ip::udp::v4());
+    socket.set_option(net::socket_base::reuse_address(true));
+    socket.bind(net::ip::udp::endpoint(net::ip::address_v4::any(), config.port));
+    if (config.interfaceAddress.empty()) {
+        socket.set_option(net::ip::multicast::join_group(group));
+    } else {
+        socket.set_option(net::ip::multicast::join_group(
+            group, net::ip::make_address_v4(config.interfaceAddress)));
+    }
+
+    // A large kernel buffer absorbs bursts while a gap is being recovered
+    socket.set_option(net::socket_base::receive_buffer_size(8 * 1024 * 1024));
+
+    doReceive();
+    receiverThread = std::thread([this] { ioc.run(); });
+}
+
+void MulticastReceiver::stop() {
+    ioc.stop();
+    if (receiverThread.joinable()) {
+        receiverThread.join();
+    }
+}
+
+void MulticastReceiver::doReceive() {
+    socket.async_receive_from(
+        net::buffer(buffer), sender,
+        [this](boost::system::error_code ec, std::size_t bytes) {
+            if (ec) {
+                if (ec != net::error::operation_aborted) {
+                    std::cerr << "Multicast receive error: " << ec.message() << std::endl;
+                }
+                return;
+            }
+            onPacket(buffer.data(), bytes);
+            doReceive();
+        });
+}
+
+void MulticastReceiver::onPacket(const char* data, std::size_t size) {
+    MulticastPacketHeader header;
+    if (!parseMulticastPacket(data, size, header)) {
+        return;
+    }
+    ++receivedPackets;
+
+    if (expected != 0 && header.sequence < expected) {
+        return; // Duplicate, or already recovered over TCP
+    }
+
+    if (expected != 0 && header.sequence > expected) {
+        try {
+            for (const auto& packet : request("RETRANSMIT " + std::to_string(expected) + " " +
+                                              std::to_string(header.sequence - 1) + "\n")) {
+                MulticastPacketHeader recoveredHeader;
+                if (!parseMulticastPacket(packet.data(), packet.size(), recoveredHeader) ||
+                    recoveredHeader.sequence < expected || recoveredHeader.sequence >= header.sequence) {
+                    continue;
+                }
+                lostPackets += recoveredHeader.sequence - expected;
+                ++recoveredPackets;
+                expected = recoveredHeader.sequence + 1;
+                handler(recoveredHeader, std::string_view(packet).substr(sizeof(MulticastPacketHeader)));
+            }
+        } catch (const std::exception& e) {
+            std::cerr << "Retransmission request failed: " << e.what() << std::endl;
+        }
+        lostPackets += header.sequence - expected;
+    }
+
+    expected = header.sequence + 1;
+    handler(header, std::string_view(data + sizeof(header), header.payloadLength));
+}
+
+bool MulticastReceiver::requestSnapshot(const std::string& instrument, std::string& payload) {
+    auto packets = request("SNAPSHOT " + instrument + "\n");
+    if (packets.empty()) {
+        return false;
+    }
+
+    MulticastPacketHeader header;
+    if (!parseMulticastPacket(packets.front().data(), packets.front().size(), header)) {
+        return false;
+    }
+    payload = packets.front().substr(sizeof(header));
+    return true;
+}
+
+std::vector<std::string> MulticastReceiver::request(const std::string& line) {
+    net::io_context context;
+    net::ip::tcp::resolver resolver(context);
+    net::ip::tcp::socket connection(context);
+
+    std::vector<std::string> packets;
+    std::string packet;
+    uint32_t length = 0;
+    boost::system::error_code result;
+    bool complete = false;
+
+    std::function<void()> readNext = [&]() {
+        net::async_read(connection, net::buffer(&length, sizeof(length)),
+            [&](boost::system::error_code ec, std::size_t) {
+                if (ec) {
+                    result = ec;
+                    return;
+                }
+                if (length == 0) {
+                    complete = true;
+                    return;
+                }
+                packet.assign(length, '\0');
+                net::async_read(connection, net::buffer(&packet[0], length),
+                    [&](boost::system::error_code ec, std::size_t) {
+                        if (ec) {
+                            result = ec;
+                            return;
+                        }
+                        packets.push_back(std::move(packet));
+                        readNext();
+                    });
+            });
+    };
+
+    resolver.async_resolve(config.recoveryHost, std::to_string(config.recoveryPort),
+        [&](boost::system::error_code ec, net::ip::tcp::resolver::results_type endpoints) {
+            if (ec) {
+                result = ec;
+                return;
+            }
+            net::async_connect(connection, endpoints,
+                [&](boost::system::error_code ec, const net::ip::tcp::endpoint&) {
+                    if (ec) {
+                        result = ec;
+                        return;
+                    }
+                    net::async_write(connection, net::buffer(line),
+                        [&](boost::system::error_code ec, std::size_t) {
+                            if (ec) {
+                                result = ec;
+                                return;
+                            }
+                            readNext();
+                        });
+                });
+        });
+
+    // The context runs out of work when the exchange ends; still busy at the deadline means timed out
+    context.run_for(config.recoveryTimeout);
+    if (!context.stopped()) {
+        boost::system::error_code closeError;
+        resolver.cancel();
+        connection.close(closeError);
+        context.run(); // Completes the cancelled operations before the locals they reference go away
+        throw boost::system::system_error(net::error::timed_out);
+    }
+    if (!complete) {
+        throw boost::system::system_error(result);
+    }
+    return packets;
+}
@@ -0,0 +1,137 @@
+#ifndef MULTICAST_RECEIVER_H
+#define MULTICAST_RECEIVER_H
+
+#include "multicast_format.h"
+#include <boost/asio/ip/udp.hpp>
+#include <boost/asio/io_context.hpp>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace net = boost::asio;
+
+/**
+ * @brief Configuration of a multicast receiver
+ */
+struct MulticastReceiverConfig {
+    std::string group; /**< Multicast group address */
+    unsigned short port = 30001; /**< Multicast port */
+    std::string interfaceAddress; /**< Local interface to join on (empty for the default) */
+    std::string recoveryHost; /**< Host of the publisher's recovery service */
+    unsigned short recoveryPort = 30002; /**< Port of the publisher's recovery service */
+    std::chrono::milliseconds recoveryTimeout{2000}; /**< Deadline of one recovery request, connect included */
+};
+
+/**
+ * @brief Joins a market data group and delivers packets in sequence order
+ *
+ * When a packet arrives ahead of the expected sequence, the missing range is
+ * fetched from the publisher's recovery service before the packet is
+ * delivered; packets the publisher no longer holds are counted as lost.
+ * Packets are delivered on the receiver's thread.
+ */
+class MulticastReceiver {
+public:
+    /**
+     * @brief Called per delivered packet with its header and binary protocol payload
+     */
+    using Handler = std::function<void(const MulticastPacketHeader&, std::string_view)>;
+
+    /**
+     * @brief Construct a new MulticastReceiver object
+     *
+     * @param config The configuration
+     * @param handler Called for every delivered packet
+     */
+    MulticastReceiver(const MulticastReceiverConfig& config, Handler handler);
+
+    /**
+     * @brief Stop receiving
+     */
+    ~MulticastReceiver();
+
+    MulticastReceiver(const MulticastReceiver&) = delete;
+    MulticastReceiver& operator=(const MulticastReceiver&) = delete;
+
+    /**
+     * @brief Join the group and start the receiver thread
+     */
+    void start();
+
+    /**
+     * @brief Stop the receiver thread
+     */
+    void stop();
+
+    /**
+     * @brief Fetch the current book of an instrument from the recovery service
+     *
+     * @param instrument The instrument name
+     * @param payload Receives the binary protocol BOOK snapshot
+     * @return true if the publisher had a book for the instrument
+     */
+    bool requestSnapshot(const std::string& instrument, std::string& payload);
+
+    /**
+     * @brief Get the number of packets received over multicast
+     */
+    uint64_t received() const { return receivedPackets; }
+
+    /**
+     * @brief Get the number of packets recovered over TCP
+     */
+    uint64_t recovered() const { return recoveredPackets; }
+
+    /**
+     * @brief Get the number of packets that could not be recovered
+     */
+    uint64_t lost() const { return lostPackets; }
+
+private:
+    /**
+     * @brief Receive the next datagram
+     */
+    void doReceive();
+
+    /**
+     * @brief Deliver a datagram, recovering any gap before it
+     *
+     * @param data The datagram
+     * @param size Size of the datagram
+     */
+    void onPacket(const char* data, std::size_t size);
+
+    /**
+     * @brief Send one request line to the recovery service and collect the packets returned
+     *
+     * The exchange runs asynchronously on a private context until
+     * recoveryTimeout, so a stalled publisher holds up delivery for at most
+     * that long.
+     *
+     * @param line The request line
+     * @return std::vector<std::string> The packets, in the order sent
+     * @throws boost::system::system_error if the request fails or times out
+     */
+    std::vector<std::string> request(const std::string& line);
+
+    MulticastReceiverConfig config; /**< Configuration */
+    Handler handler; /**< Receives delivered packets */
+
+    net::io_context ioc; /**< IO context for the receiver thread */
+    net::ip::udp::socket socket; /**< Group member socket */
+    net::ip::udp::endpoint sender; /**< Sender of the last datagram */
+    std::array<char, MULTICAST_MAX_PACKET> buffer; /**< Receive buffer */
+    std::thread receiverThread; /**< Runs doReceive */
+
+    uint64_t expected = 0; /**< Next sequence to deliver (0 until the first packet) */
+    std::atomic<uint64_t> receivedPackets{0}; /**< Packets received over multicast */
+    std::atomic<uint64_t> recoveredPackets{0}; /**< Packets recovered over TCP */
+    std::atomic<uint64_t> lostPackets{0}; /**< Packets neither received nor recovered */
+};
+
+#endif // MULTICAST_RECEIVER_H
@@ -0,0 +1,325 @@
+#include "option_chain.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace {
+    constexpr double MS_PER_YEAR = 365.0 * 24 * 3600 * 1000;
+    constexpr double INV_SQRT_2PI = 0.3989422804014327;
+    constexpr double MIN_VOL = 1e-4;
+    constexpr double MAX_VOL = 10.0;
+    constexpr double PRICE_TOLERANCE = 1e-9; /**< Relative to the time value */
+    constexpr int MAX_ITERATIONS = 40;
+
+#if defined(__SSE2__)
+    // Two instruments per register; masks are all-ones lanes, as SSE2 compares produce them
+    constexpr std::size_t LANES = 2;
+    struct Vec { __m128d v; };
+    using Mask = Vec;
+
+    inline Vec load(const double* p) { return {_mm_loadu_pd(p)}; }
+    inline void store(double* p, Vec a) { _mm_storeu_pd(p, a.v); }
+    inline Vec broadcast(double x) { return {_mm_set1_pd(x)}; }
+    inline Vec operator+(Vec a, Vec b) { return {_mm_add_pd(a.v, b.v)}; }
+    inline Vec operator-(Vec a, Vec b) { return {_mm_sub_pd(a.v, b.v)}; }
+    inline Vec operator*(Vec a, Vec b) { return {_mm_mul_pd(a.v, b.v)}; }
+    inline Vec operator/(Vec a, Vec b) { return {_mm_div_pd(a.v, b.v)}; }
+    inline Vec sqrt(Vec a) { return {_mm_sqrt_pd(a.v)}; }
+    inline Vec abs(Vec a) { return {_mm_andnot_pd(_mm_set1_pd(-0.0), a.v)}; }
+    inline Mask operator<(Vec a, Vec b) { return {_mm_cmplt_pd(a.v, b.v)}; }
+    inline Mask operator>(Vec a, Vec b) { return {_mm_cmpgt_pd(a.v, b.v)}; }
+    inline Mask operator&&(Mask a, Mask b) { return {_mm_and_pd(a.v, b.v)}; }
+    inline Vec select(Mask m, Vec a, Vec b) { return {_mm_or_pd(_mm_and_pd(m.v, a.v), _mm_andnot_pd(m.v, b.v))}; }
+    inline bool all(Mask m) { return _mm_movemask_pd(m.v) == 3; }
+
+    // Cephes exp: x = n ln2 + r, e^r from a Pade form, 2^n built in the exponent bits
+    inline Vec exp(Vec x) {
+        x = {_mm_max_pd(_mm_min_pd(x.v, _mm_set1_pd(708.0)), _mm_set1_pd(-708.0))};
+        __m128i n = _mm_cvtpd_epi32((x * broadcast(1.4426950408889634)).v);
+        Vec nd = {_mm_cvtepi32_pd(n)};
+        x = x - nd * broadcast(6.93145751953125e-1) - nd * broadcast(1.42860682030941723212e-6);
+
+        Vec xx = x * x;
+        Vec px = x * ((broadcast(1.26177193074810590878e-4) * xx + broadcast(3.02994407707441961300e-2)) * xx +
+                      broadcast(9.99999999999999999910e-1));
+        Vec qx = ((broadcast(3.00198505138664455042e-6) * xx + broadcast(2.52448340349684104192e-3)) * xx +
+                  broadcast(2.27265548208155028766e-1)) * xx + broadcast(2.00000000000000000009e0);
+        x = broadcast(1.0) + broadcast(2.0) * (px / (qx - px));
+
+        __m128i biased = _mm_add_epi32(n, _mm_set1_epi32(1023));
+        __m128i bits = _mm_slli_epi64(_mm_unpacklo_epi32(biased, _mm_setzero_si128()), 52);
+        return x * Vec{_mm_castsi128_pd(bits)};
+    }
+#else
+    constexpr std::size_t LANES = 1;
+    struct Vec { double v; };
+    struct Mask { bool v; };
+
+    inline Vec load(const double* p) { return {*p}; }
+    inline void store(double* p, Vec a) { *p = a.v; }
+    inline Vec broadcast(double x) { return {x}; }
+    inline Vec operator+(Vec a, Vec b) { return {a.v + b.v}; }
+    inline Vec operator-(Vec a, Vec b) { return {a.v - b.v}; }
+    inline Vec operator*(Vec a, Vec b) { return {a.v * b.v}; }
+    inline Vec operator/(Vec a, Vec b) { return {a.v / b.v}; }
+    inline Vec sqrt(Vec a) { return {std::sqrt(a.v)}; }
+    inline Vec abs(Vec a) { return {std::fabs(a.v)}; }
+    inline Mask operator<(Vec a, Vec b) { return {a.v < b.v}; }
+    inline Mask operator>(Vec a, Vec b) { return {a.v > b.v}; }
+    inline Mask operator&&(Mask a, Mask b) { return {a.v && b.v}; }
+    inline Vec select(Mask m, Vec a, Vec b) { return m.v ? a : b; }
+    inline bool all(Mask m) { return m.v; }
+    inline Vec exp(Vec x) { return {std::exp(x.v)}; }
+#endif
+
+    inline Vec normalPdf(Vec x) {
+        return broadcast(INV_SQRT_2PI) * exp(broadcast(-0.5) * x * x);
+    }
+
+    // Hart's approximation (West, 2005): absolute error near double precision, relative error below 1e-8 in the far tails
+    inline Vec normalCdf(Vec x) {
+        Vec a = abs(x);
+        Vec e = exp(broadcast(-0.5) * a * a);
+
+        Vec num = broadcast(3.52624965998911e-02) * a + broadcast(0.700383064443688);
+        num = num * a + broadcast(6.37396220353165);
+        num = num * a + broadcast(33.912866078383);
+        num = num * a + broadcast(112.079291497871);
+        num = num * a + broadcast(221.213596169931);
+        num = num * a + broadcast(220.206867912376);
+        Vec den = broadcast(8.83883476483184e-02) * a + broadcast(1.75566716318264);
+        den = den * a + broadcast(16.064177579207);
+        den = den * a + broadcast(86.7807322029461);
+        den = den * a + broadcast(296.564248779674);
+        den = den * a + broadcast(637.333633378831);
+        den = den * a + broadcast(793.826512519948);
+        den = den * a + broadcast(440.413735824752);
+        Vec near = e * num / den;
+
+        // Continued fraction evaluated from its innermost term, a + 0.65, outwards
+        Vec fraction = a + broadcast(0.65);
+        fraction = a + broadcast(4.0) / fraction;
+        fraction = a + broadcast(3.0) / fraction;
+        fraction = a + broadcast(2.0) / fraction;
+        fraction = a + broadcast(1.0) / fraction;
+        Vec far = e / fraction / broadcast(2.506628274631);
+
+        Vec tail = select(a < broadcast(7.07106781186547), near, far);
+        tail = select(a > broadcast(37.0), broadcast(0.0), tail);
+        return select(x > broadcast(0.0), broadcast(1.0) - tail, tail);
+    }
+
+    /**
+     * @brief Instruments of one recompute, packed contiguously and padded to whole lanes
+     */
+    struct Batch {
+        std::vector<double> forward, strike, sign, target, logMoneyness, sqrtYears, sigma;
+
+        void resize(std::size_t count) {
+            for (auto* column : {&forward, &strike, &sign, &target, &logMoneyness, &sqrtYears, &sigma}) {
+                column->assign(count, 0.0);
+            }
+        }
+    };
+
+    // Price of a call (sign 1) or put (sign -1) and its vega; the sign flip keeps deep tails exact
+    inline void black(Vec forward, Vec strike, Vec sign, Vec logMoneyness, Vec sqrtYears, Vec sigma,
+                      Vec& price, Vec& vega) {
+        Vec spread = sigma * sqrtYears;
+        Vec d1 = (logMoneyness + broadcast(0.5) * spread * spread) / spread;
+        Vec d2 = d1 - spread;
+        price = sign * (forward * normalCdf(sign * d1) - strike * normalCdf(sign * d2));
+        vega = forward * normalPdf(d1) * sqrtYears;
+    }
+
+    void solve(Batch& batch, std::size_t i) {
+        Vec forward = load(&batch.forward[i]);
+        Vec strike = load(&batch.strike[i]);
+        Vec sign = load(&batch.sign[i]);
+        Vec target = load(&batch.target[i]);
+        Vec logMoneyness = load(&batch.logMoneyness[i]);
+        Vec sqrtYears = load(&batch.sqrtYears[i]);
+        Vec tolerance = target * broadcast(PRICE_TOLERANCE);
+
+        // Brenner-Subrahmanyam start, then Newton kept inside each lane's bisection bracket
+        Vec sigma = broadcast(2.5066282746310002) * target / (forward * sqrtYears);
+        sigma = select(sigma > broadcast(0.01), sigma, broadcast(0.01));
+        sigma = select(sigma < broadcast(4.0), sigma, broadcast(4.0));
+        Vec low = broadcast(MIN_VOL);
+        Vec high = broadcast(MAX_VOL);
+
+        for (int iteration = 0; iteration < MAX_ITERATIONS; ++iteration) {
+            Vec price, vega;
+            black(forward, strike, sign, logMoneyness, sqrtYears, sigma, price, vega);
+            Vec diff = price - target;
+            Mask converged = abs(diff) < tolerance;
+            if (all(converged)) {
+                break;
+            }
+
+            Mask above = diff > broadcast(0.0);
+            high = select(above, sigma, high);
+            low = select(above, low, sigma);
+            Vec newton = sigma - diff / vega;
+            Mask inside = newton > low && newton < high;
+            Vec next = select(inside, newton, broadcast(0.5) * (low + high));
+            sigma = select(converged, sigma, next);
+        }
+        store(&batch.sigma[i], sigma);
+    }
+}
+
+std::size_t OptionChain::add(const std::string& name, double strike, int64_t expiryMs, bool call) {
+    auto it = indices.find(name);
+    if (it != indices.end()) {
+        return it->second;
+    }
+
+    auto index = static_cast<uint32_t>(names.size());
+    indices.emplace(name, index);
+    names.push_back(name);
+    strikes.push_back(strike);
+    expiries.push_back(expiryMs);
+    calls.push_back(call ? 1 : 0);
+    forwards.push_back(0);
+    prices.push_back(0);
+    for (auto* column : {&ivs, &deltas, &gammas, &vegas, &thetas}) {
+        column->push_back(std::numeric_limits<double>::quiet_NaN());
+    }
+    isDirty.push_back(0);
+    return index;
+}
+
+bool OptionChain::find(const std::string& name, std::size_t& index) const {
+    auto it = indices.find(name);
+    if (it == indices.end()) {
+        return false;
+    }
+    index = it->second;
+    return true;
+}
+
+void OptionChain::markDirty(std::size_t index) {
+    if (!isDirty[index]) {
+        isDirty[index] = 1;
+        dirty.push_back(static_cast<uint32_t>(index));
+    }
+}
+
+void OptionChain::setForward(std::size_t index, double forward) {
+    if (forwards[index] != forward) {
+        forwards[index] = forward;
+        markDirty(index);
+    }
+}
+
+void OptionChain::setForwardAll(double forward) {
+    for (std::size_t i = 0; i < forwards.size(); ++i) {
+        setForward(i, forward);
+    }
+}
+
+void OptionChain::setPrice(std::size_t index, double price) {
+    if (prices[index] != price) {
+        prices[index] = price;
+        markDirty(index);
+    }
+}
+
+const std::vector<uint32_t>& OptionChain::recompute(int64_t nowMs) {
+    done.swap(dirty);
+    dirty.clear();
+
+    // Solvable instruments are packed into the batch; the rest get NaN straight away
+    std::vector<uint32_t> solved;
+    solved.reserve(done.size());
+    Batch batch;
+    batch.resize((done.size() + LANES - 1) / LANES * LANES);
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+
+    for (uint32_t index : done) {
+        isDirty[index] = 0;
+        double forward = forwards[index];
+        double strike = strikes[index];
+        double years = (expiries[index] - nowMs) / MS_PER_YEAR;
+
+        // Parity turns the price into the out-of-the-money option's, which is all time value
+        bool solveCall = strike >= forward;
+        double intrinsic = calls[index] ? forward - strike : strike - forward;
+        double timeValue = prices[index] * forward - std::max(intrinsic, 0.0);
+        double bound = solveCall ? forward : strike;
+
+        if (forward <= 0 || strike <= 0 || years <= 0 || timeValue <= 0 || timeValue >= bound) {
+            ivs[index] = deltas[index] = gammas[index] = vegas[index] = thetas[index] = nan;
+            continue;
+        }
+
+        std::size_t slot = solved.size();
+        solved.push_back(index);
+        batch.forward[slot] = forward;
+        batch.strike[slot] = strike;
+        batch.sign[slot] = solveCall ? 1.0 : -1.0;
+        batch.target[slot] = timeValue;
+        batch.logMoneyness[slot] = std::log(forward / strike);
+        batch.sqrtYears[slot] = std::sqrt(years);
+    }
+
+    // Padding lanes solve a harmless at-the-money option
+    std::size_t lanes = (solved.size() + LANES - 1) / LANES * LANES;
+    for (std::size_t slot = solved.size(); slot < lanes; ++slot) {
+        batch.forward[slot] = batch.strike[slot] = batch.sign[slot] = batch.sqrtYears[slot] = 1.0;
+        batch.target[slot] = 0.1;
+    }
+
+    for (std::size_t i = 0; i < lanes; i += LANES) {
+        solve(batch, i);
+    }
+
+    // Greeks of the instrument as listed, whichever side the volatility was solved on
+    for (std::size_t i = 0; i < lanes; i += LANES) {
+        Vec forward = load(&batch.forward[i]);
+        Vec sqrtYears = load(&batch.sqrtYears[i]);
+        Vec sigma = load(&batch.sigma[i]);
+        Vec spread = sigma * sqrtYears;
+        Vec d1 = (load(&batch.logMoneyness[i]) + broadcast(0.5) * spread * spread) / spread;
+        Vec pdf = normalPdf(d1);
+
+        double cdf[LANES], gamma[LANES], vega[LANES], theta[LANES];
+        store(cdf, normalCdf(d1));
+        store(gamma, pdf / (forward * spread));
+        store(vega, forward * pdf * sqrtYears / broadcast(100.0));
+        store(theta, broadcast(-0.5 / 365.0) * forward * pdf * sigma / sqrtYears);
+
+        for (std::size_t lane = 0; lane < LANES && i + lane < solved.size(); ++lane) {
+            uint32_t index = solved[i + lane];
+            ivs[index] = batch.sigma[i + lane];
+            deltas[index] = calls[index] ? cdf[lane] : cdf[lane] - 1.0;
+            gammas[index] = gamma[lane];
+            vegas[index] = vega[lane];
+            thetas[index] = theta[lane];
+        }
+    }
+    return done;
+}
+
+OptionChain::Greeks OptionChain::greeks(std::size_t index) const {
+    return {ivs[index], deltas[index], gammas[index], vegas[index], thetas[index]};
+}
+
+json OptionChain::toJson(std::size_t index) const {
+    // NaN results serialize as null
+    return json{
+        {"instrument_name", names[index]},
+        {"underlying_price", forwards[index]},
+        {"price", prices[index]},
+        {"iv", ivs[index]},
+        {"delta", deltas[index]},
+        {"gamma", gammas[index]},
+        {"vega", vegas[index]},
+        {"theta", thetas[index]}
+    };
+}
@@ -0,0 +1,151 @@
+#ifndef OPTION_CHAIN_H
+#define OPTION_CHAIN_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+using json = nlohmann::json;
+
+/**
+ * @brief Implied volatility and greeks of an option chain under Black-76
+ *
+ * Instruments live in structure-of-arrays form: one contiguous array per
+ * input and per output, indexed by the instrument's position in the chain.
+ * Setting an input marks the instrument dirty; recompute() solves only the
+ * dirty instruments. It packs their inputs into lanes, runs the solver and
+ * the greeks two instruments per SSE2 instruction, and scatters the results
+ * back.
+ *
+ * Prices are in the underlying currency, as Deribit quotes options, and are
+ * converted with the forward. Rates are taken as zero, since the forward
+ * already carries the cost of carry. Time to expiry is refreshed only when
+ * an instrument is recomputed.
+ *
+ * The implied volatility comes from the out-of-the-money side of put-call
+ * parity. A safeguarded Newton iteration keeps each lane inside its own
+ * bisection bracket. An instrument whose price has no solution, or that
+ * has expired, gets NaN results.
+ */
+class OptionChain {
+public:
+    /**
+     * @brief Results of one instrument
+     */
+    struct Greeks {
+        double iv; /**< Implied volatility, 0.5 for 50% */
+        double delta; /**< Change of the price per unit of the forward */
+        double gamma; /**< Change of delta per unit of the forward */
+        double vega; /**< Change of the USD price per volatility point */
+        double theta; /**< Change of the USD price per day */
+    };
+
+    /**
+     * @brief Add an instrument, or find it if already added
+     *
+     * @param name The instrument name
+     * @param strike The strike price
+     * @param expiryMs The expiration timestamp in milliseconds
+     * @param call True for a call, false for a put
+     * @return std::size_t The instrument index
+     */
+    std::size_t add(const std::string& name, double strike, int64_t expiryMs, bool call);
+
+    /**
+     * @brief Find an instrument
+     *
+     * @param name The instrument name
+     * @param index Receives the instrument index
+     * @return true if the instrument is in the chain
+     */
+    bool find(const std::string& name, std::size_t& index) const;
+
+    /**
+     * @brief Set the forward of an instrument, marking it dirty if it changed
+     *
+     * @param index The instrument index
+     * @param forward The underlying price for the instrument's expiry
+     */
+    void setForward(std::size_t index, double forward);
+
+    /**
+     * @brief Set the forward of every instrument, marking those it changed dirty
+     *
+     * @param forward The underlying price
+     */
+    void setForwardAll(double forward);
+
+    /**
+     * @brief Set the option price of an instrument, marking it dirty if it changed
+     *
+     * @param index The instrument index
+     * @param price The option price in the underlying currency
+     */
+    void setPrice(std::size_t index, double price);
+
+    /**
+     * @brief Recompute the dirty instruments
+     *
+     * @param nowMs The current time in milliseconds, for the time to expiry
+     * @return const std::vector<uint32_t>& The instruments recomputed, valid until the next call
+     */
+    const std::vector<uint32_t>& recompute(int64_t nowMs);
+
+    /**
+     * @brief Get the number of instruments
+     */
+    std::size_t size() const { return names.size(); }
+
+    /**
+     * @brief Get the number of dirty instruments
+     */
+    std::size_t pending() const { return dirty.size(); }
+
+    /**
+     * @brief Get the name of an instrument
+     */
+    const std::string& name(std::size_t index) const { return names[index]; }
+
+    /**
+     * @brief Get the results of an instrument
+     */
+    Greeks greeks(std::size_t index) const;
+
+    /**
+     * @brief Serialize the inputs and results of an instrument
+     *
+     * @param index The instrument index
+     * @return json Object with instrument_name, the inputs and the results (null when unsolved)
+     */
+    json toJson(std::size_t index) const;
+
+private:
+    /**
+     * @brief Mark an instrument dirty once
+     */
+    void markDirty(std::size_t index);
+
+    std::unordered_map<std::string, uint32_t> indices; /**< Instrument indices by name */
+    std::vector<std::string> names; /**< Instrument names */
+
+    std::vector<double> strikes; /**< Strike by instrument */
+    std::vector<int64_t> expiries; /**< Expiration timestamp in milliseconds by instrument */
+    std::vector<uint8_t> calls; /**< 1 for calls, 0 for puts */
+    std::vector<double> forwards; /**< Forward by instrument, 0 until known */
+    std::vector<double> prices; /**< Option price in the underlying currency, 0 until known */
+
+    std::vector<double> ivs; /**< Implied volatility by instrument */
+    std::vector<double> deltas; /**< Delta by instrument */
+    std::vector<double> gammas; /**< Gamma by instrument */
+    std::vector<double> vegas; /**< Vega by instrument */
+    std::vector<double> thetas; /**< Theta by instrument */
+
+    std::vector<uint8_t> isDirty; /**< 1 while the instrument is in dirty */
+    std::vector<uint32_t> dirty; /**< Instruments with changed inputs */
+    std::vector<uint32_t> done; /**< Instruments recomputed by the last recompute() */
+};
+
+#endif // OPTION_CHAIN_H
@@ -0,0 +1,76 @@
+#include "circuit_breaker.h"
+#include <iostream>
+
+CircuitBreaker::CircuitBreaker(const Config& config)
+    : config(config) {
+}
+
+bool CircuitBreaker::allowRequest() {
+    std::lock_guard<std::mutex> lock(mutex);
+    switch (current) {
+        case State::CLOSED:
+            return true;
+        case State::OPEN:
+            if (std::chrono::steady_clock::now() - openedAt < config.coolDown) {
+                return false;
+            }
+            current = State::HALF_OPEN;
+            probing = true;
+            return true;
+        case State::HALF_OPEN:
+            if (probing) {
+                return false;
+            }
+            probing = true;
+            return true;
+    }
+    return false;
+}
+
+void CircuitBreaker::record(bool succeeded, std::chrono::steady_clock::duration latency) {
+    bool failed = !succeeded || latency > config.slowThreshold;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (current == State::HALF_OPEN) {
+        probing = false;
+        if (failed) {
+            current = State::OPEN;
+            openedAt = std::chrono::steady_clock::now();
+        } else {
+            std::cout << "REST circuit closed after a successful probe" << std::endl;
+            current = State::CLOSED;
+            outcomes.clear();
+            failures = 0;
+        }
+        return;
+    }
+
+    outcomes.push_back(failed);
+    failures += failed;
+    if (outcomes.size() > config.window) {
+        failures -= outcomes.front();
+        outcomes.pop_front();
+    }
+
+    if (current == State::CLOSED && outcomes.size() >= config.minSamples &&
+        failures >= config.failureRatio * outcomes.size()) {
+        std::cerr << "REST circuit opened: " << failures << " of the last " << outcomes.size()
+                  << " requests failed or were slow" << std::endl;
+        current = State::OPEN;
+        openedAt = std::chrono::steady_clock::now();
+    }
+}
+
+CircuitBreaker::State CircuitBreaker::state() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return current;
+}
+
+const char* CircuitBreaker::describe(State state) {
+    switch (state) {
+        case State::CLOSED: return "closed";
+        case State::OPEN: return "open";
+        case State::HALF_OPEN: return "half-open";
+    }
+    return "unknown";
+}
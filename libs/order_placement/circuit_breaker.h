@@ -0,0 +1,92 @@
+#ifndef CIRCUIT_BREAKER_H
+#define CIRCUIT_BREAKER_H
+
+#include <chrono>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+
+/**
+ * @brief Circuit breaker over the outcomes of recent requests on one transport
+ *
+ * The breaker keeps the outcomes of the last requests in a window. A request
+ * counts as failed if it errored or was slower than the slow threshold. Once
+ * the window holds enough samples and the failed share reaches the failure
+ * ratio, the breaker opens and requests are refused. After the cool-down it
+ * is half open: a single probe request is allowed. If the probe succeeds
+ * the breaker closes with an empty window; if it fails the breaker opens
+ * again.
+ */
+class CircuitBreaker {
+public:
+    /**
+     * @brief Breaker state
+     */
+    enum class State {
+        CLOSED, /**< Requests flow */
+        OPEN, /**< Requests are refused until the cool-down ends */
+        HALF_OPEN /**< One probe request decides whether to close */
+    };
+
+    /**
+     * @brief Breaker settings
+     */
+    struct Config {
+        std::size_t window = 20; /**< Outcomes kept */
+        std::size_t minSamples = 5; /**< Outcomes needed before the breaker can open */
+        double failureRatio = 0.5; /**< Failed share of the window that opens the breaker */
+        std::chrono::milliseconds slowThreshold{2000}; /**< Latency counted as a failure */
+        std::chrono::milliseconds coolDown{5000}; /**< Time open before a probe */
+    };
+
+    /**
+     * @brief Construct a new CircuitBreaker object
+     *
+     * @param config The settings
+     */
+    explicit CircuitBreaker(const Config& config);
+
+    /**
+     * @brief Decide whether a request may be sent now
+     *
+     * In the half-open state the first caller gets the probe; it must
+     * report the outcome with record().
+     *
+     * @return true to send, false to fail fast or fail over
+     */
+    bool allowRequest();
+
+    /**
+     * @brief Report the outcome of an allowed request
+     *
+     * @param succeeded False for a transport failure
+     * @param latency Time the request took
+     */
+    void record(bool succeeded, std::chrono::steady_clock::duration latency);
+
+    /**
+     * @brief Get the current state
+     *
+     * @return State The state
+     */
+    State state();
+
+    /**
+     * @brief Describe a state
+     *
+     * @param state The state
+     * @return const char* "closed", "open" or "half-open"
+     */
+    static const char* describe(State state);
+
+private:
+    Config config; /**< The settings */
+    State current = State::CLOSED; /**< The state */
+    std::deque<bool> outcomes; /**< Recent outcomes, true for a failure */
+    std::size_t failures = 0; /**< Failures in outcomes */
+    std::chrono::steady_clock::time_point openedAt; /**< When the breaker last opened */
+    bool probing = false; /**< True while the half-open probe is in flight */
+    std::mutex mutex; /**< Mutex for synchronizing access to the state */
+};
+
+#endif // CIRCUIT_BREAKER_H
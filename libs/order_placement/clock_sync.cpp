@@ -0,0 +1,107 @@
+#include "clock_sync.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <vector>
+
+ClockSync::ClockSync(std::size_t window)
+    : window(std::max<std::size_t>(window, 1)) {
+}
+
+int64_t ClockSync::nowUs() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+void ClockSync::addSample(int64_t sentUs, int64_t exchangeInUs, int64_t exchangeOutUs, int64_t receivedUs) {
+    Sample sample;
+    sample.localUs = sentUs + (receivedUs - sentUs) / 2;
+    sample.offsetUs = ((exchangeInUs - sentUs) + (exchangeOutUs - receivedUs)) / 2.0;
+    sample.roundTripUs = std::max<int64_t>(0, (receivedUs - sentUs) - (exchangeOutUs - exchangeInUs));
+
+    std::lock_guard<std::mutex> lock(mutex);
+    samples.push_back(sample);
+    if (samples.size() > window) {
+        samples.pop_front();
+    }
+    refit();
+}
+
+void ClockSync::refit() {
+    // The faster half of the window; slow samples carry asymmetric queueing
+    std::vector<Sample> best(samples.begin(), samples.end());
+    std::sort(best.begin(), best.end(), [](const Sample& a, const Sample& b) {
+        return a.roundTripUs < b.roundTripUs;
+    });
+    bestRoundTripUs = best.front().roundTripUs;
+    best.resize((best.size() + 1) / 2);
+
+    double meanLocal = 0;
+    double meanOffset = 0;
+    for (const auto& sample : best) {
+        meanLocal += sample.localUs - best.front().localUs;
+        meanOffset += sample.offsetUs;
+    }
+    meanLocal /= best.size();
+    meanOffset /= best.size();
+
+    double covariance = 0;
+    double variance = 0;
+    for (const auto& sample : best) {
+        double x = sample.localUs - best.front().localUs - meanLocal;
+        covariance += x * (sample.offsetUs - meanOffset);
+        variance += x * x;
+    }
+
+    // Drift needs samples spread over time; until then the offset is taken as constant
+    baseLocalUs = best.front().localUs + static_cast<int64_t>(meanLocal);
+    baseOffsetUs = meanOffset;
+    drift = variance > 0 ? covariance / variance : 0;
+}
+
+double ClockSync::offsetAtLocked(int64_t localUs) const {
+    return baseOffsetUs + drift * (localUs - baseLocalUs);
+}
+
+ClockSync::Split ClockSync::recordRequest(int64_t sentUs, int64_t exchangeInUs, int64_t exchangeOutUs,
+                                          int64_t receivedUs) {
+    Split split;
+    split.exchangeUs = exchangeOutUs - exchangeInUs;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    addLatency(exchange, split.exchangeUs);
+    if (samples.empty()) {
+        return split;
+    }
+
+    // Estimation error can push a short leg below zero; it is reported as 0
+    auto arrived = static_cast<int64_t>(std::llround(exchangeInUs - offsetAtLocked(sentUs)));
+    auto replied = static_cast<int64_t>(std::llround(exchangeOutUs - offsetAtLocked(receivedUs)));
+    split.outboundUs = std::max<int64_t>(0, arrived - sentUs);
+    split.inboundUs = std::max<int64_t>(0, receivedUs - replied);
+    addLatency(outbound, split.outboundUs);
+    addLatency(inbound, split.inboundUs);
+    return split;
+}
+
+void ClockSync::addLatency(LegStats& leg, int64_t latencyUs) {
+    leg.lastUs = latencyUs;
+    leg.minUs = leg.count ? std::min(leg.minUs, latencyUs) : latencyUs;
+    leg.maxUs = leg.count ? std::max(leg.maxUs, latencyUs) : latencyUs;
+    leg.totalUs += latencyUs;
+    ++leg.count;
+}
+
+ClockSync::Snapshot ClockSync::snapshot() {
+    std::lock_guard<std::mutex> lock(mutex);
+    Snapshot result;
+    result.synced = !samples.empty();
+    result.samples = samples.size();
+    result.offsetUs = result.synced ? offsetAtLocked(nowUs()) : 0;
+    result.driftPpm = drift * 1e6;
+    result.bestRoundTripUs = bestRoundTripUs;
+    result.outbound = outbound;
+    result.exchange = exchange;
+    result.inbound = inbound;
+    return result;
+}
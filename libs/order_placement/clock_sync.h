@@ -0,0 +1,142 @@
+#ifndef CLOCK_SYNC_H
+#define CLOCK_SYNC_H
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+
+/**
+ * @brief Estimate of the exchange clock, and request latencies split with it
+ *
+ * Each sample is a request whose sent and received times are read on the
+ * local clock and whose usIn and usOut Deribit stamped on its own clock.
+ * As in NTP, the sample's offset is ((usIn - sent) + (usOut - received)) / 2
+ * and its round trip is the elapsed time minus the time spent in the exchange.
+ *
+ * The estimate uses the recent samples with the lowest round trips, since
+ * those are the least skewed by queueing. A least-squares line through them
+ * gives the offset and its drift. With that estimate, a request's latency
+ * splits into outbound network, exchange processing and return network.
+ *
+ * Times are microseconds since the Unix epoch.
+ */
+class ClockSync {
+public:
+    /**
+     * @brief Latency of one request, split by leg
+     */
+    struct Split {
+        int64_t outboundUs = 0; /**< Local send to exchange receipt */
+        int64_t exchangeUs = 0; /**< Exchange receipt to exchange reply */
+        int64_t inboundUs = 0; /**< Exchange reply to local receipt */
+    };
+
+    /**
+     * @brief Running figures of one leg
+     */
+    struct LegStats {
+        uint64_t count = 0; /**< Requests measured */
+        int64_t lastUs = 0; /**< Latest latency */
+        int64_t minUs = 0; /**< Lowest latency */
+        int64_t maxUs = 0; /**< Highest latency */
+        double totalUs = 0; /**< Sum of latencies, for the mean */
+    };
+
+    /**
+     * @brief Current estimate and leg figures
+     */
+    struct Snapshot {
+        bool synced = false; /**< False until the first sample */
+        std::size_t samples = 0; /**< Samples in the window */
+        double offsetUs = 0; /**< Exchange clock minus local clock, now */
+        double driftPpm = 0; /**< Rate the offset changes, in parts per million */
+        int64_t bestRoundTripUs = 0; /**< Lowest round trip in the window */
+        LegStats outbound; /**< Local send to exchange receipt */
+        LegStats exchange; /**< Exchange processing */
+        LegStats inbound; /**< Exchange reply to local receipt */
+    };
+
+    /**
+     * @brief Construct a new ClockSync object
+     *
+     * @param window Samples kept for the estimate
+     */
+    explicit ClockSync(std::size_t window = 32);
+
+    /**
+     * @brief Get the local time
+     *
+     * @return int64_t Microseconds since the Unix epoch
+     */
+    static int64_t nowUs();
+
+    /**
+     * @brief Add a sync sample, normally from public/get_time
+     *
+     * @param sentUs Local time the request was sent
+     * @param exchangeInUs Deribit usIn
+     * @param exchangeOutUs Deribit usOut
+     * @param receivedUs Local time the response arrived
+     */
+    void addSample(int64_t sentUs, int64_t exchangeInUs, int64_t exchangeOutUs, int64_t receivedUs);
+
+    /**
+     * @brief Split a request's latency and add it to the leg figures
+     *
+     * The network legs need an estimate; before the first sample only the
+     * exchange leg is recorded.
+     *
+     * @param sentUs Local time the request was sent
+     * @param exchangeInUs Deribit usIn
+     * @param exchangeOutUs Deribit usOut
+     * @param receivedUs Local time the response arrived
+     * @return Split The split; network legs are 0 before the first sample
+     */
+    Split recordRequest(int64_t sentUs, int64_t exchangeInUs, int64_t exchangeOutUs, int64_t receivedUs);
+
+    /**
+     * @brief Get the estimate and leg figures
+     *
+     * @return Snapshot A copy
+     */
+    Snapshot snapshot();
+
+private:
+    /**
+     * @brief One sync sample
+     */
+    struct Sample {
+        int64_t localUs; /**< Local midpoint of the request */
+        double offsetUs; /**< Exchange clock minus local clock */
+        int64_t roundTripUs; /**< Network time of the request */
+    };
+
+    /**
+     * @brief Refit the estimate to the window; the caller holds mutex
+     */
+    void refit();
+
+    /**
+     * @brief Get the estimated offset at a local time; the caller holds mutex
+     */
+    double offsetAtLocked(int64_t localUs) const;
+
+    /**
+     * @brief Add a latency to a leg; the caller holds mutex
+     */
+    static void addLatency(LegStats& leg, int64_t latencyUs);
+
+    std::size_t window; /**< Samples kept */
+    std::deque<Sample> samples; /**< Recent samples, oldest first */
+    double baseOffsetUs = 0; /**< Fitted offset at baseLocalUs */
+    int64_t baseLocalUs = 0; /**< Local time the fit is anchored at */
+    double drift = 0; /**< Fitted change of the offset per microsecond */
+    int64_t bestRoundTripUs = 0; /**< Lowest round trip in the window */
+    LegStats outbound; /**< Local send to exchange receipt */
+    LegStats exchange; /**< Exchange processing */
+    LegStats inbound; /**< Exchange reply to local receipt */
+    std::mutex mutex; /**< Mutex for synchronizing access to all of the above */
+};
+
+#endif // CLOCK_SYNC_H
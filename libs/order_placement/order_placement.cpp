@@ -1,12 +1,54 @@
 #include "order_placement.h"
 #include "env_handler.h"
 #include <openssl/hmac.h>
+#include <algorithm>
 #include <chrono>
 #include <iomanip>
 #include <sstream>
 #include <iostream>
 
-OrderPlacement::OrderPlacement() : running(false)
+namespace
+{
+    // Requests that add risk, and so are rejected while the kill switch holds trading
+    bool isOrderMethod(const std::string &method)
+    {
+        return method == "private/buy" || method == "private/sell" || method == "private/edit";
+    }
+}
+
+namespace
+{
+    CircuitBreaker::Config breakerConfig()
+    {
+        CircuitBreaker::Config config;
+        std::string value = EnvHandler::getEnvVariable("CIRCUIT_WINDOW");
+        if (!value.empty())
+        {
+            config.window = std::stoul(value);
+        }
+        value = EnvHandler::getEnvVariable("CIRCUIT_FAILURE_RATIO");
+        if (!value.empty())
+        {
+            config.failureRatio = std::stod(value);
+        }
+        value = EnvHandler::getEnvVariable("CIRCUIT_SLOW_MS");
+        if (!value.empty())
+        {
+            config.slowThreshold = std::chrono::milliseconds(std::stol(value));
+        }
+        value = EnvHandler::getEnvVariable("CIRCUIT_OPEN_MS");
+        if (!value.empty())
+        {
+            config.coolDown = std::chrono::milliseconds(std::stol(value));
+        }
+        // An empty window would open the breaker on its first outcome
+        config.window = std::max<std::size_t>(config.window, 1);
+        config.minSamples = std::min(config.minSamples, config.window);
+        return config;
+    }
+}
+
+OrderPlacement::OrderPlacement() : running(false), breaker(breakerConfig())
 {
     apiKey = EnvHandler::getEnvVariable("DERIBIT_API_KEY");
     apiSecret = EnvHandler::getEnvVariable("DERIBIT_API_SECRET");
@@ -17,8 +59,20 @@ OrderPlacement::OrderPlacement() : running(false)
         throw std::runtime_error("API credentials not found in environment");
     }
 
+    std::string timeout = EnvHandler::getEnvVariable("REQUEST_DEADLINE_MS");
+    if (!timeout.empty())
+    {
+        requestTimeout = std::stol(timeout);
+    }
+
+    std::string interval = EnvHandler::getEnvVariable("CLOCK_SYNC_INTERVAL_S");
+    if (!interval.empty())
+    {
+        clockSyncInterval = std::chrono::seconds(std::max(1L, std::stol(interval)));
+    }
+
     setupAuth();
-    authenticate();
+    authenticate(client);
     startWorker();
 }
 
@@ -30,6 +84,7 @@ OrderPlacement::~OrderPlacement()
 void OrderPlacement::setupAuth()
 {
     client.setHeader("Content-Type", "application/json");
+    killClient.setHeader("Content-Type", "application/json");
 }
 
 std::string OrderPlacement::sign(const std::string &message)
@@ -55,6 +110,7 @@ void OrderPlacement::startWorker()
 {
     running = true;
     workerThread = std::thread(&OrderPlacement::processRequests, this);
+    killThread = std::thread(&OrderPlacement::processKillRequests, this);
 }
 
 void OrderPlacement::stopWorker()
@@ -68,6 +124,163 @@ void OrderPlacement::stopWorker()
     {
         workerThread.join();
     }
+
+    {
+        std::lock_guard<std::mutex> lock(killMutex);
+    }
+    killCV.notify_one();
+    if (killThread.joinable())
+    {
+        killThread.join();
+    }
+}
+
+void OrderPlacement::cancelAllNow(ResponseCallback callback)
+{
+    halted = true;
+
+    // Wake the kill thread before anything else
+    {
+        std::lock_guard<std::mutex> lock(killMutex);
+        killRequests.push_back(std::move(callback));
+    }
+    killCV.notify_one();
+
+    // Orders still queued would otherwise reach Deribit after the cancel
+    std::queue<std::unique_ptr<ApiRequest>> flushed;
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        std::queue<std::unique_ptr<ApiRequest>> kept;
+        while (!requestQueue.empty())
+        {
+            auto &request = requestQueue.front();
+            (isOrderMethod(request->method) ? flushed : kept).push(std::move(request));
+            requestQueue.pop();
+        }
+        requestQueue.swap(kept);
+    }
+
+    auto error = std::make_exception_ptr(std::runtime_error("Trading halted by kill switch"));
+    for (; !flushed.empty(); flushed.pop())
+    {
+        failRequest(*flushed.front(), error);
+    }
+}
+
+void OrderPlacement::syncClock(RestClient &via)
+{
+    int64_t sent = ClockSync::nowUs();
+    json response = json::parse(via.get(baseUrl + "/api/v2/public/get_time"));
+    int64_t received = ClockSync::nowUs();
+
+    if (response.contains("usIn") && response.contains("usOut"))
+    {
+        clock.addSample(sent, response["usIn"], response["usOut"], received);
+    }
+}
+
+json OrderPlacement::latencyStats()
+{
+    ClockSync::Snapshot stats = clock.snapshot();
+    auto leg = [](const ClockSync::LegStats &figures)
+    {
+        return json{
+            {"count", figures.count},
+            {"last_us", figures.lastUs},
+            {"mean_us", figures.count ? figures.totalUs / figures.count : 0.0},
+            {"min_us", figures.minUs},
+            {"max_us", figures.maxUs}};
+    };
+
+    return json{
+        {"synced", stats.synced},
+        {"samples", stats.samples},
+        {"offset_us", stats.offsetUs},
+        {"drift_ppm", stats.driftPpm},
+        {"best_round_trip_us", stats.bestRoundTripUs},
+        {"outbound", leg(stats.outbound)},
+        {"exchange", leg(stats.exchange)},
+        {"inbound", leg(stats.inbound)}};
+}
+
+void OrderPlacement::processKillRequests()
+{
+    // Idle connections are closed by the server; clock samples well inside that keep the TLS session open
+    const auto keepAlive = std::min<std::chrono::seconds>(clockSyncInterval, std::chrono::seconds(30));
+
+    try
+    {
+        syncClock(killClient);
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "Clock sync failed: " << e.what() << std::endl;
+    }
+
+    std::unique_lock<std::mutex> lock(killMutex);
+    while (running)
+    {
+        if (!killCV.wait_for(lock, keepAlive, [this]
+                             { return !killRequests.empty() || !running; }))
+        {
+            lock.unlock();
+            try
+            {
+                accessToken(killClient);
+                syncClock(killClient);
+            }
+            catch (const std::exception &e)
+            {
+                std::cerr << "Kill switch keep-alive failed: " << e.what() << std::endl;
+            }
+            lock.lock();
+            continue;
+        }
+
+        std::vector<ResponseCallback> callbacks;
+        callbacks.swap(killRequests);
+        if (callbacks.empty())
+        {
+            continue;
+        }
+        lock.unlock();
+
+        // One cancel_all answers every request that arrived while it was pending
+        json response;
+        std::exception_ptr error;
+        try
+        {
+            json request = {
+                {"jsonrpc", "2.0"},
+                {"method", "private/cancel_all"},
+                {"params", json::object()},
+                {"id", 0}};
+
+            killClient.setHeader("Authorization", "Bearer " + accessToken(killClient));
+            response = json::parse(killClient.post(baseUrl + "/api/v2/private/cancel_all", request.dump()));
+        }
+        catch (const std::exception &e)
+        {
+            error = std::current_exception();
+        }
+        if (!error && response.contains("result"))
+        {
+            riskChecks.clearOrders();
+        }
+
+        for (auto &callback : callbacks)
+        {
+            try
+            {
+                callback(response, error);
+            }
+            catch (const std::exception &e)
+            {
+                std::cerr << "Kill switch callback failed: " << e.what() << std::endl;
+            }
+        }
+        lock.lock();
+    }
 }
 
 void OrderPlacement::processRequests()
@@ -95,21 +308,84 @@ void OrderPlacement::processRequests()
 
         if (request)
         {
-            try
+            json response;
+            std::exception_ptr error;
+            auto budget = std::chrono::duration_cast<std::chrono::milliseconds>(
+                request->deadline - std::chrono::steady_clock::now());
+            if (budget.count() > 0 && !breaker.allowRequest())
             {
-                json response = sendAuthenticatedRequest(request->method, request->params);
-                request->promise.set_value(response);
+                // REST is degraded: hand the request to the fallback transport, or fail it at once
+                std::shared_ptr<ApiRequest> pending(std::move(request));
+                if (fallback && fallback(pending->method, pending->params, pending->deadline,
+                                         [this, pending](const json &response, std::exception_ptr error)
+                                         { completeRequest(*pending, response, error); }))
+                {
+                    continue;
+                }
+                completeRequest(*pending, json(),
+                                std::make_exception_ptr(std::runtime_error("REST circuit open; request not sent")));
+                continue;
             }
-            catch (const std::exception &e)
+
+            if (budget.count() <= 0)
             {
-                std::cout << "Request failed: " << e.what() << std::endl;
-                request->promise.set_exception(std::current_exception());
+                // The caller has given up and the market has moved; sending it would only lengthen the backlog
+                ++expired;
+                std::cout << "Dropped " << request->method << " after "
+                          << std::chrono::duration_cast<std::chrono::milliseconds>(
+                                 std::chrono::steady_clock::now() - request->timestamp).count()
+                          << " ms in the queue" << std::endl;
+                error = std::make_exception_ptr(std::runtime_error("Request expired before it was sent"));
             }
+            else
+            {
+                auto sent = std::chrono::steady_clock::now();
+                try
+                {
+                    client.setTimeoutMs(budget.count());
+                    response = sendAuthenticatedRequest(request->method, request->params);
+                }
+                catch (const std::exception &e)
+                {
+                    std::cout << "Request failed: " << e.what() << std::endl;
+                    error = std::current_exception();
+                }
+
+                // Deribit errors such as insufficient funds are answers; only transport trouble counts
+                breaker.record(!error && client.getLastResponseCode() < 500, std::chrono::steady_clock::now() - sent);
+            }
+
+            completeRequest(*request, response, error);
+        }
+    }
+}
+
+void OrderPlacement::completeRequest(ApiRequest &request, const json &response, std::exception_ptr error)
+{
+    trackOrders(request, response, error);
+
+    if (request.callback)
+    {
+        try
+        {
+            request.callback(response, error);
         }
+        catch (const std::exception &e)
+        {
+            std::cerr << "Response callback failed: " << e.what() << std::endl;
+        }
+    }
+    else if (error)
+    {
+        request.promise.set_exception(error);
+    }
+    else
+    {
+        request.promise.set_value(response);
     }
 }
 
-void OrderPlacement::authenticate()
+void OrderPlacement::authenticate(RestClient &via)
 {
     json authParams = {
         {"grant_type", "client_credentials"},
@@ -123,13 +399,14 @@ void OrderPlacement::authenticate()
         {"params", authParams}};
 
     // Clear existing auth headers for this request
-    client.setHeader("Authorization", "");
+    via.setHeader("Authorization", "");
     std::string fullUrl = baseUrl + "/api/v2";
-    std::string response = client.post(fullUrl, request.dump());
+    std::string response = via.post(fullUrl, request.dump());
     json responseJson = json::parse(response);
 
     if (responseJson.contains("result"))
     {
+        std::lock_guard<std::mutex> lock(authMutex);
         access_token = responseJson["result"]["access_token"];
         refresh_token = responseJson["result"]["refresh_token"];
         token_expiry = responseJson["result"]["expires_in"];
@@ -141,54 +418,174 @@ void OrderPlacement::authenticate()
     }
 }
 
-json OrderPlacement::sendAuthenticatedRequest(const std::string &method,
-                                              const json &params)
+std::string OrderPlacement::accessToken(RestClient &via)
 {
-    auto current_time = std::chrono::steady_clock::now();
-    auto time_elapsed = std::chrono::duration_cast<std::chrono::seconds>(current_time - last_auth_time).count();
-
-    if (time_elapsed > (token_expiry - 60))
     {
-        authenticate();
+        std::lock_guard<std::mutex> lock(authMutex);
+        auto current_time = std::chrono::steady_clock::now();
+        auto time_elapsed = std::chrono::duration_cast<std::chrono::seconds>(current_time - last_auth_time).count();
+        if (time_elapsed <= (token_expiry - 60))
+        {
+            return access_token;
+        }
     }
 
+    authenticate(via);
+    std::lock_guard<std::mutex> lock(authMutex);
+    return access_token;
+}
+
+json OrderPlacement::sendAuthenticatedRequest(const std::string &method,
+                                              const json &params)
+{
+    std::string token = accessToken(client);
+
     json request = {
         {"jsonrpc", "2.0"},
         {"method", method},
         {"params", params},
         {"id", std::chrono::system_clock::now().time_since_epoch().count() / 1000000}};
 
-    client.setHeader("Authorization", "Bearer " + access_token);
+    client.setHeader("Authorization", "Bearer " + token);
     std::string fullUrl = baseUrl + "/api/v2/" + method;
-    std::string response = client.post(fullUrl, request.dump());
-    return json::parse(response);
+    int64_t sent = ClockSync::nowUs();
+    json response = json::parse(client.post(fullUrl, request.dump()));
+    int64_t received = ClockSync::nowUs();
+
+    if (response.contains("usIn") && response.contains("usOut"))
+    {
+        clock.recordRequest(sent, response["usIn"], response["usOut"], received);
+    }
+    return response;
 }
 
-std::future<json> OrderPlacement::queueRequest(const std::string &method, const json &params)
+std::future<json> OrderPlacement::queueRequest(const std::string &method, const json &params, double reserved)
 {
     auto request = std::make_unique<ApiRequest>();
     request->method = method;
     request->params = params;
+    request->reserved = reserved;
     request->timestamp = std::chrono::steady_clock::now(); // Add timestamp to request
+    request->deadline = request->timestamp + std::chrono::milliseconds(requestTimeout.load());
 
     std::future<json> future = request->promise.get_future();
+    enqueue(std::move(request));
+
+    // Return the future which can be waited with timeout
+    return future;
+}
+
+void OrderPlacement::queueRequest(const std::string &method, const json &params, ResponseCallback callback,
+                                  double reserved)
+{
+    auto request = std::make_unique<ApiRequest>();
+    request->method = method;
+    request->params = params;
+    request->reserved = reserved;
+    request->callback = std::move(callback);
+    request->timestamp = std::chrono::steady_clock::now();
+    request->deadline = request->timestamp + std::chrono::milliseconds(requestTimeout.load());
+    enqueue(std::move(request));
+}
+
+void OrderPlacement::enqueue(std::unique_ptr<ApiRequest> request)
+{
+    if (halted && isOrderMethod(request->method))
+    {
+        failRequest(*request, std::make_exception_ptr(std::runtime_error("Trading halted by kill switch")));
+        return;
+    }
 
     {
         std::lock_guard<std::mutex> lock(queueMutex);
         requestQueue.push(std::move(request));
     }
     queueCV.notify_one();
+}
 
-    // Return the future which can be waited with timeout
-    return future;
+void OrderPlacement::failRequest(ApiRequest &request, std::exception_ptr error)
+{
+    completeRequest(request, json(), error);
 }
 
-std::future<json> OrderPlacement::placeOrder(const std::string &instrument,
-                                             const std::string &side,
-                                             const std::string &type,
-                                             double amount,
-                                             double price,
-                                             bool reduceOnly)
+void OrderPlacement::checkRisk(const json &params, const std::string &side)
+{
+    // Only limit prices are collared; a stop's price is its trigger
+    double price = params.value("type", "") == "limit" || params.value("type", "") == "stop_limit"
+                       ? params.value("price", 0.0)
+                       : 0.0;
+    std::size_t index = riskChecks.indexOf(params["instrument_name"]);
+    RiskCheck check = riskChecks.reserve(index, side == "buy", params["amount"], price);
+    if (check != RiskCheck::PASSED)
+    {
+        throw RiskRejection(check, std::string("Order rejected by pre-trade checks: ") + PreTradeRisk::describe(check));
+    }
+}
+
+double OrderPlacement::checkEditRisk(const std::string &orderId, double amount, double price)
+{
+    double increase = 0;
+    RiskCheck check = riskChecks.reserveEdit(orderId, amount, price, increase);
+    if (check != RiskCheck::PASSED)
+    {
+        throw RiskRejection(check, std::string("Edit rejected by pre-trade checks: ") + PreTradeRisk::describe(check));
+    }
+    return increase;
+}
+
+void OrderPlacement::trackOrders(const ApiRequest &request, const json &response, std::exception_ptr error)
+{
+    // For edits, reserved is the increase reserveEdit held; the order itself was already counted
+    bool edit = request.method == "private/edit";
+    bool order = request.reserved > 0 && !edit;
+    if (error || !response.contains("result"))
+    {
+        if (order)
+        {
+            riskChecks.release(riskChecks.indexOf(request.params["instrument_name"]),
+                               request.method == "private/buy", request.reserved);
+        }
+        else if (edit && request.reserved > 0)
+        {
+            riskChecks.releaseEdit(request.params["order_id"], request.reserved);
+        }
+        return;
+    }
+
+    // buy, sell and edit return {"order": ...}; cancel returns the order itself
+    const json &result = response["result"];
+    const json &state = result.contains("order") ? result["order"] : result;
+    if (order || edit || request.method == "private/cancel")
+    {
+        if (!state.contains("order_id"))
+        {
+            if (order)
+            {
+                riskChecks.release(riskChecks.indexOf(request.params["instrument_name"]),
+                                   request.method == "private/buy", request.reserved);
+            }
+            else if (edit && request.reserved > 0)
+            {
+                riskChecks.releaseEdit(request.params["order_id"], request.reserved);
+            }
+            return;
+        }
+        riskChecks.onOrder(state["order_id"], state.value("instrument_name", ""), state.value("direction", "") == "buy",
+                           state.value("order_state", ""), state.value("amount", 0.0),
+                           state.value("filled_amount", 0.0), order ? request.reserved : 0);
+    }
+    else if (request.method == "private/cancel_all")
+    {
+        riskChecks.clearOrders();
+    }
+}
+
+json OrderPlacement::orderParams(const std::string &instrument,
+                                 const std::string &side,
+                                 const std::string &type,
+                                 double amount,
+                                 double price,
+                                 bool reduceOnly)
 {
     if (side != "buy" && side != "sell")
     {
@@ -216,7 +613,43 @@ std::future<json> OrderPlacement::placeOrder(const std::string &instrument,
         params["reduce_only"] = true;
     }
 
-    return queueRequest("private/" + side, params);
+    return params;
+}
+
+std::future<json> OrderPlacement::placeOrder(const std::string &instrument,
+                                             const std::string &side,
+                                             const std::string &type,
+                                             double amount,
+                                             double price,
+                                             bool reduceOnly)
+{
+    json params = orderParams(instrument, side, type, amount, price, reduceOnly);
+    checkRisk(params, side);
+    return queueRequest("private/" + side, params, amount);
+}
+
+void OrderPlacement::placeOrder(const std::string &instrument,
+                                const std::string &side,
+                                const std::string &type,
+                                double amount,
+                                double price,
+                                bool reduceOnly,
+                                const std::string &label,
+                                const std::string &timeInForce,
+                                ResponseCallback callback)
+{
+    json params = orderParams(instrument, side, type, amount, price, reduceOnly);
+    if (!label.empty())
+    {
+        params["label"] = label;
+    }
+    if (!timeInForce.empty())
+    {
+        params["time_in_force"] = timeInForce;
+    }
+
+    checkRisk(params, side);
+    queueRequest("private/" + side, params, std::move(callback), amount);
 }
 
 std::future<json> OrderPlacement::cancelOrder(const std::string &orderId)
@@ -227,6 +660,14 @@ std::future<json> OrderPlacement::cancelOrder(const std::string &orderId)
     return queueRequest("private/cancel", params);
 }
 
+void OrderPlacement::cancelOrder(const std::string &orderId, ResponseCallback callback)
+{
+    json params = {
+        {"order_id", orderId}};
+
+    queueRequest("private/cancel", params, std::move(callback));
+}
+
 std::future<json> OrderPlacement::modifyOrder(const std::string &orderId,
                                               double newPrice,
                                               double newAmount)
@@ -236,7 +677,20 @@ std::future<json> OrderPlacement::modifyOrder(const std::string &orderId,
         {"amount", newAmount},
         {"price", newPrice}};
 
-    return queueRequest("private/edit", params);
+    return queueRequest("private/edit", params, checkEditRisk(orderId, newAmount, newPrice));
+}
+
+void OrderPlacement::modifyOrder(const std::string &orderId,
+                                 double newPrice,
+                                 double newAmount,
+                                 ResponseCallback callback)
+{
+    json params = {
+        {"order_id", orderId},
+        {"amount", newAmount},
+        {"price", newPrice}};
+
+    queueRequest("private/edit", params, std::move(callback), checkEditRisk(orderId, newAmount, newPrice));
 }
 
 std::future<json> OrderPlacement::getActiveOrders()
@@ -4,15 +4,35 @@
 #include <string>
 #include <nlohmann/json.hpp>
 #include "rest_client.h"
+#include "pre_trade_risk.h"
+#include "circuit_breaker.h"
+#include "clock_sync.h"
 #include <queue>
 #include <mutex>
 #include <condition_variable>
 #include <thread>
+#include <atomic>
 #include <functional>
 #include <future>
+#include <vector>
 
 using json = nlohmann::json;
 
+/**
+ * @brief Callback receiving the response of a request, or the exception it failed with
+ */
+using ResponseCallback = std::function<void(const json& response, std::exception_ptr error)>;
+
+/**
+ * @brief Sends a request over another transport while the REST circuit is open
+ *
+ * Returns false if the transport is unavailable; otherwise the callback must
+ * receive the JSON-RPC response, or a failure once the connection drops or
+ * the request's deadline passes, whichever comes first.
+ */
+using FallbackTransport = std::function<bool(const std::string& method, const json& params,
+                                             std::chrono::steady_clock::time_point deadline, ResponseCallback callback)>;
+
 /**
  * @brief Structure to hold request information
  */
@@ -20,7 +40,10 @@ struct ApiRequest {
     std::string method; /**< HTTP method */
     json params; /**< Request parameters */
     std::promise<json> promise; /**< Promise to hold the response */
+    ResponseCallback callback; /**< Called instead of fulfilling the promise when set */
+    double reserved = 0; /**< Amount reserved by the pre-trade checks for a new order, or an edit's increase */
     std::chrono::steady_clock::time_point timestamp; /**< Timestamp of the request */
+    std::chrono::steady_clock::time_point deadline; /**< After this the request is dropped unsent, or its send times out */
 };
 
 /**
@@ -61,6 +84,7 @@ public:
      * @param price The price for limit orders (default is 0.0)
      * @param reduceOnly Whether the order is reduce-only (default is false)
      * @return std::future<json> The response from the server
+     * @throws RiskRejection if a pre-trade check fails; nothing is queued
      */
     std::future<json> placeOrder(const std::string& instrument, 
                                 const std::string& side,        
@@ -76,6 +100,54 @@ public:
      * @return std::future<json> The response from the server
      */
     std::future<json> cancelOrder(const std::string& orderId);
+
+    /**
+     * @brief Place a new order and report the response to a callback
+     * 
+     * The callback runs on the worker thread once the request completes.
+     * 
+     * @param instrument The trading instrument
+     * @param side The side of the order ("buy" or "sell")
+     * @param type The type of the order ("market", "limit", "stop_market", "stop_limit")
+     * @param amount The amount to trade
+     * @param price The price for limit and stop orders
+     * @param reduceOnly Whether the order is reduce-only
+     * @param label User defined label for the order, empty for none
+     * @param timeInForce "good_til_cancelled", "fill_or_kill" or "immediate_or_cancel", empty for the exchange default
+     * @param callback Receives the response
+     * @throws RiskRejection if a pre-trade check fails; the callback is not called
+     */
+    void placeOrder(const std::string& instrument,
+                    const std::string& side,
+                    const std::string& type,
+                    double amount,
+                    double price,
+                    bool reduceOnly,
+                    const std::string& label,
+                    const std::string& timeInForce,
+                    ResponseCallback callback);
+
+    /**
+     * @brief Cancel an existing order and report the response to a callback
+     * 
+     * @param orderId The ID of the order to cancel
+     * @param callback Receives the response
+     */
+    void cancelOrder(const std::string& orderId, ResponseCallback callback);
+
+    /**
+     * @brief Modify an existing order and report the response to a callback
+     * 
+     * @param orderId The ID of the order to modify
+     * @param newPrice The new price for the order
+     * @param newAmount The new amount for the order
+     * @param callback Receives the response
+     * @throws RiskRejection if a pre-trade check fails; the callback is not called
+     */
+    void modifyOrder(const std::string& orderId,
+                     double newPrice,
+                     double newAmount,
+                     ResponseCallback callback);
     
     /**
      * @brief Modify an existing order
@@ -84,11 +156,84 @@ public:
      * @param newPrice The new price for the order
      * @param newAmount The new amount for the order
      * @return std::future<json> The response from the server
+     * @throws RiskRejection if a pre-trade check fails; nothing is queued
      */
     std::future<json> modifyOrder(const std::string& orderId,
                                  double newPrice,
                                  double newAmount);
                     
+    /**
+     * @brief Cancel every open order on the fastest REST path and halt trading
+     * 
+     * Runs private/cancel_all on a dedicated thread and connection, kept
+     * warm and authenticated, so it never waits behind queued requests.
+     * Queued orders and edits are failed, and new ones are rejected until
+     * resume() is called.
+     * 
+     * @param callback Receives the response; runs on the kill switch thread
+     */
+    void cancelAllNow(ResponseCallback callback);
+
+    /**
+     * @brief Set how long requests queued from now on stay valid
+     * 
+     * A request still queued at its deadline fails without being sent, and
+     * one being sent gets the rest of its budget as its HTTP timeout.
+     * 
+     * @param timeout The time from queueing to the deadline
+     */
+    void setRequestTimeout(std::chrono::milliseconds timeout) { requestTimeout = timeout.count(); }
+
+    /**
+     * @brief Get the number of requests dropped at their deadline without being sent
+     * 
+     * @return uint64_t The count
+     */
+    uint64_t expiredRequests() const { return expired; }
+
+    /**
+     * @brief Set the transport used while the REST circuit is open
+     * 
+     * Call before sending requests. Without one, requests fail fast while
+     * the circuit is open.
+     * 
+     * @param transport The fallback transport
+     */
+    void setFallback(FallbackTransport transport) { fallback = std::move(transport); }
+
+    /**
+     * @brief Get the state of the REST circuit breaker
+     * 
+     * @return CircuitBreaker::State The state
+     */
+    CircuitBreaker::State circuitState() { return breaker.state(); }
+
+    /**
+     * @brief Get the exchange clock estimate and the latency split of requests
+     * 
+     * @return json Offset, drift and per-leg latency figures in microseconds
+     */
+    json latencyStats();
+
+    /**
+     * @brief Get the pre-trade risk checks, to update limits, marks and positions
+     * 
+     * @return PreTradeRisk& The checks applied by placeOrder
+     */
+    PreTradeRisk& risk() { return riskChecks; }
+
+    /**
+     * @brief Accept orders and edits again after cancelAllNow
+     */
+    void resume() { halted = false; }
+
+    /**
+     * @brief Check if trading is halted by the kill switch
+     * 
+     * @return true if orders and edits are rejected
+     */
+    bool isHalted() const { return halted; }
+
     /**
      * @brief Get active orders
      * 
@@ -148,6 +293,7 @@ public:
 
 private:
     RestClient client; /**< REST client for making requests */
+    RestClient killClient; /**< REST client used only by the kill switch, so its connection stays free and warm */
     std::string apiKey; /**< API key for authentication */
     std::string apiSecret; /**< API secret for authentication */
     std::string access_token; /**< Access token for authentication */
@@ -155,13 +301,34 @@ private:
     std::string baseUrl; /**< Base URL for the API */
     int token_expiry; /**< Token expiry time */
     std::chrono::steady_clock::time_point last_auth_time; /**< Last authentication time */
+    std::mutex authMutex; /**< Mutex for synchronizing access to the tokens, expiry and auth time */
     
     // Thread management
     std::thread workerThread; /**< Worker thread for processing requests */
     std::queue<std::unique_ptr<ApiRequest>> requestQueue; /**< Queue to hold API requests */
     std::mutex queueMutex; /**< Mutex for synchronizing access to the queue */
     std::condition_variable queueCV; /**< Condition variable for queue synchronization */
-    bool running; /**< Flag to indicate if the worker thread is running */
+    std::atomic<bool> running; /**< Flag to indicate if the worker and kill switch threads are running */
+    std::atomic<bool> halted{false}; /**< True after the kill switch until resume() */
+    std::atomic<long> requestTimeout{30000}; /**< Milliseconds from queueing to a request's deadline */
+    std::atomic<uint64_t> expired{0}; /**< Requests dropped at their deadline */
+    PreTradeRisk riskChecks; /**< Checks every new order before it is queued */
+    CircuitBreaker breaker; /**< Tracks the health of the REST path */
+    FallbackTransport fallback; /**< Carries requests while the breaker is open */
+    ClockSync clock; /**< Exchange clock estimate, and the latency split of sent requests */
+    std::chrono::seconds clockSyncInterval{10}; /**< Time between clock samples, at most the keep-alive */
+
+    std::thread killThread; /**< Sends cancel_all requests and keeps killClient warm */
+    std::vector<ResponseCallback> killRequests; /**< Kill switch requests waiting for killThread */
+    std::mutex killMutex; /**< Mutex for synchronizing access to killRequests */
+    std::condition_variable killCV; /**< Wakes killThread for a request and on stop */
+
+    /**
+     * @brief Take a clock sample with public/get_time
+     * 
+     * @param via The client to send it on
+     */
+    void syncClock(RestClient& via);
     
     /**
      * @brief Setup authentication for the client
@@ -191,18 +358,117 @@ private:
     void processRequests();
     
     /**
-     * @brief Authenticate the client
+     * @brief Authenticate and store the new tokens
+     * 
+     * @param via The REST client to authenticate over
      */
-    void authenticate();
+    void authenticate(RestClient& via);
+
+    /**
+     * @brief Get a valid access token, authenticating first if it is about to expire
+     * 
+     * @param via The REST client to authenticate over if needed
+     * @return std::string The access token
+     */
+    std::string accessToken(RestClient& via);
+
+    /**
+     * @brief Kill switch thread function
+     */
+    void processKillRequests();
     
     /**
      * @brief Helper to queue requests
      * 
      * @param method The HTTP method
      * @param params The parameters for the request
+     * @param reserved Amount reserved by the pre-trade checks, for new orders and edits
      * @return std::future<json> The response from the server
      */
-    std::future<json> queueRequest(const std::string& method, const json& params);
+    std::future<json> queueRequest(const std::string& method, const json& params, double reserved = 0);
+
+    /**
+     * @brief Helper to queue requests whose response goes to a callback
+     * 
+     * @param method The HTTP method
+     * @param params The parameters for the request
+     * @param callback Receives the response
+     * @param reserved Amount reserved by the pre-trade checks, for new orders and edits
+     */
+    void queueRequest(const std::string& method, const json& params, ResponseCallback callback, double reserved = 0);
+
+    /**
+     * @brief Run the pre-trade checks for an edit, reserving any increase if they pass
+     * 
+     * @param orderId The order being edited
+     * @param amount The new amount
+     * @param price The new price
+     * @return double The amount reserved beyond the order's current remaining amount
+     * @throws RiskRejection if a check fails
+     */
+    double checkEditRisk(const std::string& orderId, double amount, double price);
+
+    /**
+     * @brief Run the pre-trade checks for a new order, reserving it if they pass
+     * 
+     * @param params The order parameters from orderParams
+     * @param side The side of the order
+     * @throws RiskRejection if a check fails
+     */
+    void checkRisk(const json& params, const std::string& side);
+
+    /**
+     * @brief Update the pre-trade state from a completed request
+     * 
+     * @param request The request
+     * @param response The response, if it completed
+     * @param error The failure, if it did not
+     */
+    void trackOrders(const ApiRequest& request, const json& response, std::exception_ptr error);
+
+    /**
+     * @brief Deliver a request's outcome to its callback or promise
+     * 
+     * @param request The request
+     * @param response The response, if it completed
+     * @param error The failure, if it did not
+     */
+    void completeRequest(ApiRequest& request, const json& response, std::exception_ptr error);
+
+    /**
+     * @brief Fail a request without sending it, releasing its reservation
+     * 
+     * @param request The request
+     * @param error The failure
+     */
+    void failRequest(ApiRequest& request, std::exception_ptr error);
+
+    /**
+     * @brief Push a request onto the queue and wake the worker
+     * 
+     * Orders and edits are failed at once while trading is halted.
+     * 
+     * @param request The request
+     */
+    void enqueue(std::unique_ptr<ApiRequest> request);
+
+    /**
+     * @brief Build the parameters of a buy or sell request
+     * 
+     * @param instrument The trading instrument
+     * @param side The side of the order ("buy" or "sell")
+     * @param type The type of the order
+     * @param amount The amount to trade
+     * @param price The price for limit and stop orders
+     * @param reduceOnly Whether the order is reduce-only
+     * @return json The request parameters
+     */
+    static json orderParams(const std::string& instrument,
+                            const std::string& side,
+                            const std::string& type,
+                            double amount,
+                            double price,
+                            bool reduceOnly);
     
     /**
      * @brief Start the worker thread
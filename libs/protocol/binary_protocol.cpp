@@ -0,0 +1,332 @@
+#include "binary_protocol.h"
+#include <algorithm>
+#include <cmath>
+#include <mutex>
+
+namespace {
+    inline int64_t scaled(double value, int64_t scale) {
+        return static_cast<int64_t>(std::llround(value * static_cast<double>(scale)));
+    }
+
+    inline int64_t ticks(double price, double tickSize) {
+        return static_cast<int64_t>(std::llround(price / tickSize));
+    }
+
+    inline double number(const json& data, const char* key) {
+        auto it = data.find(key);
+        return it != data.end() && it->is_number() ? it->get<double>() : 0.0;
+    }
+
+    std::string instrumentName(const json& data) {
+        auto it = data.find("instrument_name");
+        return it != data.end() && it->is_string() ? it->get<std::string>() : std::string();
+    }
+
+    template <typename T>
+    inline void put(std::string& out, std::size_t offset, const T& value) {
+        std::memcpy(&out[offset], &value, sizeof(T));
+    }
+
+    void putHeader(std::string& out, BinaryMessageType type, uint64_t sequence,
+                   int64_t timestampMs, const std::string& instrument) {
+        BinaryHeader header{};
+        header.schemaVersion = BINARY_SCHEMA_VERSION;
+        header.type = static_cast<uint16_t>(type);
+        header.length = static_cast<uint32_t>(out.size());
+        header.sequence = sequence;
+        header.timestampMs = timestampMs;
+        std::memcpy(header.instrument, instrument.data(),
+                    std::min(instrument.size(), BINARY_INSTRUMENT_SIZE - 1));
+        put(out, 0, header);
+    }
+
+    // Count entries that carry a price, skipping malformed ones
+    std::size_t levelCount(const json* entries) {
+        std::size_t count = 0;
+        if (!entries) return 0;
+        for (const auto& entry : *entries) {
+            if (entry.is_array() && entry.size() >= 2) ++count;
+        }
+        return count;
+    }
+
+    std::size_t putLevels(std::string& out, std::size_t offset, const json* entries, double tickSize) {
+        if (!entries) return offset;
+        for (const auto& entry : *entries) {
+            if (!entry.is_array() || entry.size() < 2) continue;
+
+            BinaryLevel level;
+            if (entry[0].is_string()) {
+                bool remove = entry[0].get_ref<const std::string&>() == "delete" || entry.size() < 3;
+                level.priceTicks = ticks(entry[1].get<double>(), tickSize);
+                level.amount = remove ? 0 : scaled(entry[2].get<double>(), BINARY_AMOUNT_SCALE);
+            } else {
+                level.priceTicks = ticks(entry[0].get<double>(), tickSize);
+                level.amount = scaled(entry[1].get<double>(), BINARY_AMOUNT_SCALE);
+            }
+            put(out, offset, level);
+            offset += sizeof(BinaryLevel);
+        }
+        return offset;
+    }
+}
+
+bool BinaryMessageView::parse(const char* data, std::size_t size) {
+    if (size < sizeof(BinaryHeader)) return false;
+    std::memcpy(&messageHeader, data, sizeof(BinaryHeader));
+    if (messageHeader.schemaVersion != BINARY_SCHEMA_VERSION || messageHeader.length != size) {
+        return false;
+    }
+
+    std::size_t expected = sizeof(BinaryHeader);
+    buffer = data;
+    switch (type()) {
+    case BinaryMessageType::BOOK:
+        if (size < expected + sizeof(BinaryBook)) return false;
+        {
+            auto book = body<BinaryBook>();
+            expected += sizeof(BinaryBook) + (book.bidCount + book.askCount) * sizeof(BinaryLevel);
+        }
+        break;
+    case BinaryMessageType::TICKER:
+        expected += sizeof(BinaryTicker);
+        break;
+    case BinaryMessageType::TRADES:
+        if (size < expected + sizeof(BinaryTrades)) return false;
+        expected += sizeof(BinaryTrades) + body<BinaryTrades>().count * sizeof(BinaryTrade);
+        break;
+    case BinaryMessageType::POSITION:
+        expected += sizeof(BinaryPosition);
+        break;
+    case BinaryMessageType::GREEKS:
+        expected += sizeof(BinaryGreeks);
+        break;
+    case BinaryMessageType::BAR:
+        expected += sizeof(BinaryBar);
+        break;
+    case BinaryMessageType::BOOK_ANALYTICS:
+        if (size < expected + sizeof(BinaryBookAnalytics)) return false;
+        expected += sizeof(BinaryBookAnalytics) + body<BinaryBookAnalytics>().depth * sizeof(BinaryDepthLevel);
+        break;
+    default:
+        return false;
+    }
+    return size == expected;
+}
+
+void BinaryEncoder::setTickSize(const std::string& instrument, double size) {
+    if (size > 0.0) {
+        std::unique_lock<std::shared_mutex> lock(tickSizesMutex);
+        tickSizes[instrument] = size;
+    }
+}
+
+double BinaryEncoder::tickSize(const std::string& instrument) const {
+    std::shared_lock<std::shared_mutex> lock(tickSizesMutex);
+    auto it = tickSizes.find(instrument);
+    return it != tickSizes.end() ? it->second : DEFAULT_TICK_SIZE;
+}
+
+void BinaryEncoder::encodeBook(const json& data, std::string& out) const {
+    std::string instrument = instrumentName(data);
+    double tick = tickSize(instrument);
+
+    const json* bids = data.contains("bids") ? &data["bids"] : nullptr;
+    const json* asks = data.contains("asks") ? &data["asks"] : nullptr;
+    std::size_t bidCount = levelCount(bids);
+    std::size_t askCount = levelCount(asks);
+
+    bool grouped = bids && !bids->empty() && (*bids)[0].is_array() && (*bids)[0][0].is_number();
+    grouped = grouped || (asks && !asks->empty() && (*asks)[0].is_array() && (*asks)[0][0].is_number());
+
+    BinaryBook book{};
+    book.tickSizeE8 = scaled(tick, BINARY_PRICE_E8_SCALE);
+    book.previousSequence = data.contains("prev_change_id") ? data["prev_change_id"].get<uint64_t>() : 0;
+    book.snapshot = (grouped || data.value("type", "") == "snapshot") ? 1 : 0;
+    book.bidCount = static_cast<uint16_t>(bidCount);
+    book.askCount = static_cast<uint16_t>(askCount);
+
+    out.resize(sizeof(BinaryHeader) + sizeof(BinaryBook) + (bidCount + askCount) * sizeof(BinaryLevel));
+    putHeader(out, BinaryMessageType::BOOK,
+              data.contains("change_id") ? data["change_id"].get<uint64_t>() : 0,
+              static_cast<int64_t>(number(data, "timestamp")), instrument);
+    put(out, sizeof(BinaryHeader), book);
+
+    std::size_t offset = sizeof(BinaryHeader) + sizeof(BinaryBook);
+    offset = putLevels(out, offset, bids, tick);
+    putLevels(out, offset, asks, tick);
+}
+
+void BinaryEncoder::encodeBook(const std::string& instrument, uint64_t sequence, uint64_t previousSequence,
+                               int64_t timestampMs, bool snapshot, const BinaryLevelArrays& bids,
+                               const BinaryLevelArrays& asks, std::string& out) const {
+    double tick = tickSize(instrument);
+
+    BinaryBook book{};
+    book.tickSizeE8 = scaled(tick, BINARY_PRICE_E8_SCALE);
+    book.previousSequence = previousSequence;
+    book.snapshot = snapshot ? 1 : 0;
+    book.bidCount = static_cast<uint16_t>(bids.count);
+    book.askCount = static_cast<uint16_t>(asks.count);
+
+    out.resize(sizeof(BinaryHeader) + sizeof(BinaryBook) + (bids.count + asks.count) * sizeof(BinaryLevel));
+    putHeader(out, BinaryMessageType::BOOK, sequence, timestampMs, instrument);
+    put(out, sizeof(BinaryHeader), book);
+
+    std::size_t offset = sizeof(BinaryHeader) + sizeof(BinaryBook);
+    for (const BinaryLevelArrays* side : {&bids, &asks}) {
+        for (std::size_t i = 0; i < side->count; ++i) {
+            BinaryLevel level;
+            level.priceTicks = ticks(side->prices[i], tick);
+            level.amount = scaled(side->amounts[i], BINARY_AMOUNT_SCALE);
+            put(out, offset, level);
+            offset += sizeof(BinaryLevel);
+        }
+    }
+}
+
+void BinaryEncoder::encodeTicker(const json& data, std::string& out) const {
+    std::string instrument = instrumentName(data);
+    double tick = tickSize(instrument);
+
+    BinaryTicker ticker{};
+    ticker.tickSizeE8 = scaled(tick, BINARY_PRICE_E8_SCALE);
+    ticker.bestBidTicks = ticks(number(data, "best_bid_price"), tick);
+    ticker.bestBidAmount = scaled(number(data, "best_bid_amount"), BINARY_AMOUNT_SCALE);
+    ticker.bestAskTicks = ticks(number(data, "best_ask_price"), tick);
+    ticker.bestAskAmount = scaled(number(data, "best_ask_amount"), BINARY_AMOUNT_SCALE);
+    ticker.lastTicks = ticks(number(data, "last_price"), tick);
+    ticker.markPriceE8 = scaled(number(data, "mark_price"), BINARY_PRICE_E8_SCALE);
+    ticker.indexPriceE8 = scaled(number(data, "index_price"), BINARY_PRICE_E8_SCALE);
+    ticker.openInterest = scaled(number(data, "open_interest"), BINARY_AMOUNT_SCALE);
+    ticker.markIvE4 = scaled(number(data, "mark_iv"), 10000);
+
+    out.resize(sizeof(BinaryHeader) + sizeof(BinaryTicker));
+    putHeader(out, BinaryMessageType::TICKER, 0,
+              static_cast<int64_t>(number(data, "timestamp")), instrument);
+    put(out, sizeof(BinaryHeader), ticker);
+}
+
+void BinaryEncoder::encodeTrades(const json& data, std::string& out) const {
+    std::size_t count = data.is_array() ? data.size() : 0;
+    std::string instrument = count > 0 ? instrumentName(data[0]) : std::string();
+    double tick = tickSize(instrument);
+
+    BinaryTrades trades{};
+    trades.tickSizeE8 = scaled(tick, BINARY_PRICE_E8_SCALE);
+    trades.count = static_cast<uint32_t>(count);
+
+    out.resize(sizeof(BinaryHeader) + sizeof(BinaryTrades) + count * sizeof(BinaryTrade));
+    uint64_t lastSequence = 0;
+    int64_t lastTimestamp = 0;
+
+    std::size_t offset = sizeof(BinaryHeader) + sizeof(BinaryTrades);
+    for (std::size_t i = 0; i < count; ++i) {
+        const json& source = data[i];
+        BinaryTrade trade{};
+        trade.tradeSeq = source.contains("trade_seq") ? source["trade_seq"].get<uint64_t>() : 0;
+        trade.timestampMs = static_cast<int64_t>(number(source, "timestamp"));
+        trade.priceTicks = ticks(number(source, "price"), tick);
+        trade.amount = scaled(number(source, "amount"), BINARY_AMOUNT_SCALE);
+        trade.indexPriceE8 = scaled(number(source, "index_price"), BINARY_PRICE_E8_SCALE);
+        trade.direction = source.value("direction", "buy") == "sell" ? 1 : 0;
+        put(out, offset, trade);
+        offset += sizeof(BinaryTrade);
+
+        lastSequence = trade.tradeSeq;
+        lastTimestamp = trade.timestampMs;
+    }
+
+    putHeader(out, BinaryMessageType::TRADES, lastSequence, lastTimestamp, instrument);
+    put(out, sizeof(BinaryHeader), trades);
+}
+
+void BinaryEncoder::encodePosition(const json& data, std::string& out) const {
+    BinaryPosition position{};
+    double size = number(data, "size");
+    if (data.value("direction", "") == "sell" && size > 0) {
+        size = -size;
+    }
+    position.size = scaled(size, BINARY_AMOUNT_SCALE);
+    position.averagePriceE8 = scaled(number(data, "average_price"), BINARY_PRICE_E8_SCALE);
+    position.markPriceE8 = scaled(number(data, "mark_price"), BINARY_PRICE_E8_SCALE);
+    position.floatingPnlE8 = scaled(number(data, "floating_profit_loss"), BINARY_PRICE_E8_SCALE);
+    position.liquidationPriceE8 = scaled(number(data, "estimated_liquidation_price"), BINARY_PRICE_E8_SCALE);
+
+    out.resize(sizeof(BinaryHeader) + sizeof(BinaryPosition));
+    putHeader(out, BinaryMessageType::POSITION, 0,
+              static_cast<int64_t>(number(data, "timestamp")), instrumentName(data));
+    put(out, sizeof(BinaryHeader), position);
+}
+
+void BinaryEncoder::encodeBookAnalytics(const json& data, std::string& out) const {
+    static const json empty = json::array();
+    const json& bidDepth = data.contains("bid_depth") ? data["bid_depth"] : empty;
+    const json& askDepth = data.contains("ask_depth") ? data["ask_depth"] : empty;
+    std::size_t depth = std::max(bidDepth.size(), askDepth.size());
+
+    BinaryBookAnalytics analytics{};
+    analytics.midE8 = scaled(number(data, "mid"), BINARY_PRICE_E8_SCALE);
+    analytics.micropriceE8 = scaled(number(data, "microprice"), BINARY_PRICE_E8_SCALE);
+    analytics.spreadE8 = scaled(number(data, "spread"), BINARY_PRICE_E8_SCALE);
+    analytics.imbalanceE8 = scaled(number(data, "imbalance"), BINARY_PRICE_E8_SCALE);
+    analytics.depth = static_cast<uint16_t>(depth);
+
+    out.resize(sizeof(BinaryHeader) + sizeof(BinaryBookAnalytics) + depth * sizeof(BinaryDepthLevel));
+    putHeader(out, BinaryMessageType::BOOK_ANALYTICS,
+              data.contains("change_id") ? data["change_id"].get<uint64_t>() : 0,
+              static_cast<int64_t>(number(data, "timestamp")), instrumentName(data));
+    put(out, sizeof(BinaryHeader), analytics);
+
+    std::size_t offset = sizeof(BinaryHeader) + sizeof(BinaryBookAnalytics);
+    for (std::size_t i = 0; i < depth; ++i) {
+        BinaryDepthLevel level;
+        level.bidAmount = i < bidDepth.size() ? scaled(bidDepth[i].get<double>(), BINARY_AMOUNT_SCALE) : 0;
+        level.askAmount = i < askDepth.size() ? scaled(askDepth[i].get<double>(), BINARY_AMOUNT_SCALE) : 0;
+        put(out, offset, level);
+        offset += sizeof(BinaryDepthLevel);
+    }
+}
+
+void BinaryEncoder::encodeGreeks(const json& data, std::string& out) const {
+    // Unsolved results are serialized as null
+    auto greek = [&data](const char* key) {
+        auto it = data.find(key);
+        return it != data.end() && it->is_number() ? it->get<double>() : std::nan("");
+    };
+
+    BinaryGreeks greeks{};
+    greeks.underlyingPriceE8 = scaled(number(data, "underlying_price"), BINARY_PRICE_E8_SCALE);
+    greeks.priceE8 = scaled(number(data, "price"), BINARY_PRICE_E8_SCALE);
+    greeks.iv = greek("iv");
+    greeks.delta = greek("delta");
+    greeks.gamma = greek("gamma");
+    greeks.vega = greek("vega");
+    greeks.theta = greek("theta");
+
+    out.resize(sizeof(BinaryHeader) + sizeof(BinaryGreeks));
+    putHeader(out, BinaryMessageType::GREEKS, 0, static_cast<int64_t>(number(data, "timestamp")),
+              instrumentName(data));
+    put(out, sizeof(BinaryHeader), greeks);
+}
+
+void BinaryEncoder::encodeBar(const json& data, std::string& out) const {
+    std::string instrument = instrumentName(data);
+    double tick = tickSize(instrument);
+
+    BinaryBar bar{};
+    bar.tickSizeE8 = scaled(tick, BINARY_PRICE_E8_SCALE);
+    bar.resolutionMs = static_cast<int64_t>(number(data, "resolution_ms"));
+    bar.openTicks = ticks(number(data, "open"), tick);
+    bar.highTicks = ticks(number(data, "high"), tick);
+    bar.lowTicks = ticks(number(data, "low"), tick);
+    bar.closeTicks = ticks(number(data, "close"), tick);
+    bar.volume = scaled(number(data, "volume"), BINARY_AMOUNT_SCALE);
+    bar.vwapE8 = scaled(number(data, "vwap"), BINARY_PRICE_E8_SCALE);
+    bar.trades = static_cast<uint32_t>(number(data, "trades"));
+    bar.closed = data.value("closed", false) ? 1 : 0;
+
+    out.resize(sizeof(BinaryHeader) + sizeof(BinaryBar));
+    putHeader(out, BinaryMessageType::BAR, 0, static_cast<int64_t>(number(data, "timestamp")), instrument);
+    put(out, sizeof(BinaryHeader), bar);
+}
@@ -0,0 +1,374 @@
+#ifndef BINARY_PROTOCOL_H
+#define BINARY_PROTOCOL_H
+
+#include <cstdint>
+#include <cstring>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <nlohmann/json.hpp>
+
+using json = nlohmann::json;
+
+/*
+ * Binary encoding of the market data forwarded to local subscribers.
+ *
+ * Every message starts with a BinaryHeader followed by a fixed-layout body;
+ * books and trades end with an array of fixed-size records. All integers are
+ * little-endian. Prices of book levels and trades are integer ticks of the
+ * tick size carried in the message; mark/index style prices that are not on
+ * the tick grid use a fixed 1e-8 scale, and amounts a fixed 1e-4 scale.
+ *
+ * Decoders only take views over the received buffer, so no allocation is
+ * needed to read a message.
+ */
+
+constexpr uint16_t BINARY_SCHEMA_VERSION = 1;
+constexpr int64_t BINARY_AMOUNT_SCALE = 10000;       /**< Amounts are units of 1e-4 */
+constexpr int64_t BINARY_PRICE_E8_SCALE = 100000000; /**< Off-grid prices are units of 1e-8 */
+constexpr std::size_t BINARY_INSTRUMENT_SIZE = 32;   /**< NUL-padded instrument name */
+
+/**
+ * @brief Message types of the binary protocol
+ */
+enum class BinaryMessageType : uint16_t {
+    BOOK = 1, /**< Order book snapshot or change */
+    TICKER = 2, /**< Ticker */
+    TRADES = 3, /**< Batch of trades */
+    POSITION = 4, /**< Position */
+    BOOK_ANALYTICS = 5, /**< Mid, microprice, spread, imbalance and cumulative depth */
+    GREEKS = 6, /**< Implied volatility and greeks of an option */
+    BAR = 7 /**< OHLCV bar */
+};
+
+#pragma pack(push, 1)
+
+/**
+ * @brief Header common to every binary message
+ */
+struct BinaryHeader {
+    uint16_t schemaVersion; /**< BINARY_SCHEMA_VERSION */
+    uint16_t type; /**< BinaryMessageType */
+    uint32_t length; /**< Total message length including this header */
+    uint64_t sequence; /**< Per-topic sequence number (change_id, or the local sequence of delta books) */
+    int64_t timestampMs; /**< Exchange timestamp in milliseconds */
+    char instrument[BINARY_INSTRUMENT_SIZE]; /**< Instrument name, NUL-padded */
+};
+
+/**
+ * @brief Body of a BOOK message, followed by bidCount + askCount BinaryLevel records
+ */
+struct BinaryBook {
+    int64_t tickSizeE8; /**< Tick size in units of 1e-8 */
+    uint64_t previousSequence; /**< prev_change_id, 0 for snapshots */
+    uint8_t snapshot; /**< 1 for a full book, 0 for a change */
+    uint8_t reserved[3]; /**< Zero */
+    uint16_t bidCount; /**< Number of bid levels */
+    uint16_t askCount; /**< Number of ask levels */
+};
+
+/**
+ * @brief Book level; an amount of zero deletes the level in a change
+ */
+struct BinaryLevel {
+    int64_t priceTicks; /**< Price in ticks */
+    int64_t amount; /**< Amount in units of 1e-4 */
+};
+
+/**
+ * @brief Body of a TICKER message
+ */
+struct BinaryTicker {
+    int64_t tickSizeE8; /**< Tick size in units of 1e-8 */
+    int64_t bestBidTicks; /**< Best bid price in ticks */
+    int64_t bestBidAmount; /**< Best bid amount in units of 1e-4 */
+    int64_t bestAskTicks; /**< Best ask price in ticks */
+    int64_t bestAskAmount; /**< Best ask amount in units of 1e-4 */
+    int64_t lastTicks; /**< Last trade price in ticks */
+    int64_t markPriceE8; /**< Mark price in units of 1e-8 */
+    int64_t indexPriceE8; /**< Index price in units of 1e-8 */
+    int64_t openInterest; /**< Open interest in units of 1e-4 */
+    int64_t markIvE4; /**< Mark implied volatility in units of 1e-4 percent, 0 if absent */
+};
+
+/**
+ * @brief Body of a TRADES message, followed by count BinaryTrade records
+ */
+struct BinaryTrades {
+    int64_t tickSizeE8; /**< Tick size in units of 1e-8 */
+    uint32_t count; /**< Number of trades */
+    uint32_t reserved; /**< Zero */
+};
+
+/**
+ * @brief Trade record
+ */
+struct BinaryTrade {
+    uint64_t tradeSeq; /**< Trade sequence number */
+    int64_t timestampMs; /**< Trade timestamp in milliseconds */
+    int64_t priceTicks; /**< Price in ticks */
+    int64_t amount; /**< Amount in units of 1e-4 */
+    int64_t indexPriceE8; /**< Index price at the trade in units of 1e-8 */
+    uint8_t direction; /**< 0 buy, 1 sell */
+    uint8_t reserved[7]; /**< Zero */
+};
+
+/**
+ * @brief Body of a POSITION message
+ */
+struct BinaryPosition {
+    int64_t size; /**< Signed position size in units of 1e-4 */
+    int64_t averagePriceE8; /**< Average price in units of 1e-8 */
+    int64_t markPriceE8; /**< Mark price in units of 1e-8 */
+    int64_t floatingPnlE8; /**< Floating profit/loss in units of 1e-8 */
+    int64_t liquidationPriceE8; /**< Estimated liquidation price in units of 1e-8, 0 if none */
+};
+
+/**
+ * @brief Body of a BOOK_ANALYTICS message, followed by depth BinaryDepthLevel records
+ */
+struct BinaryBookAnalytics {
+    int64_t midE8; /**< Mid price in units of 1e-8 */
+    int64_t micropriceE8; /**< Microprice in units of 1e-8 */
+    int64_t spreadE8; /**< Spread in units of 1e-8 */
+    int64_t imbalanceE8; /**< Depth-weighted imbalance in units of 1e-8, from -1e8 to 1e8 */
+    uint16_t depth; /**< Number of depth records */
+    uint8_t reserved[6]; /**< Zero */
+};
+
+/**
+ * @brief Cumulative amounts down to one level
+ */
+struct BinaryDepthLevel {
+    int64_t bidAmount; /**< Bid amount of this and better levels in units of 1e-4 */
+    int64_t askAmount; /**< Ask amount of this and better levels in units of 1e-4 */
+};
+
+/**
+ * @brief Body of a GREEKS message
+ *
+ * Greeks span too many decades for a fixed scale, so they are IEEE-754
+ * doubles; NaN marks an option whose price had no solution.
+ */
+struct BinaryGreeks {
+    int64_t underlyingPriceE8; /**< Underlying price in units of 1e-8 */
+    int64_t priceE8; /**< Option price in the underlying currency in units of 1e-8 */
+    double iv; /**< Implied volatility, 0.5 for 50% */
+    double delta; /**< Delta */
+    double gamma; /**< Gamma */
+    double vega; /**< Vega per volatility point */
+    double theta; /**< Theta per day */
+};
+
+/**
+ * @brief Body of a BAR message; the header timestamp is the start of the bar
+ */
+struct BinaryBar {
+    int64_t tickSizeE8; /**< Tick size in units of 1e-8 */
+    int64_t resolutionMs; /**< Bar interval in milliseconds */
+    int64_t openTicks; /**< First trade price in ticks */
+    int64_t highTicks; /**< Highest trade price in ticks */
+    int64_t lowTicks; /**< Lowest trade price in ticks */
+    int64_t closeTicks; /**< Last trade price in ticks */
+    int64_t volume; /**< Sum of trade amounts in units of 1e-4 */
+    int64_t vwapE8; /**< Volume-weighted average price in units of 1e-8 */
+    uint32_t trades; /**< Number of trades */
+    uint8_t closed; /**< 1 once no more trades can change the bar */
+    uint8_t reserved[3]; /**< Zero */
+};
+
+#pragma pack(pop)
+
+static_assert(sizeof(BinaryHeader) == 56, "unexpected binary header size");
+static_assert(sizeof(BinaryLevel) == 16, "unexpected binary level size");
+static_assert(sizeof(BinaryTrade) == 48, "unexpected binary trade size");
+static_assert(sizeof(BinaryDepthLevel) == 16, "unexpected binary depth level size");
+static_assert(sizeof(BinaryBar) == 72, "unexpected binary bar size");
+
+/**
+ * @brief Read-only view over a received binary message
+ *
+ * Fixed-size records are copied out with memcpy, so the view works on any
+ * buffer alignment and never allocates.
+ */
+class BinaryMessageView {
+public:
+    /**
+     * @brief Validate a buffer and build a view over it
+     *
+     * @param data The received message
+     * @param size Size of the received message
+     * @return true if the buffer holds a complete message of a known schema version
+     */
+    bool parse(const char* data, std::size_t size);
+
+    /**
+     * @brief Get the message header
+     */
+    const BinaryHeader& header() const { return messageHeader; }
+
+    /**
+     * @brief Get the message type
+     */
+    BinaryMessageType type() const { return static_cast<BinaryMessageType>(messageHeader.type); }
+
+    /**
+     * @brief Get the instrument name (view into the header)
+     */
+    std::string_view instrument() const {
+        return std::string_view(messageHeader.instrument,
+                                strnlen(messageHeader.instrument, BINARY_INSTRUMENT_SIZE));
+    }
+
+    /**
+     * @brief Copy out the fixed body that follows the header
+     *
+     * @tparam Body One of BinaryBook, BinaryTicker, BinaryTrades, BinaryPosition, BinaryBookAnalytics, BinaryGreeks, BinaryBar
+     */
+    template <typename Body>
+    Body body() const {
+        Body value;
+        std::memcpy(&value, buffer + sizeof(BinaryHeader), sizeof(Body));
+        return value;
+    }
+
+    /**
+     * @brief Copy out a record of the array that follows the body
+     *
+     * @tparam Body Body type preceding the records
+     * @tparam Record Record type (BinaryLevel, BinaryTrade or BinaryDepthLevel)
+     * @param index Record index; for books, bids come first then asks
+     */
+    template <typename Body, typename Record>
+    Record record(std::size_t index) const {
+        Record value;
+        std::memcpy(&value, buffer + sizeof(BinaryHeader) + sizeof(Body) + index * sizeof(Record), sizeof(Record));
+        return value;
+    }
+
+private:
+    const char* buffer = nullptr; /**< Start of the message */
+    BinaryHeader messageHeader{}; /**< Copy of the header */
+};
+
+/**
+ * @brief Book levels held as parallel price/amount arrays
+ */
+struct BinaryLevelArrays {
+    const double* prices = nullptr; /**< Level prices */
+    const double* amounts = nullptr; /**< Level amounts, parallel to prices */
+    std::size_t count = 0; /**< Number of levels */
+};
+
+/**
+ * @brief Encodes Deribit notification data into binary protocol messages
+ *
+ * Tick sizes are looked up per instrument, as registered from the
+ * public/get_instruments metadata; instruments not listed yet use
+ * DEFAULT_TICK_SIZE, which divides every Deribit price grid. Every message
+ * carries the tick size its prices are counted in, so both decode the same.
+ * Tick sizes may be registered while other threads encode.
+ */
+class BinaryEncoder {
+public:
+    /**
+     * @brief Default tick size for instruments without a registered one
+     */
+    static constexpr double DEFAULT_TICK_SIZE = 0.0001;
+
+    /**
+     * @brief Register the tick size of an instrument
+     *
+     * Thread-safe; sizes that are not positive are ignored.
+     *
+     * @param instrument The instrument name
+     * @param tickSize The tick size from public/get_instruments
+     */
+    void setTickSize(const std::string& instrument, double tickSize);
+
+    /**
+     * @brief Get the tick size used for an instrument
+     *
+     * @param instrument The instrument name
+     */
+    double tickSize(const std::string& instrument) const;
+
+    /**
+     * @brief Encode book channel data
+     *
+     * @param data The "data" member of a book notification
+     * @param out Receives the message (its capacity is reused)
+     */
+    void encodeBook(const json& data, std::string& out) const;
+
+    /**
+     * @brief Encode book levels held by the caller
+     *
+     * @param instrument The instrument name
+     * @param sequence Sequence number of this message
+     * @param previousSequence Sequence number of the message it follows (0 for snapshots)
+     * @param timestampMs Exchange timestamp in milliseconds
+     * @param snapshot True for a full book, false for changed levels
+     * @param bids Bid levels
+     * @param asks Ask levels
+     * @param out Receives the message (its capacity is reused)
+     */
+    void encodeBook(const std::string& instrument, uint64_t sequence, uint64_t previousSequence,
+                    int64_t timestampMs, bool snapshot, const BinaryLevelArrays& bids,
+                    const BinaryLevelArrays& asks, std::string& out) const;
+
+    /**
+     * @brief Encode ticker channel data
+     *
+     * @param data The "data" member of a ticker notification
+     * @param out Receives the message (its capacity is reused)
+     */
+    void encodeTicker(const json& data, std::string& out) const;
+
+    /**
+     * @brief Encode trades channel data
+     *
+     * @param data The "data" member of a trades notification (an array)
+     * @param out Receives the message (its capacity is reused)
+     */
+    void encodeTrades(const json& data, std::string& out) const;
+
+    /**
+     * @brief Encode position data
+     *
+     * @param data A position object
+     * @param out Receives the message (its capacity is reused)
+     */
+    void encodePosition(const json& data, std::string& out) const;
+
+    /**
+     * @brief Encode book analytics
+     *
+     * @param data Book analytics as serialized by BookAnalytics::toJson
+     * @param out Receives the message (its capacity is reused)
+     */
+    void encodeBookAnalytics(const json& data, std::string& out) const;
+
+    /**
+     * @brief Encode the greeks of an option
+     *
+     * @param data Greeks as serialized by OptionChain::toJson
+     * @param out Receives the message (its capacity is reused)
+     */
+    void encodeGreeks(const json& data, std::string& out) const;
+
+    /**
+     * @brief Encode an OHLCV bar
+     *
+     * @param data Bar as serialized by BarAggregator::toJson
+     * @param out Receives the message (its capacity is reused)
+     */
+    void encodeBar(const json& data, std::string& out) const;
+
+private:
+    std::unordered_map<std::string, double> tickSizes; /**< Registered tick sizes */
+    mutable std::shared_mutex tickSizesMutex; /**< Guards tickSizes; encoders take it shared */
+};
+
+#endif // BINARY_PROTOCOL_H
@@ -1,12 +1,13 @@
 // rest_client.cpp
 #include "rest_client.h"
 #include <curl/curl.h>
+#include <algorithm>
 #include <sstream>
 
 // Private implementation class
 class RestClient::Impl {
 public:
-    Impl() : curl(nullptr), headers(nullptr), lastResponseCode(0) {
+    Impl() : curl(nullptr), headers(nullptr), lastResponseCode(0), timeoutMs(30000) {
         curl = curl_easy_init();
         if (!curl) {
             throw RestClient::Exception("Failed to initialize CURL");
@@ -26,8 +27,14 @@ public:
     struct curl_slist* headers;
     std::string lastError;
     long lastResponseCode;
+    long timeoutMs;
     std::map<std::string, std::string> headerMap;
 
+    void applyTimeout() {
+        curl_easy_setopt(curl, CURLOPT_TIMEOUT_MS, timeoutMs);
+        curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT_MS, std::min(timeoutMs, 10000L));
+    }
+
     static size_t WriteCallback(void* contents, size_t size, size_t nmemb, std::string* userp) {
         userp->append((char*)contents, size * nmemb);
         return size * nmemb;
@@ -86,8 +93,7 @@ RestClient::~RestClient() = default;
 std::string RestClient::get(const std::string& url) {
     curl_easy_setopt(pimpl->curl, CURLOPT_HTTPGET, 1L);
     curl_easy_setopt(pimpl->curl, CURLOPT_URL, url.c_str());
-    curl_easy_setopt(pimpl->curl, CURLOPT_CONNECTTIMEOUT, 10L);  
-    setTimeout(30);  // Default 30 seconds if not set
+    pimpl->applyTimeout();
     pimpl->updateHeaders();
     return pimpl->performRequest();
 }
@@ -96,8 +102,7 @@ std::string RestClient::post(const std::string& url, const std::string& payload)
     curl_easy_setopt(pimpl->curl, CURLOPT_POST, 1L);
     curl_easy_setopt(pimpl->curl, CURLOPT_URL, url.c_str());
     curl_easy_setopt(pimpl->curl, CURLOPT_POSTFIELDS, payload.c_str());
-    curl_easy_setopt(pimpl->curl, CURLOPT_CONNECTTIMEOUT, 10L);  
-    setTimeout(30);  // Default 30 seconds if not set
+    pimpl->applyTimeout();
     pimpl->updateHeaders();
     return pimpl->performRequest();
 }
@@ -106,8 +111,7 @@ std::string RestClient::put(const std::string& url, const std::string& payload)
     curl_easy_setopt(pimpl->curl, CURLOPT_CUSTOMREQUEST, "PUT");
     curl_easy_setopt(pimpl->curl, CURLOPT_URL, url.c_str());
     curl_easy_setopt(pimpl->curl, CURLOPT_POSTFIELDS, payload.c_str());
-    curl_easy_setopt(pimpl->curl, CURLOPT_CONNECTTIMEOUT, 10L);  
-    setTimeout(30);  // Default 30 seconds if not set
+    pimpl->applyTimeout();
     pimpl->updateHeaders();
     return pimpl->performRequest();
 }
@@ -115,6 +119,7 @@ std::string RestClient::put(const std::string& url, const std::string& payload)
 std::string RestClient::del(const std::string& url) {
     curl_easy_setopt(pimpl->curl, CURLOPT_CUSTOMREQUEST, "DELETE");
     curl_easy_setopt(pimpl->curl, CURLOPT_URL, url.c_str());
+    pimpl->applyTimeout();
     pimpl->updateHeaders();
     return pimpl->performRequest();
 }
@@ -124,7 +129,12 @@ void RestClient::setHeader(const std::string& key, const std::string& value) {
 }
 
 void RestClient::setTimeout(long seconds) {
-    curl_easy_setopt(pimpl->curl, CURLOPT_TIMEOUT, seconds);
+    pimpl->timeoutMs = seconds * 1000;
+}
+
+void RestClient::setTimeoutMs(long milliseconds) {
+    // 0 would mean no timeout to curl
+    pimpl->timeoutMs = std::max(milliseconds, 1L);
 }
 
 void RestClient::setVerifySsl(bool verify) {
@@ -72,6 +72,15 @@ public:
      * @param seconds The timeout in seconds
      */
     void setTimeout(long seconds);
+
+    /**
+     * @brief Set the timeout for the following requests in milliseconds
+     * 
+     * The connect timeout is capped to the same budget.
+     * 
+     * @param milliseconds The whole-request timeout, 30 s by default
+     */
+    void setTimeoutMs(long milliseconds);
     
     /**
      * @brief Set whether to verify SSL certificates
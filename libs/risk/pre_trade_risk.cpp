@@ -0,0 +1,311 @@
+#include "pre_trade_risk.h"
+#include "env_handler.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+    // Ended orders remembered in case their placement answer is still on its way
+    constexpr std::size_t ENDED_ORDERS = 1024;
+
+    double envNumber(const std::string& name) {
+        std::string value = EnvHandler::getEnvVariable(name);
+        return value.empty() ? 0 : std::stod(value);
+    }
+}
+
+PreTradeRisk::PreTradeRisk() {
+    defaults.maxOrderAmount = envNumber("RISK_MAX_ORDER_AMOUNT");
+    defaults.maxPosition = envNumber("RISK_MAX_POSITION");
+    defaults.priceCollar = envNumber("RISK_PRICE_COLLAR_BPS") / 10000.0;
+    maxOpenOrders = static_cast<uint32_t>(envNumber("RISK_MAX_OPEN_ORDERS"));
+    maxOrdersPerSecond = envNumber("RISK_MAX_ORDERS_PER_SEC");
+    instrumentLimits = defaults.maxOrderAmount > 0 || defaults.maxPosition > 0 || defaults.priceCollar > 0;
+
+    rateTokens = maxOrdersPerSecond;
+    rateUpdated = std::chrono::steady_clock::now();
+}
+
+void PreTradeRisk::setFollow(std::function<void(const std::string&)> follow) {
+    std::lock_guard<std::mutex> lock(mutex);
+    this->follow = std::move(follow);
+}
+
+std::size_t PreTradeRisk::indexOf(const std::string& instrument) {
+    std::size_t index;
+    std::function<void(const std::string&)> subscribe;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        index = indexLocked(instrument);
+        if (needsFollowLocked(index)) {
+            subscribe = follow;
+        }
+    }
+    if (subscribe) {
+        subscribe(instrument);
+    }
+    return index;
+}
+
+bool PreTradeRisk::needsFollowLocked(std::size_t instrument) {
+    if (followed[instrument] || (maxPosition[instrument] <= 0 && priceCollar[instrument] <= 0)) {
+        return false;
+    }
+    followed[instrument] = true;
+    return true;
+}
+
+std::size_t PreTradeRisk::indexLocked(const std::string& instrument) {
+    auto it = indices.find(instrument);
+    if (it != indices.end()) {
+        return it->second;
+    }
+
+    std::size_t index = indices.size();
+    indices.emplace(instrument, index);
+    maxOrderAmount.push_back(defaults.maxOrderAmount);
+    maxPosition.push_back(defaults.maxPosition);
+    priceCollar.push_back(defaults.priceCollar);
+    markPrice.push_back(0);
+    position.push_back(0);
+    positionKnown.push_back(false);
+    followed.push_back(false);
+    workingBuy.push_back(0);
+    workingSell.push_back(0);
+    return index;
+}
+
+void PreTradeRisk::setLimits(const std::string& instrument, const Limits& limits) {
+    std::function<void(const std::string&)> subscribe;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::size_t index = indexLocked(instrument);
+        maxOrderAmount[index] = limits.maxOrderAmount;
+        maxPosition[index] = limits.maxPosition;
+        priceCollar[index] = limits.priceCollar;
+        instrumentLimits = instrumentLimits || limits.maxOrderAmount > 0 || limits.maxPosition > 0 ||
+                           limits.priceCollar > 0;
+        if (needsFollowLocked(index)) {
+            subscribe = follow;
+        }
+    }
+    // Subscribed now, so the mark price and position are usually known by the first order
+    if (subscribe) {
+        subscribe(instrument);
+    }
+}
+
+RiskCheck PreTradeRisk::checkLimitsLocked(std::size_t instrument, bool buy, double amount, double added,
+                                         double price) const {
+    double maxAmount = maxOrderAmount[instrument];
+    if (maxAmount > 0 && amount > maxAmount) {
+        return RiskCheck::ORDER_SIZE;
+    }
+
+    // Worst case: every working order on this side fills as well
+    double limit = maxPosition[instrument];
+    if (limit > 0 && added > 0) {
+        if (!positionKnown[instrument]) {
+            return RiskCheck::NO_POSITION;
+        }
+        double projected = buy ? position[instrument] + workingBuy[instrument] + added
+                               : position[instrument] - workingSell[instrument] - added;
+        if (std::fabs(projected) > limit) {
+            return RiskCheck::POSITION;
+        }
+    }
+
+    double collar = priceCollar[instrument];
+    double mark = markPrice[instrument];
+    if (collar > 0 && price > 0) {
+        if (mark <= 0) {
+            return RiskCheck::NO_MARK;
+        }
+        if (std::fabs(price - mark) > collar * mark) {
+            return RiskCheck::PRICE_COLLAR;
+        }
+    }
+    return RiskCheck::PASSED;
+}
+
+RiskCheck PreTradeRisk::reserve(std::size_t instrument, bool buy, double amount, double price) {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    RiskCheck check = checkLimitsLocked(instrument, buy, amount, amount, price);
+    if (check != RiskCheck::PASSED) {
+        return check;
+    }
+
+    if (maxOpenOrders > 0 && openOrders >= maxOpenOrders) {
+        return RiskCheck::OPEN_ORDERS;
+    }
+
+    // Token bucket holding up to one second of orders
+    if (maxOrdersPerSecond > 0) {
+        auto now = std::chrono::steady_clock::now();
+        double elapsed = std::chrono::duration<double>(now - rateUpdated).count();
+        rateTokens = std::min(maxOrdersPerSecond, rateTokens + elapsed * maxOrdersPerSecond);
+        rateUpdated = now;
+        if (rateTokens < 1) {
+            return RiskCheck::MESSAGE_RATE;
+        }
+        rateTokens -= 1;
+    }
+
+    ++openOrders;
+    (buy ? workingBuy : workingSell)[instrument] += amount;
+    return RiskCheck::PASSED;
+}
+
+RiskCheck PreTradeRisk::reserveEdit(const std::string& orderId, double amount, double price, double& increase) {
+    std::lock_guard<std::mutex> lock(mutex);
+    increase = 0;
+
+    auto it = working.find(orderId);
+    if (it == working.end()) {
+        return instrumentLimits ? RiskCheck::UNKNOWN_ORDER : RiskCheck::PASSED;
+    }
+    WorkingOrder& order = it->second;
+
+    // A decrease is only released once Deribit confirms the edit
+    double added = std::max(0.0, amount - order.filled - order.remaining);
+    RiskCheck check = checkLimitsLocked(order.instrument, order.buy, amount, added, price);
+    if (check != RiskCheck::PASSED) {
+        return check;
+    }
+
+    increase = added;
+    order.remaining += added;
+    (order.buy ? workingBuy : workingSell)[order.instrument] += added;
+    return RiskCheck::PASSED;
+}
+
+void PreTradeRisk::releaseEdit(const std::string& orderId, double increase) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = working.find(orderId);
+    if (it == working.end()) {
+        return; // Ended meanwhile, which released everything it held
+    }
+    WorkingOrder& order = it->second;
+    increase = std::min(increase, order.remaining);
+    order.remaining -= increase;
+    releaseLocked(order.instrument, order.buy, increase);
+}
+
+void PreTradeRisk::release(std::size_t instrument, bool buy, double amount) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (openOrders > 0) {
+        --openOrders;
+    }
+    releaseLocked(instrument, buy, amount);
+}
+
+void PreTradeRisk::releaseLocked(std::size_t instrument, bool buy, double amount) {
+    double& exposure = (buy ? workingBuy : workingSell)[instrument];
+    exposure = std::max(0.0, exposure - amount);
+}
+
+void PreTradeRisk::onOrder(const std::string& orderId, const std::string& instrument, bool buy,
+                           const std::string& state, double amount, double filled, double reserved) {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    bool open = state == "open" || state == "untriggered";
+    auto it = working.find(orderId);
+    if (it == working.end()) {
+        if (reserved <= 0) {
+            // Not placed through this gateway, or its placement answer is still on its way
+            if (!open && endedOrders.emplace(orderId, filled).second) {
+                endedOrder.push_back(orderId);
+                if (endedOrder.size() > ENDED_ORDERS) {
+                    endedOrders.erase(endedOrder.front());
+                    endedOrder.pop_front();
+                }
+            }
+            return;
+        }
+        it = working.emplace(orderId, WorkingOrder{indexLocked(instrument), buy, reserved, 0, trackedOrders++}).first;
+
+        auto ended = endedOrders.find(orderId);
+        if (ended != endedOrders.end()) {
+            open = false;
+            filled = std::max(filled, ended->second);
+            endedOrders.erase(ended);
+        }
+    }
+    WorkingOrder& order = it->second;
+
+    // Fills since the last sighting; Deribit's position updates replace this estimate
+    double fill = filled - order.filled;
+    if (fill > 0) {
+        position[order.instrument] += order.buy ? fill : -fill;
+        order.filled = filled;
+    }
+
+    double remaining = open ? std::max(0.0, amount - filled) : 0;
+    double& exposure = (order.buy ? workingBuy : workingSell)[order.instrument];
+    exposure = std::max(0.0, exposure + remaining - order.remaining);
+    order.remaining = remaining;
+
+    if (!open) {
+        working.erase(it);
+        if (openOrders > 0) {
+            --openOrders;
+        }
+    }
+}
+
+void PreTradeRisk::clearOrders() {
+    std::lock_guard<std::mutex> lock(mutex);
+    working.clear();
+    openOrders = 0;
+    std::fill(workingBuy.begin(), workingBuy.end(), 0.0);
+    std::fill(workingSell.begin(), workingSell.end(), 0.0);
+}
+
+uint64_t PreTradeRisk::reconcileStart() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return trackedOrders;
+}
+
+void PreTradeRisk::reconcile(const std::unordered_set<std::string>& open, uint64_t start) {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto it = working.begin(); it != working.end();) {
+        const WorkingOrder& order = it->second;
+        if (order.tracked >= start || open.count(it->first)) {
+            ++it;
+            continue;
+        }
+        // Its fills arrive with the position
+        releaseLocked(order.instrument, order.buy, order.remaining);
+        if (openOrders > 0) {
+            --openOrders;
+        }
+        it = working.erase(it);
+    }
+}
+
+void PreTradeRisk::updateMark(const std::string& instrument, double price) {
+    std::lock_guard<std::mutex> lock(mutex);
+    markPrice[indexLocked(instrument)] = price;
+}
+
+void PreTradeRisk::updatePosition(const std::string& instrument, double size) {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::size_t index = indexLocked(instrument);
+    position[index] = size;
+    positionKnown[index] = true;
+}
+
+const char* PreTradeRisk::describe(RiskCheck check) {
+    switch (check) {
+        case RiskCheck::PASSED: return "passed";
+        case RiskCheck::ORDER_SIZE: return "order size above limit";
+        case RiskCheck::POSITION: return "position limit would be exceeded";
+        case RiskCheck::PRICE_COLLAR: return "price outside collar around mark price";
+        case RiskCheck::OPEN_ORDERS: return "too many open orders";
+        case RiskCheck::MESSAGE_RATE: return "order rate limit reached";
+        case RiskCheck::UNKNOWN_ORDER: return "order not placed through this gateway";
+        case RiskCheck::NO_MARK: return "no mark price yet for the price collar";
+        case RiskCheck::NO_POSITION: return "position not known yet for the position limit";
+    }
+    return "unknown";
+}
@@ -0,0 +1,293 @@
+#ifndef PRE_TRADE_RISK_H
+#define PRE_TRADE_RISK_H
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+/**
+ * @brief Reason a pre-trade check failed
+ */
+enum class RiskCheck {
+    PASSED, /**< The order may be sent */
+    ORDER_SIZE, /**< Amount above the instrument's maximum order size */
+    POSITION, /**< Position plus working orders would exceed the instrument's maximum */
+    PRICE_COLLAR, /**< Price too far from the cached mark price */
+    OPEN_ORDERS, /**< Too many orders working */
+    MESSAGE_RATE, /**< Order rate limit reached */
+    UNKNOWN_ORDER, /**< Edit of an order not tracked here, while instrument limits are set */
+    NO_MARK, /**< Price collar set, but no mark price cached yet */
+    NO_POSITION /**< Position limit set, but the position is not known yet */
+};
+
+/**
+ * @brief Exception thrown for an order rejected before it is queued
+ */
+class RiskRejection : public std::runtime_error {
+public:
+    /**
+     * @brief Construct a new RiskRejection object
+     *
+     * @param check The failed check
+     * @param message The exception message
+     */
+    RiskRejection(RiskCheck check, const std::string& message) : std::runtime_error(message), failed(check) {}
+
+    /**
+     * @brief Get the failed check
+     */
+    RiskCheck check() const { return failed; }
+
+private:
+    RiskCheck failed; /**< The failed check */
+};
+
+/**
+ * @brief Pre-trade risk checks against cached limits and state
+ *
+ * Instruments get a dense index the first time they are seen; limits and
+ * state live in flat arrays indexed by it, so a check is a handful of loads
+ * and compares under one uncontended lock. A passing check reserves the
+ * order: it counts as working, and its amount as exposure towards the
+ * position limit, until release() or the order's end is seen. Edits of
+ * tracked orders get the size, position and collar checks, and reserve any
+ * increase of the remaining amount until the edit's answer arrives.
+ *
+ * Collars and position limits need the mark price and position; an
+ * instrument with either is handed to the follow function so the owner
+ * feeds them, and its orders are rejected until they are known.
+ *
+ * A limit of zero disables that check. Amounts are in the instrument's
+ * order units (USD for inverse futures, coins for options).
+ */
+class PreTradeRisk {
+public:
+    /**
+     * @brief Limits of one instrument
+     */
+    struct Limits {
+        double maxOrderAmount = 0; /**< Largest single order */
+        double maxPosition = 0; /**< Largest absolute position including working orders */
+        double priceCollar = 0; /**< Largest relative distance of a limit price from the mark price */
+    };
+
+    /**
+     * @brief Construct with limits from the environment
+     *
+     * Reads RISK_MAX_ORDER_AMOUNT, RISK_MAX_POSITION and RISK_PRICE_COLLAR_BPS
+     * as every instrument's defaults, and RISK_MAX_OPEN_ORDERS and
+     * RISK_MAX_ORDERS_PER_SEC as account-wide limits.
+     */
+    PreTradeRisk();
+
+    /**
+     * @brief Set the function called with an instrument that needs its mark price and position
+     *
+     * Called once per instrument, the first time it is seen with a price
+     * collar or position limit, without the lock held. The owner uses it to
+     * subscribe the instrument's ticker and position.
+     *
+     * @param follow Receives the instrument name
+     */
+    void setFollow(std::function<void(const std::string& instrument)> follow);
+
+    /**
+     * @brief Get the dense index of an instrument, adding it with default limits
+     *
+     * @param instrument The instrument name
+     * @return std::size_t The index
+     */
+    std::size_t indexOf(const std::string& instrument);
+
+    /**
+     * @brief Set the limits of one instrument
+     *
+     * @param instrument The instrument name
+     * @param limits The limits
+     */
+    void setLimits(const std::string& instrument, const Limits& limits);
+
+    /**
+     * @brief Check an order and reserve it if it passes
+     *
+     * @param instrument The instrument index
+     * @param buy True for a buy, false for a sell
+     * @param amount The order amount
+     * @param price The limit price, or 0 for orders without one
+     * @return RiskCheck PASSED, or the first check that failed
+     */
+    RiskCheck reserve(std::size_t instrument, bool buy, double amount, double price);
+
+    /**
+     * @brief Check an edit of a working order and reserve its increase if it passes
+     *
+     * Orders not tracked here (placed elsewhere, or before a restart) have no
+     * known instrument; their edits fail with UNKNOWN_ORDER unless no
+     * instrument limit is set.
+     *
+     * @param orderId The order id
+     * @param amount The new order amount
+     * @param price The new limit price, or 0 for orders without one
+     * @param increase Receives the amount reserved beyond the order's current remaining amount
+     * @return RiskCheck PASSED, or the first check that failed
+     */
+    RiskCheck reserveEdit(const std::string& orderId, double amount, double price, double& increase);
+
+    /**
+     * @brief Release the increase reserved for an edit that was not applied
+     *
+     * @param orderId The order id
+     * @param increase The amount reserveEdit reserved
+     */
+    void releaseEdit(const std::string& orderId, double increase);
+
+    /**
+     * @brief Release a reservation whose order never reached the book
+     *
+     * @param instrument The instrument index
+     * @param buy True for a buy, false for a sell
+     * @param amount The reserved amount
+     */
+    void release(std::size_t instrument, bool buy, double amount);
+
+    /**
+     * @brief Track an order from a Deribit order object
+     *
+     * Open orders keep their remaining amount reserved under their id; filled,
+     * cancelled and rejected orders release it, and fills not yet reflected in
+     * a position update are added to the position. The end of an order not
+     * tracked yet is remembered for a while, so a placement answer that
+     * arrives after the order's end notification does not leave it working.
+     *
+     * @param orderId The order id
+     * @param instrument The instrument name
+     * @param buy True for a buy, false for a sell
+     * @param state Deribit order_state
+     * @param amount The order amount
+     * @param filled The filled amount
+     * @param reserved The amount reserved by reserve() for a new order, 0 for an update
+     */
+    void onOrder(const std::string& orderId, const std::string& instrument, bool buy, const std::string& state,
+                 double amount, double filled, double reserved);
+
+    /**
+     * @brief Release every working order, after a cancel of all orders
+     */
+    void clearOrders();
+
+    /**
+     * @brief Mark the start of a reconciliation against Deribit's open orders
+     *
+     * @return uint64_t The mark to pass to reconcile()
+     */
+    uint64_t reconcileStart();
+
+    /**
+     * @brief Release tracked orders missing from Deribit's open orders
+     *
+     * Orders that ended while their notification could not arrive, such as
+     * during a disconnect, are released. Orders first tracked after the mark
+     * are kept, since the open orders may predate them.
+     *
+     * @param open Ids of the open orders
+     * @param start The mark reconcileStart() returned before they were requested
+     */
+    void reconcile(const std::unordered_set<std::string>& open, uint64_t start);
+
+    /**
+     * @brief Update the cached mark price
+     *
+     * @param instrument The instrument name
+     * @param price The mark price
+     */
+    void updateMark(const std::string& instrument, double price);
+
+    /**
+     * @brief Replace the position with Deribit's figure
+     *
+     * The position counts as known from then on.
+     *
+     * @param instrument The instrument name
+     * @param size The signed position size
+     */
+    void updatePosition(const std::string& instrument, double size);
+
+    /**
+     * @brief Describe a check result
+     *
+     * @param check The result
+     * @return const char* A short description
+     */
+    static const char* describe(RiskCheck check);
+
+private:
+    /**
+     * @brief Working order tracked by id
+     */
+    struct WorkingOrder {
+        std::size_t instrument; /**< Instrument index */
+        bool buy; /**< Side */
+        double remaining; /**< Amount still reserved */
+        double filled; /**< Filled amount last seen */
+        uint64_t tracked; /**< Value of trackedOrders when tracking started */
+    };
+
+    /**
+     * @brief Mark an instrument followed if its limits need reference data; the caller holds mutex
+     *
+     * @return bool True if it should be handed to the follow function now
+     */
+    bool needsFollowLocked(std::size_t instrument);
+
+    /**
+     * @brief Get the index of an instrument; the caller holds mutex
+     */
+    std::size_t indexLocked(const std::string& instrument);
+
+    /**
+     * @brief Release exposure; the caller holds mutex
+     */
+    void releaseLocked(std::size_t instrument, bool buy, double amount);
+
+    /**
+     * @brief Run the size, position and collar checks; the caller holds mutex
+     *
+     * @param added Amount the order would add to the side's working exposure
+     */
+    RiskCheck checkLimitsLocked(std::size_t instrument, bool buy, double amount, double added, double price) const;
+
+    Limits defaults; /**< Limits given to new instruments */
+    bool instrumentLimits = false; /**< True once any instrument has a size, position or collar limit */
+    uint32_t maxOpenOrders = 0; /**< Largest number of working orders */
+    double maxOrdersPerSecond = 0; /**< Order rate limit */
+
+    std::unordered_map<std::string, std::size_t> indices; /**< Instrument indices by name */
+    std::vector<double> maxOrderAmount; /**< Limits::maxOrderAmount by instrument */
+    std::vector<double> maxPosition; /**< Limits::maxPosition by instrument */
+    std::vector<double> priceCollar; /**< Limits::priceCollar by instrument */
+    std::vector<double> markPrice; /**< Cached mark price by instrument, 0 until known */
+    std::vector<double> position; /**< Signed position by instrument */
+    std::vector<char> positionKnown; /**< True once Deribit's position has been seen, by instrument */
+    std::vector<char> followed; /**< True once handed to the follow function, by instrument */
+    std::vector<double> workingBuy; /**< Amount of working buys by instrument */
+    std::vector<double> workingSell; /**< Amount of working sells by instrument */
+
+    uint32_t openOrders = 0; /**< Working orders, reserved or open */
+    double rateTokens = 0; /**< Orders the rate limit still allows now */
+    std::chrono::steady_clock::time_point rateUpdated; /**< When rateTokens was last refilled */
+    std::unordered_map<std::string, WorkingOrder> working; /**< Open orders by id */
+    uint64_t trackedOrders = 0; /**< Orders tracked so far */
+    std::unordered_map<std::string, double> endedOrders; /**< Filled amounts of recently ended untracked orders */
+    std::deque<std::string> endedOrder; /**< Ids in endedOrders, oldest first */
+    std::function<void(const std::string&)> follow; /**< Subscribes an instrument's mark price and position */
+    std::mutex mutex; /**< Mutex for synchronizing access to all of the above */
+};
+
+#endif // PRE_TRADE_RISK_H
@@ -0,0 +1,214 @@
+#include "shm_ring.h"
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <new>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+    constexpr std::size_t RECORD_ALIGNMENT = 8;
+
+    std::string shmPath(const std::string& name) {
+        return name.empty() || name[0] != '/' ? "/" + name : name;
+    }
+
+    std::size_t roundUpPowerOfTwo(std::size_t value) {
+        std::size_t result = 4096;
+        while (result < value) result <<= 1;
+        return result;
+    }
+
+    std::size_t recordLength(std::size_t topic, std::size_t payload) {
+        std::size_t length = sizeof(ShmRecordHeader) + topic + payload;
+        return (length + RECORD_ALIGNMENT - 1) & ~(RECORD_ALIGNMENT - 1);
+    }
+}
+
+ShmRingWriter::ShmRingWriter(const std::string& name, std::size_t capacity)
+    : shmName(shmPath(name)) {
+    std::size_t ringSize = roundUpPowerOfTwo(capacity);
+    mappedSize = SHM_RING_DATA_OFFSET + ringSize;
+
+    // Replace any ring left behind by a previous run; attached readers keep the old one
+    shm_unlink(shmName.c_str());
+    int fd = shm_open(shmName.c_str(), O_CREAT | O_EXCL | O_RDWR, 0640);
+    if (fd < 0) {
+        throw Exception("shm_open " + shmName + ": " + std::strerror(errno));
+    }
+    if (ftruncate(fd, static_cast<off_t>(mappedSize)) != 0) {
+        int error = errno;
+        close(fd);
+        shm_unlink(shmName.c_str());
+        throw Exception("ftruncate " + shmName + ": " + std::strerror(error));
+    }
+
+    void* address = mmap(nullptr, mappedSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (address == MAP_FAILED) {
+        shm_unlink(shmName.c_str());
+        throw Exception("mmap " + shmName + ": " + std::strerror(errno));
+    }
+
+    header = new (address) ShmRingHeader();
+    header->capacity = ringSize;
+    header->claimed.store(0, std::memory_order_relaxed);
+    header->committed.store(0, std::memory_order_relaxed);
+    data = static_cast<char*>(address) + SHM_RING_DATA_OFFSET;
+
+    // Readers check the magic last, so they never see a half-initialized header
+    header->version = SHM_RING_VERSION;
+    std::atomic_thread_fence(std::memory_order_release);
+    header->magic = SHM_RING_MAGIC;
+}
+
+ShmRingWriter::~ShmRingWriter() {
+    if (header) {
+        munmap(header, mappedSize);
+        shm_unlink(shmName.c_str());
+    }
+}
+
+bool ShmRingWriter::publish(std::string_view topic, std::string_view payload, bool binary) {
+    const uint64_t capacity = header->capacity;
+    std::size_t length = recordLength(topic.size(), payload.size());
+    if (length > capacity / 4 || topic.size() > UINT16_MAX) {
+        return false;
+    }
+
+    uint64_t offset = position & (capacity - 1);
+    uint64_t padding = capacity - offset < length ? capacity - offset : 0;
+
+    // Announce the bytes about to be overwritten before touching them
+    header->claimed.store(position + padding + length, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    if (padding > 0) {
+        // Tails too short for a header are skipped by readers without one
+        if (padding >= sizeof(ShmRecordHeader)) {
+            ShmRecordHeader pad{};
+            pad.length = static_cast<uint32_t>(padding);
+            pad.type = SHM_RECORD_PADDING;
+            std::memcpy(data + offset, &pad, sizeof(pad));
+        }
+        position += padding;
+        offset = 0;
+    }
+
+    ShmRecordHeader record{};
+    record.length = static_cast<uint32_t>(length);
+    record.type = SHM_RECORD_MESSAGE;
+    record.topicLength = static_cast<uint16_t>(topic.size());
+    record.payloadLength = static_cast<uint32_t>(payload.size());
+    record.binary = binary ? 1 : 0;
+    record.sequence = ++sequence;
+
+    char* out = data + offset;
+    std::memcpy(out, &record, sizeof(record));
+    std::memcpy(out + sizeof(record), topic.data(), topic.size());
+    std::memcpy(out + sizeof(record) + topic.size(), payload.data(), payload.size());
+
+    position += length;
+    header->committed.store(position, std::memory_order_release);
+    return true;
+}
+
+ShmRingReader::ShmRingReader(const std::string& name) {
+    std::string path = shmPath(name);
+    int fd = shm_open(path.c_str(), O_RDONLY, 0);
+    if (fd < 0) {
+        throw Exception("shm_open " + path + ": " + std::strerror(errno));
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || static_cast<std::size_t>(info.st_size) < SHM_RING_DATA_OFFSET) {
+        close(fd);
+        throw Exception("Not a ring: " + path);
+    }
+    mappedSize = static_cast<std::size_t>(info.st_size);
+
+    void* address = mmap(nullptr, mappedSize, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (address == MAP_FAILED) {
+        throw Exception("mmap " + path + ": " + std::strerror(errno));
+    }
+
+    header = static_cast<const ShmRingHeader*>(address);
+    data = static_cast<const char*>(address) + SHM_RING_DATA_OFFSET;
+    bool valid = header->magic == SHM_RING_MAGIC;
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (!valid || header->version != SHM_RING_VERSION ||
+        SHM_RING_DATA_OFFSET + header->capacity != mappedSize) {
+        munmap(address, mappedSize);
+        header = nullptr;
+        throw Exception("Not a compatible ring: " + path);
+    }
+
+    capacity = header->capacity;
+    position = header->committed.load(std::memory_order_acquire);
+}
+
+ShmRingReader::~ShmRingReader() {
+    if (header) {
+        munmap(const_cast<ShmRingHeader*>(header), mappedSize);
+    }
+}
+
+void ShmRingReader::resync() {
+    // The sequence of the next message read tells how many were skipped
+    position = header->committed.load(std::memory_order_acquire);
+}
+
+ShmRingReader::Status ShmRingReader::poll(ShmMessage& message) {
+    for (;;) {
+        uint64_t committed = header->committed.load(std::memory_order_acquire);
+        if (position == committed) {
+            return Status::EMPTY;
+        }
+        if (committed - position > capacity) {
+            resync();
+            return Status::OVERRUN;
+        }
+
+        uint64_t offset = position & (capacity - 1);
+        uint64_t remaining = capacity - offset;
+        if (remaining < sizeof(ShmRecordHeader)) {
+            position += remaining;
+            continue;
+        }
+
+        ShmRecordHeader record;
+        std::memcpy(&record, data + offset, sizeof(record));
+
+        // A torn header can hold anything; bound it before using it
+        bool sane = record.length >= sizeof(ShmRecordHeader) && record.length <= remaining &&
+                    (record.type == SHM_RECORD_PADDING ||
+                     sizeof(ShmRecordHeader) + record.topicLength + record.payloadLength <= record.length);
+        if (sane && record.type == SHM_RECORD_MESSAGE) {
+            const char* body = data + offset + sizeof(record);
+            message.topic.assign(body, record.topicLength);
+            message.payload.assign(body + record.topicLength, record.payloadLength);
+        }
+
+        // The copy is only good if the writer has not started overwriting it meanwhile
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (header->claimed.load(std::memory_order_relaxed) - position > capacity || !sane) {
+            resync();
+            return Status::OVERRUN;
+        }
+
+        position += record.length;
+        if (record.type == SHM_RECORD_PADDING) {
+            continue;
+        }
+
+        if (nextSequence != 0 && record.sequence > nextSequence) {
+            lostMessages += record.sequence - nextSequence;
+        }
+        nextSequence = record.sequence + 1;
+        message.sequence = record.sequence;
+        message.binary = record.binary != 0;
+        return Status::MESSAGE;
+    }
+}
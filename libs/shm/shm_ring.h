@@ -0,0 +1,190 @@
+#ifndef SHM_RING_H
+#define SHM_RING_H
+
+#include <atomic>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+/*
+ * Single-producer / multi-consumer ring of messages in POSIX shared memory.
+ *
+ * The segment starts with a ShmRingHeader page followed by `capacity` bytes
+ * of records. Positions are monotonic byte counts; a record never wraps, the
+ * writer pads to the end of the ring instead. Readers keep their own
+ * position and never write to the segment, so any number of processes can
+ * attach without coordinating with the writer or each other.
+ *
+ * Overruns are detected seqlock-style: the writer advances `claimed` before
+ * overwriting bytes and `committed` after publishing them. A reader copies a
+ * record, then checks that `claimed` has not moved more than one ring past
+ * the record's start; if it has, the copy may be torn and the reader skips to
+ * the newest data. Per-record sequence numbers tell it how much was lost.
+ */
+
+constexpr uint64_t SHM_RING_MAGIC = 0x474e495242524544ULL; /**< "DERBRING" */
+constexpr uint32_t SHM_RING_VERSION = 1;
+constexpr std::size_t SHM_RING_DATA_OFFSET = 4096; /**< Records start one page into the segment */
+
+/**
+ * @brief Header at the start of the shared segment
+ */
+struct ShmRingHeader {
+    uint64_t magic; /**< SHM_RING_MAGIC */
+    uint32_t version; /**< SHM_RING_VERSION */
+    uint32_t reserved; /**< Zero */
+    uint64_t capacity; /**< Size of the record area, a power of two */
+    alignas(64) std::atomic<uint64_t> claimed; /**< Position up to which the writer may be writing */
+    alignas(64) std::atomic<uint64_t> committed; /**< Position up to which records are complete */
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "ring positions must be lock-free to be shared");
+static_assert(sizeof(ShmRingHeader) <= SHM_RING_DATA_OFFSET, "ring header must fit in the first page");
+
+/**
+ * @brief Header of one record; topic and payload bytes follow
+ */
+struct ShmRecordHeader {
+    uint32_t length; /**< Total record length including this header, 8-byte aligned */
+    uint16_t type; /**< SHM_RECORD_PADDING or SHM_RECORD_MESSAGE */
+    uint16_t topicLength; /**< Length of the topic that follows */
+    uint32_t payloadLength; /**< Length of the payload that follows the topic */
+    uint32_t binary; /**< 1 if the payload uses the binary protocol, 0 for JSON text */
+    uint64_t sequence; /**< Message sequence number, contiguous from 1 */
+};
+
+constexpr uint16_t SHM_RECORD_PADDING = 0; /**< Fills the end of the ring before a wrap */
+constexpr uint16_t SHM_RECORD_MESSAGE = 1; /**< Carries a message */
+
+/**
+ * @brief Creates a ring and publishes messages into it
+ *
+ * Only one thread may publish at a time.
+ */
+class ShmRingWriter {
+public:
+    /**
+     * @brief Exception class for shared memory errors
+     */
+    class Exception : public std::runtime_error {
+    public:
+        explicit Exception(const std::string& message) : std::runtime_error(message) {}
+    };
+
+    /**
+     * @brief Create (or replace) the named ring
+     *
+     * @param name Ring name; consumers attach with the same name
+     * @param capacity Size of the record area, rounded up to a power of two
+     */
+    ShmRingWriter(const std::string& name, std::size_t capacity);
+
+    /**
+     * @brief Unmap and remove the ring
+     */
+    ~ShmRingWriter();
+
+    ShmRingWriter(const ShmRingWriter&) = delete;
+    ShmRingWriter& operator=(const ShmRingWriter&) = delete;
+
+    /**
+     * @brief Publish a message
+     *
+     * @param topic The topic, e.g. "orderbook.BTC-PERPETUAL"
+     * @param payload The message
+     * @param binary True if the payload uses the binary protocol
+     * @return false if the message is larger than a quarter of the ring
+     */
+    bool publish(std::string_view topic, std::string_view payload, bool binary);
+
+    /**
+     * @brief Get the number of messages published
+     */
+    uint64_t published() const { return sequence; }
+
+private:
+    std::string shmName; /**< Name passed to shm_open */
+    ShmRingHeader* header = nullptr; /**< Mapped segment header */
+    char* data = nullptr; /**< Start of the record area */
+    std::size_t mappedSize = 0; /**< Size of the mapping */
+    uint64_t position = 0; /**< Writer position (mirrors header->committed) */
+    uint64_t sequence = 0; /**< Sequence of the last published message */
+};
+
+/**
+ * @brief A message copied out of the ring
+ */
+struct ShmMessage {
+    uint64_t sequence = 0; /**< Message sequence number */
+    bool binary = false; /**< True if the payload uses the binary protocol */
+    std::string topic; /**< Topic (capacity reused between reads) */
+    std::string payload; /**< Payload (capacity reused between reads) */
+};
+
+/**
+ * @brief Attaches to a ring by name and reads it without system calls
+ */
+class ShmRingReader {
+public:
+    /**
+     * @brief Exception class for shared memory errors
+     */
+    class Exception : public std::runtime_error {
+    public:
+        explicit Exception(const std::string& message) : std::runtime_error(message) {}
+    };
+
+    /**
+     * @brief Result of a poll
+     */
+    enum class Status {
+        EMPTY, /**< No new message */
+        MESSAGE, /**< A message was copied out */
+        OVERRUN /**< The writer lapped this reader; it now reads from the newest data */
+    };
+
+    /**
+     * @brief Attach to a ring, starting at its newest data
+     *
+     * @param name Ring name used by the writer
+     */
+    explicit ShmRingReader(const std::string& name);
+
+    /**
+     * @brief Unmap the ring
+     */
+    ~ShmRingReader();
+
+    ShmRingReader(const ShmRingReader&) = delete;
+    ShmRingReader& operator=(const ShmRingReader&) = delete;
+
+    /**
+     * @brief Read the next message if there is one
+     *
+     * @param message Receives the message when MESSAGE is returned
+     * @return Status EMPTY, MESSAGE or OVERRUN
+     */
+    Status poll(ShmMessage& message);
+
+    /**
+     * @brief Get the number of messages lost to overruns so far
+     */
+    uint64_t lost() const { return lostMessages; }
+
+private:
+    /**
+     * @brief Skip to the newest data after an overrun
+     */
+    void resync();
+
+    const ShmRingHeader* header = nullptr; /**< Mapped segment header */
+    const char* data = nullptr; /**< Start of the record area */
+    std::size_t mappedSize = 0; /**< Size of the mapping */
+    uint64_t capacity = 0; /**< Size of the record area */
+    uint64_t position = 0; /**< Reader position */
+    uint64_t nextSequence = 0; /**< Expected sequence of the next message (0 if unknown) */
+    uint64_t lostMessages = 0; /**< Messages skipped because of overruns */
+};
+
+#endif // SHM_RING_H
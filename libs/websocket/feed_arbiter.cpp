@@ -0,0 +1,88 @@
+#include "feed_arbiter.h"
+#include <algorithm>
+#include <charconv>
+#include <functional>
+
+namespace {
+    const std::string_view CHANNEL_FIELD = "\"channel\":\"";
+    const std::string_view SNAPSHOT_FIELD = "\"type\":\"snapshot\"";
+
+    // In order of preference; "change_id" is quoted so that "prev_change_id" does not match
+    const std::string_view SEQUENCE_FIELDS[] = {"\"change_id\":", "\"trade_seq\":", "\"timestamp\":"};
+    const std::string_view TRADE_SEQ_FIELD = SEQUENCE_FIELDS[1];
+}
+
+FeedArbiter::FeedArbiter(std::size_t feeds)
+    : feedStats(feeds) {
+}
+
+bool FeedArbiter::parseKey(const std::string& message, Key& key) {
+    std::string_view text(message);
+
+    std::size_t start = text.find(CHANNEL_FIELD);
+    if (start == std::string_view::npos) {
+        return false;
+    }
+    start += CHANNEL_FIELD.size();
+    std::size_t end = text.find('"', start);
+    if (end == std::string_view::npos) {
+        return false;
+    }
+    key.channel = text.substr(start, end - start);
+
+    for (std::string_view field : SEQUENCE_FIELDS) {
+        std::size_t pos = text.find(field);
+        if (pos == std::string_view::npos) {
+            continue;
+        }
+        const char* first = text.data() + pos + field.size();
+        auto result = std::from_chars(first, text.data() + text.size(), key.sequence);
+        if (result.ec != std::errc()) {
+            return false;
+        }
+        key.firstSequence = key.sequence;
+
+        // A batch of trades spans every trade_seq it holds
+        if (field == TRADE_SEQ_FIELD) {
+            while ((pos = text.find(field, pos + field.size())) != std::string_view::npos) {
+                uint64_t sequence = 0;
+                first = text.data() + pos + field.size();
+                if (std::from_chars(first, text.data() + text.size(), sequence).ec != std::errc()) {
+                    return false;
+                }
+                key.sequence = std::max(key.sequence, sequence);
+                key.firstSequence = std::min(key.firstSequence, sequence);
+            }
+        }
+        key.snapshot = text.find(SNAPSHOT_FIELD) != std::string_view::npos;
+        return true;
+    }
+    return false;
+}
+
+bool FeedArbiter::accept(std::size_t feed, const Key& key, Clock::time_point arrival, uint64_t& forwarded) {
+    ChannelState& state = channels[std::hash<std::string_view>()(key.channel)];
+    FeedStats& stats = feedStats[feed];
+    forwarded = state.last;
+
+    if (key.sequence > state.last || (key.snapshot && key.sequence == state.last)) {
+        state.last = key.sequence;
+        state.recent[state.next] = {key.sequence, arrival};
+        state.next = (state.next + 1) % RECENT;
+        ++stats.wins;
+        return true;
+    }
+
+    ++stats.duplicates;
+    for (const Arrival& first : state.recent) {
+        if (first.sequence == key.sequence) {
+            auto lag = std::chrono::duration_cast<std::chrono::microseconds>(arrival - first.time).count();
+            uint64_t lagUs = lag > 0 ? static_cast<uint64_t>(lag) : 0;
+            ++stats.lagSamples;
+            stats.lagTotalUs += lagUs;
+            stats.lagMaxUs = std::max(stats.lagMaxUs, lagUs);
+            break;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,118 @@
+#ifndef FEED_ARBITER_H
+#define FEED_ARBITER_H
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief Picks the first copy of each update from redundant Deribit connections
+ *
+ * Every connection is subscribed to the same channels, so each notification
+ * arrives once per connection. Updates are keyed by channel and by a per
+ * channel sequence: change_id for books, trade_seq for trades and timestamp
+ * otherwise. The first copy with a sequence above the last one forwarded
+ * wins; later copies are duplicates. The key is found by scanning the raw
+ * message, so a duplicate is discarded without being parsed.
+ *
+ * Connections may batch the same trades differently, so a trades message
+ * is keyed by the range of trade_seq it holds: it wins if any of its
+ * trades is new, and the caller forwards only the trades above the
+ * sequence accept() reports as already forwarded.
+ *
+ * Not thread safe: callers serialize accept() with handling the winners, so
+ * that updates are also handled in sequence order.
+ */
+class FeedArbiter {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    /**
+     * @brief Arbitration results of one connection
+     */
+    struct FeedStats {
+        uint64_t wins = 0; /**< Updates this connection delivered first */
+        uint64_t duplicates = 0; /**< Updates another connection had already delivered */
+        uint64_t lagSamples = 0; /**< Duplicates whose first arrival was still known */
+        uint64_t lagTotalUs = 0; /**< Sum of the delays behind the first copy, in microseconds */
+        uint64_t lagMaxUs = 0; /**< Largest delay behind the first copy, in microseconds */
+    };
+
+    /**
+     * @brief Arbitration key of an update
+     */
+    struct Key {
+        std::string_view channel; /**< Subscription channel, pointing into the message */
+        uint64_t sequence = 0; /**< Position of the update within the channel; the highest trade_seq for trades */
+        uint64_t firstSequence = 0; /**< Lowest sequence the message holds; equal to sequence except for trades */
+        bool snapshot = false; /**< True for a book snapshot */
+    };
+
+    /**
+     * @brief Construct an arbiter for a number of connections
+     *
+     * @param feeds The number of connections
+     */
+    explicit FeedArbiter(std::size_t feeds);
+
+    /**
+     * @brief Find the arbitration key of a raw notification
+     *
+     * @param message The raw message
+     * @param key Receives the key
+     * @return true if the message is a subscription notification with a sequence
+     */
+    static bool parseKey(const std::string& message, Key& key);
+
+    /**
+     * @brief Decide whether an update is the first copy
+     *
+     * A snapshot is also accepted at the last forwarded sequence: it carries
+     * the same state, and is how a resubscribed connection resyncs a book.
+     *
+     * @param feed The connection it arrived on
+     * @param key The update's key
+     * @param arrival When it was read from the connection
+     * @param forwarded Receives the highest sequence forwarded before this update;
+     *                  trades at or below it were already forwarded
+     * @return true to forward the update, false for a duplicate or an older update
+     */
+    bool accept(std::size_t feed, const Key& key, Clock::time_point arrival, uint64_t& forwarded);
+
+    /**
+     * @brief Get the results of one connection
+     *
+     * @param feed The connection
+     * @return FeedStats The results so far
+     */
+    const FeedStats& stats(std::size_t feed) const { return feedStats[feed]; }
+
+private:
+    static constexpr std::size_t RECENT = 16; /**< First arrivals remembered per channel for lag measurement */
+
+    /**
+     * @brief First arrival of one update
+     */
+    struct Arrival {
+        uint64_t sequence = 0; /**< Sequence of the update */
+        Clock::time_point time; /**< When its first copy arrived */
+    };
+
+    /**
+     * @brief Arbitration state of one channel
+     */
+    struct ChannelState {
+        uint64_t last = 0; /**< Highest sequence forwarded */
+        std::array<Arrival, RECENT> recent{}; /**< Ring of the latest first arrivals */
+        std::size_t next = 0; /**< Next slot of recent to overwrite */
+    };
+
+    std::unordered_map<std::size_t, ChannelState> channels; /**< State by hash of the channel name */
+    std::vector<FeedStats> feedStats; /**< Results by connection */
+};
+
+#endif // FEED_ARBITER_H
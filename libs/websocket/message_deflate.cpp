@@ -0,0 +1,62 @@
+#include "message_deflate.h"
+#include "env_handler.h"
+#include <algorithm>
+
+namespace {
+    int intSetting(const std::string& name, int fallback, int low, int high) {
+        std::string value = EnvHandler::getEnvVariable(name);
+        if (value.empty()) return fallback;
+        try {
+            return std::clamp(std::stoi(value), low, high);
+        } catch (const std::exception&) {
+            return fallback;
+        }
+    }
+}
+
+CompressionConfig CompressionConfig::fromEnvironment() {
+    CompressionConfig config;
+
+    std::string mode = EnvHandler::getEnvVariable("WS_COMPRESSION");
+    if (mode == "off") {
+        config.mode = Mode::OFF;
+    } else if (mode == "shared") {
+        config.mode = Mode::SHARED;
+    }
+
+    config.level = intSetting("WS_COMPRESSION_LEVEL", config.level, 0, 9);
+    config.memLevel = intSetting("WS_COMPRESSION_MEM_LEVEL", config.memLevel, 1, 9);
+    config.windowBits = intSetting("WS_COMPRESSION_WINDOW_BITS", config.windowBits, 9, 15);
+    config.noContextTakeover = EnvHandler::getEnvVariable("WS_COMPRESSION_NO_CONTEXT_TAKEOVER") == "true";
+    config.threshold = static_cast<std::size_t>(
+        intSetting("WS_COMPRESSION_THRESHOLD", static_cast<int>(config.threshold), 0, 1 << 30));
+    return config;
+}
+
+MessageDeflate::MessageDeflate(const CompressionConfig& config) {
+    // Negative window bits select a raw stream without zlib header or checksum
+    if (deflateInit2(&stream, config.level, Z_DEFLATED, -config.windowBits,
+                     config.memLevel, Z_DEFAULT_STRATEGY) != Z_OK) {
+        throw Exception("Failed to initialize message compressor");
+    }
+}
+
+MessageDeflate::~MessageDeflate() {
+    deflateEnd(&stream);
+}
+
+void MessageDeflate::compress(const std::string& message, std::string& out) {
+    std::lock_guard<std::mutex> lock(streamMutex);
+    deflateReset(&stream);
+
+    out.resize(deflateBound(&stream, message.size()));
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(message.data()));
+    stream.avail_in = static_cast<uInt>(message.size());
+    stream.next_out = reinterpret_cast<Bytef*>(&out[0]);
+    stream.avail_out = static_cast<uInt>(out.size());
+
+    if (deflate(&stream, Z_FINISH) != Z_STREAM_END) {
+        throw Exception("Failed to compress message");
+    }
+    out.resize(out.size() - stream.avail_out);
+}
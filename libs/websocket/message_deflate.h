@@ -0,0 +1,88 @@
+#ifndef MESSAGE_DEFLATE_H
+#define MESSAGE_DEFLATE_H
+
+#include <mutex>
+#include <string>
+#include <stdexcept>
+#include <zlib.h>
+
+/**
+ * @brief Compression settings of the local WebSocket server
+ *
+ * PERMESSAGE negotiates permessage-deflate with each client, so every
+ * session compresses every message with its own zlib state. SHARED leaves
+ * permessage-deflate off and lets the broadcaster compress each update once
+ * for all sessions that opted in (see MessageDeflate).
+ */
+struct CompressionConfig {
+    /**
+     * @brief How outgoing messages are compressed
+     */
+    enum class Mode {
+        OFF, /**< No compression */
+        PERMESSAGE, /**< Negotiated permessage-deflate, one zlib state per session */
+        SHARED /**< Compressed once per broadcast and shared across sessions */
+    };
+
+    Mode mode = Mode::PERMESSAGE; /**< Compression mode */
+    int level = 8; /**< zlib compression level */
+    int memLevel = 4; /**< zlib memory level (deflate state size) */
+    int windowBits = 15; /**< Server window bits (9-15) */
+    bool noContextTakeover = false; /**< Reset the server compressor after each message (PERMESSAGE) */
+    std::size_t threshold = 256; /**< Smaller messages are sent uncompressed (SHARED) */
+
+    /**
+     * @brief Read the configuration from WS_COMPRESSION* environment variables
+     *
+     * @return CompressionConfig The configuration, defaults for unset variables
+     */
+    static CompressionConfig fromEnvironment();
+};
+
+/**
+ * @brief Compresses whole messages with a reusable raw deflate stream
+ *
+ * Each message is compressed independently (no context takeover) into a
+ * complete raw deflate stream (RFC 1951), so one compressed buffer can be sent
+ * to any number of sessions and each can be inflated on its own. Safe to call
+ * from several threads.
+ */
+class MessageDeflate {
+public:
+    /**
+     * @brief Exception class for compressor errors
+     */
+    class Exception : public std::runtime_error {
+    public:
+        explicit Exception(const std::string& message) : std::runtime_error(message) {}
+    };
+
+    /**
+     * @brief Construct a new MessageDeflate object
+     *
+     * @param config Level, window bits and memory level to use
+     */
+    explicit MessageDeflate(const CompressionConfig& config);
+
+    /**
+     * @brief Destroy the MessageDeflate object
+     */
+    ~MessageDeflate();
+
+    MessageDeflate(const MessageDeflate&) = delete;
+    MessageDeflate& operator=(const MessageDeflate&) = delete;
+
+    /**
+     * @brief Compress a message
+     *
+     * @param message The message
+     * @param out Receives the raw deflate stream (its capacity is reused)
+     */
+    void compress(const std::string& message, std::string& out);
+
+private:
+    z_stream stream{}; /**< Deflate state, reset before each message */
+    std::mutex streamMutex; /**< Mutex for synchronizing access to the stream */
+};
+
+#endif // MESSAGE_DEFLATE_H
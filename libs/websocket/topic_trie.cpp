@@ -0,0 +1,90 @@
+#include "topic_trie.h"
+#include <algorithm>
+
+namespace {
+    const std::string WILDCARD = "*";
+
+    std::vector<std::string> splitSegments(const std::string& name) {
+        std::vector<std::string> segments;
+        std::size_t start = 0;
+        for (;;) {
+            std::size_t end = name.find('-', start);
+            segments.push_back(name.substr(start, end == std::string::npos ? std::string::npos : end - start));
+            if (end == std::string::npos) {
+                return segments;
+            }
+            start = end + 1;
+        }
+    }
+}
+
+bool TopicTrie::isPattern(const std::string& symbol) {
+    auto segments = splitSegments(symbol);
+    return std::find(segments.begin(), segments.end(), WILDCARD) != segments.end();
+}
+
+bool TopicTrie::matches(const std::string& pattern, const std::string& name) {
+    TopicTrie trie;
+    trie.insert(pattern, 0);
+    std::vector<uint64_t> ids;
+    trie.match(name, ids);
+    return !ids.empty();
+}
+
+void TopicTrie::insert(const std::string& pattern, uint64_t id) {
+    Node* node = &root;
+    for (const auto& segment : splitSegments(pattern)) {
+        std::unique_ptr<Node>& next = segment == WILDCARD ? node->wildcard : node->children[segment];
+        if (!next) {
+            next = std::make_unique<Node>();
+        }
+        node = next.get();
+    }
+    node->ids.push_back(id);
+}
+
+void TopicTrie::erase(const std::string& pattern, uint64_t id) {
+    // Empty nodes are left in place; patterns come from a small, slowly changing set
+    Node* node = &root;
+    for (const auto& segment : splitSegments(pattern)) {
+        if (segment == WILDCARD) {
+            node = node->wildcard.get();
+        } else {
+            auto it = node->children.find(segment);
+            node = it == node->children.end() ? nullptr : it->second.get();
+        }
+        if (!node) {
+            return;
+        }
+    }
+    node->ids.erase(std::remove(node->ids.begin(), node->ids.end(), id), node->ids.end());
+}
+
+void TopicTrie::match(const std::string& name, std::vector<uint64_t>& ids) const {
+    ids.clear();
+    match(root, splitSegments(name), 0, ids);
+
+    // A pattern with several wildcards can match the same name in more than one way
+    std::sort(ids.begin(), ids.end());
+    ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+}
+
+void TopicTrie::match(const Node& node, const std::vector<std::string>& segments, std::size_t index,
+                      std::vector<uint64_t>& ids) {
+    if (index == segments.size()) {
+        ids.insert(ids.end(), node.ids.begin(), node.ids.end());
+        return;
+    }
+
+    auto it = node.children.find(segments[index]);
+    if (it != node.children.end()) {
+        match(*it->second, segments, index + 1, ids);
+    }
+
+    // "*" consumes one or more segments
+    if (node.wildcard) {
+        for (std::size_t end = index + 1; end <= segments.size(); ++end) {
+            match(*node.wildcard, segments, end, ids);
+        }
+    }
+}
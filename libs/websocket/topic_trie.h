@@ -0,0 +1,87 @@
+#ifndef TOPIC_TRIE_H
+#define TOPIC_TRIE_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief Matches instrument names against exact names and wildcard patterns
+ *
+ * Names and patterns are split into '-' separated segments
+ * (BTC-27DEC24-50000-C). A segment that is exactly "*" matches one or more
+ * whole segments, so "BTC-*-C" matches every BTC call and "*-PERPETUAL"
+ * every perpetual; any other segment matches literally. Patterns are
+ * compiled into a trie once, so matching a name costs one walk of the trie
+ * rather than one comparison per pattern.
+ */
+class TopicTrie {
+public:
+    /**
+     * @brief Check whether a subscription symbol is a pattern
+     *
+     * @param symbol The symbol
+     * @return true if any segment is "*"
+     */
+    static bool isPattern(const std::string& symbol);
+
+    /**
+     * @brief Check a single name against a single pattern
+     *
+     * @param pattern The pattern (or exact name)
+     * @param name The instrument name
+     * @return true if the pattern matches the name
+     */
+    static bool matches(const std::string& pattern, const std::string& name);
+
+    /**
+     * @brief Add an entry under a pattern
+     *
+     * @param pattern The pattern (or exact name)
+     * @param id The entry id
+     */
+    void insert(const std::string& pattern, uint64_t id);
+
+    /**
+     * @brief Remove an entry added with insert
+     *
+     * @param pattern The pattern it was added under
+     * @param id The entry id
+     */
+    void erase(const std::string& pattern, uint64_t id);
+
+    /**
+     * @brief Collect the entries whose pattern matches a name
+     *
+     * @param name The instrument name
+     * @param ids Receives the ids, sorted and without duplicates
+     */
+    void match(const std::string& name, std::vector<uint64_t>& ids) const;
+
+private:
+    /**
+     * @brief One segment position of the compiled patterns
+     */
+    struct Node {
+        std::unordered_map<std::string, std::unique_ptr<Node>> children; /**< Literal segments */
+        std::unique_ptr<Node> wildcard; /**< The "*" segment */
+        std::vector<uint64_t> ids; /**< Entries whose pattern ends here */
+    };
+
+    /**
+     * @brief Walk the trie from a node for the segments from index on
+     *
+     * @param node The node reached so far
+     * @param segments The name's segments
+     * @param index The first segment not yet consumed
+     * @param ids Receives the ids of the patterns ending on the last segment
+     */
+    static void match(const Node& node, const std::vector<std::string>& segments, std::size_t index,
+                      std::vector<uint64_t>& ids);
+
+    Node root; /**< Root of the trie */
+};
+
+#endif // TOPIC_TRIE_H
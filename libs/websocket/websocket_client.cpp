@@ -25,10 +25,22 @@ WebSocketClient::~WebSocketClient() {
     }
 }
 
-void WebSocketClient::connect(const std::string& host, const std::string& port, const std::string& path) {
+bool WebSocketClient::connect(const std::string& host, const std::string& port, const std::string& path) {
+    // The read loop of a dropped connection has already returned or is about to
+    if (ioThread && ioThread->joinable()) {
+        ioThread->join();
+    }
+    ioThread.reset();
+    shouldStop = false;
+
     try {
+        std::lock_guard<std::mutex> lock(writeMutex);
+
         // Create new WebSocket stream
-        ws = std::make_unique<websocket::stream<ssl::stream<asio::ip::tcp::socket>>>(ioContext, sslContext);
+        {
+            std::lock_guard<std::mutex> streamLock(streamMutex);
+            ws = std::make_unique<websocket::stream<ssl::stream<asio::ip::tcp::socket>>>(ioContext, sslContext);
+        }
 
         // Look up the domain name
         auto const results = resolver.resolve(host, port);
@@ -57,19 +69,23 @@ void WebSocketClient::connect(const std::string& host, const std::string& port,
         ws->handshake(host + ":" + std::to_string(ep.port()), path);
         
         isConnected = true;
+        lastReceive = std::chrono::steady_clock::now().time_since_epoch().count();
         // std::cout << "Connected to: " << host << std::endl;
-
-        // Start the read loop in a separate thread
-        ioThread = std::make_unique<std::thread>(&WebSocketClient::readLoop, this);
-
-        // Call the onOpen callback if set
-        if (openHandler) {
-            openHandler();
-        }
     }
     catch (const std::exception& e) {
+        isConnected = false;
         handleError(std::string("Connection error: ") + e.what());
+        return false;
+    }
+
+    // Call the onOpen callback if set; before reading starts, so it always precedes onClose
+    if (openHandler) {
+        openHandler();
     }
+
+    // Start the read loop in a separate thread
+    ioThread = std::make_unique<std::thread>(&WebSocketClient::readLoop, this);
+    return true;
 }
 
 void WebSocketClient::sendMessage(const std::string& message) {
@@ -79,6 +95,7 @@ void WebSocketClient::sendMessage(const std::string& message) {
     }
 
     try {
+        std::lock_guard<std::mutex> lock(writeMutex);
         ws->write(asio::buffer(message));
     }
     catch (const std::exception& e) {
@@ -122,6 +139,16 @@ void WebSocketClient::close() {
     }
 }
 
+void WebSocketClient::abort() {
+    // Not writeMutex: a write blocked on a half-open connection holds it until this shutdown fails it
+    std::lock_guard<std::mutex> lock(streamMutex);
+    if (!ws) return;
+
+    // A shutdown on the native handle is safe alongside a blocked read or write on another thread
+    beast::error_code ec;
+    beast::get_lowest_layer(*ws).shutdown(asio::ip::tcp::socket::shutdown_both, ec);
+}
+
 void WebSocketClient::onOpen(std::function<void()> callback) {
     openHandler = std::move(callback);
 }
@@ -143,9 +170,14 @@ void WebSocketClient::readLoop() {
         try {
             beast::flat_buffer buffer;
             ws->read(buffer);
-            
+            lastReceive = std::chrono::steady_clock::now().time_since_epoch().count();
+
+            std::string message = beast::buffers_to_string(buffer.data());
+            if (handleHeartbeat(message)) {
+                continue;
+            }
             if (messageHandler) {
-                messageHandler(beast::buffers_to_string(buffer.data()));
+                messageHandler(message);
             }
         }
         catch (const boost::system::system_error& e) {
@@ -165,6 +197,24 @@ void WebSocketClient::readLoop() {
             break;
         }
     }
+
+    isConnected = false;
+    if (!shouldStop && closeHandler) {
+        closeHandler();
+    }
+}
+
+bool WebSocketClient::handleHeartbeat(const std::string& message) {
+    // Checked before any parsing: {"jsonrpc":"2.0","method":"heartbeat","params":{"type":"test_request"}}
+    if (message.size() > 160 || message.find("\"heartbeat\"") == std::string::npos) {
+        return false;
+    }
+
+    if (message.find("\"test_request\"") != std::string::npos) {
+        // Deribit closes the connection if a test request goes unanswered
+        sendMessage(R"({"jsonrpc":"2.0","id":135,"method":"public/test","params":{}})");
+    }
+    return true;
 }
 
 void WebSocketClient::handleError(const std::string& error) {
@@ -6,7 +6,10 @@
 #include <boost/beast/websocket.hpp>
 #include <boost/beast/websocket/ssl.hpp>
 #include <boost/asio/ssl.hpp>
+#include <atomic>
+#include <chrono>
 #include <functional>
+#include <mutex>
 #include <string>
 #include <thread>
 #include <memory>
@@ -33,11 +36,14 @@ public:
     /**
      * @brief Connect to the WebSocket server
      * 
+     * May be called again after the connection has dropped to reconnect.
+     * 
      * @param host The host address of the WebSocket server
      * @param port The port number of the WebSocket server
      * @param path The path for the WebSocket connection
+     * @return true if connected, false if the attempt failed
      */
-    void connect(const std::string& host, const std::string& port = "443", const std::string& path = "/");
+    bool connect(const std::string& host, const std::string& port = "443", const std::string& path = "/");
 
     /**
      * @brief Send a message to the WebSocket server
@@ -52,6 +58,34 @@ public:
      */
     void close();
 
+    /**
+     * @brief Drop a connection that has stopped delivering data
+     * 
+     * Shuts the socket down without a close handshake, so the blocked read
+     * fails and onClose is called as for any other drop. It does not wait for
+     * writeMutex: a write blocked on the dead connection fails with it.
+     */
+    void abort();
+
+    /**
+     * @brief Check if the connection is open
+     * 
+     * @return true between a successful connect and the connection dropping or closing
+     */
+    bool isOpen() const { return isConnected; }
+
+    /**
+     * @brief Get the time the last message was received
+     * 
+     * Heartbeats count, so with public/set_heartbeat enabled a healthy
+     * connection never goes quiet for longer than the heartbeat interval.
+     * 
+     * @return std::chrono::steady_clock::time_point The receive time, or the connect time before any message
+     */
+    std::chrono::steady_clock::time_point lastReceived() const {
+        return std::chrono::steady_clock::time_point(std::chrono::steady_clock::duration(lastReceive.load()));
+    }
+
     /**
      * @brief Set the callback function to be called when the connection is opened
      * 
@@ -67,7 +101,9 @@ public:
     void onMessage(std::function<void(const std::string&)> callback);
 
     /**
-     * @brief Set the callback function to be called when the connection is closed
+     * @brief Set the callback function to be called when the connection drops
+     * 
+     * Called on the read thread when a read fails, but not after close().
      * 
      * @param callback The callback function
      */
@@ -96,9 +132,20 @@ private:
     std::function<void()> closeHandler;
     std::function<void(const std::string&)> errorHandler;
     std::atomic<bool> shouldStop{false};
+    std::mutex writeMutex; /**< Serializes writes and replacing the stream on reconnect */
+    std::mutex streamMutex; /**< Held while replacing the stream, so abort() never sees a destroyed one */
+    std::atomic<std::chrono::steady_clock::rep> lastReceive{0}; /**< Steady clock ticks of the last received message */
 
     void readLoop();
-    bool isConnected;
+
+    /**
+     * @brief Answer a Deribit heartbeat
+     * 
+     * @param message The received message
+     * @return true if it was a heartbeat, which is not passed on
+     */
+    bool handleHeartbeat(const std::string& message);
+    std::atomic<bool> isConnected;
     void handleError(const std::string& error);
 };
 
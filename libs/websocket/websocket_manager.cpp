@@ -1,46 +1,330 @@
 #include "websocket_manager.h"
+#include "topic_trie.h"
+#include <algorithm>
+#include <cctype>
 #include <iostream>
+#include <limits>
+#include <random>
+#include <sstream>
 
 // Helper struct for subscription tracking (defined in cpp to keep header clean)
 struct SubscriptionInfo {
-    std::string type;     // "orderbook" or "position"
-    std::string symbol;
+    std::string type;     // "orderbook", "orderbook_delta", "book_analytics", "greeks", "bars_<resolution>", "ticker", "trades" or "position"
+    std::string symbol;   // Instrument name, or a pattern such as BTC-*-C
     std::weak_ptr<WebSocketSession> session;
+    int intervalMs = 0;   // Sampling interval, 0 for every update
 };
 
 namespace {
-    std::vector<SubscriptionInfo> subscriptions;
+    std::unordered_map<uint64_t, SubscriptionInfo> subscriptions; // By subscription id
+    std::unordered_map<std::string, TopicTrie> subscriptionTries;   // Compiled symbols by subscription key
+    uint64_t nextSubscriptionId = 1;
+    // Sessions per "type symbol" topic, rebuilt on first use after any subscription change
+    std::unordered_map<std::string, std::vector<std::weak_ptr<WebSocketSession>>> dispatchLists;
+    std::mutex subscriptionsMutex; // Guards all of the above; taken after WebSocketManager::booksMutex
+
+    // Throttled subscriptions are kept apart from immediate ones, per interval
+    std::string subscriptionKey(const std::string& type, int intervalMs) {
+        return intervalMs > 0 ? type + "@" + std::to_string(intervalMs) : type;
+    }
+
+    void removeSubscriptions(const std::shared_ptr<WebSocketSession>& closing) {
+        for (auto it = subscriptions.begin(); it != subscriptions.end();) {
+            auto session = it->second.session.lock();
+            if (!session || session == closing) {
+                subscriptionTries[subscriptionKey(it->second.type, it->second.intervalMs)].erase(it->second.symbol, it->first);
+                it = subscriptions.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        dispatchLists.clear();
+    }
 
     void cleanupDeadSubscriptions() {
-        subscriptions.erase(
-            std::remove_if(
-                subscriptions.begin(),
-                subscriptions.end(),
-                [](const SubscriptionInfo& sub) { return sub.session.expired(); }
-            ),
-            subscriptions.end()
-        );
-    }
-
-    void broadcastToSubscribers(const json& data, const std::string& type, const std::string& symbol, 
-                              const std::shared_ptr<WebSocketServer>& server) {
-        cleanupDeadSubscriptions();
-        
-        for (const auto& subscription : subscriptions) {
-            if (auto session = subscription.session.lock()) {
-                if (subscription.type == type && subscription.symbol == symbol) {
-                    session->send(data.dump());
-                }
+        removeSubscriptions(nullptr);
+    }
+
+    void addSubscription(const std::string& type, const std::string& symbol,
+                         const std::shared_ptr<WebSocketSession>& session, int intervalMs = 0) {
+        std::lock_guard<std::mutex> lock(subscriptionsMutex);
+        uint64_t id = nextSubscriptionId++;
+        subscriptions.emplace(id, SubscriptionInfo{type, symbol, session, intervalMs});
+        subscriptionTries[subscriptionKey(type, intervalMs)].insert(symbol, id);
+        dispatchLists.clear();
+    }
+
+    const std::vector<std::weak_ptr<WebSocketSession>>& dispatchList(const std::string& type,
+                                                                     const std::string& symbol) {
+        auto inserted = dispatchLists.try_emplace(type + " " + symbol);
+        auto& list = inserted.first->second;
+        if (!inserted.second) {
+            return list;
+        }
+
+        std::vector<uint64_t> ids;
+        subscriptionTries[type].match(symbol, ids);
+        for (uint64_t id : ids) {
+            // A session subscribed by name and by a matching pattern still gets each update once
+            const auto& session = subscriptions.at(id).session;
+            bool listed = std::any_of(list.begin(), list.end(), [&session](const auto& other) {
+                return !other.owner_before(session) && !session.owner_before(other);
+            });
+            if (!listed) {
+                list.push_back(session);
+            }
+        }
+        return list;
+    }
+
+    bool hasSubscribers(const std::string& key, const std::string& symbol) {
+        std::lock_guard<std::mutex> lock(subscriptionsMutex);
+        return !dispatchList(key, symbol).empty();
+    }
+
+    template <typename Visitor>
+    void forEachSubscriber(const std::string& type, const std::string& symbol, Visitor visit) {
+        std::lock_guard<std::mutex> lock(subscriptionsMutex);
+        bool expired = false;
+        for (const auto& weak : dispatchList(type, symbol)) {
+            if (auto session = weak.lock()) {
+                visit(session);
+            } else {
+                expired = true;
+            }
+        }
+        if (expired) {
+            cleanupDeadSubscriptions();
+        }
+    }
+
+    std::vector<SubscriptionInfo> patternSubscriptions() {
+        std::lock_guard<std::mutex> lock(subscriptionsMutex);
+        std::vector<SubscriptionInfo> patterns;
+        for (const auto& entry : subscriptions) {
+            if (TopicTrie::isPattern(entry.second.symbol)) {
+                patterns.push_back(entry.second);
+            }
+        }
+        return patterns;
+    }
+
+    // Representations of one update, each built on first use into a buffer every session's write references
+    struct EncodedUpdate {
+        EncodedUpdate(MessageDeflate* deflater, std::size_t threshold)
+            : deflater(deflater), threshold(threshold) {}
+
+        template <typename MakeText>
+        const SharedBuffer& textBuffer(MakeText makeText) {
+            if (!text) {
+                text = makeSharedBuffer(makeText());
+            }
+            return text;
+        }
+
+        template <typename MakeBinary>
+        const SharedBuffer& binaryBuffer(MakeBinary makeBinary) {
+            if (!binary) {
+                std::string out;
+                makeBinary(out);
+                binary = makeSharedBuffer(std::move(out));
+            }
+            return binary;
+        }
+
+        SharedBuffer text;
+        SharedBuffer binary;
+        SharedBuffer deflated;
+        MessageDeflate* deflater; // Set when the server runs in shared compression mode
+        std::size_t threshold;    // Smaller text is never compressed
+    };
+
+    // Send an update in the session's protocol and compression mode
+    template <typename MakeText, typename MakeBinary>
+    void sendEncoded(const std::shared_ptr<WebSocketSession>& session, EncodedUpdate& update,
+                     MakeText makeText, MakeBinary makeBinary) {
+        if (session->isBinary()) {
+            session->send(update.binaryBuffer(makeBinary), true);
+            return;
+        }
+
+        const SharedBuffer& text = update.textBuffer(makeText);
+        if (update.deflater && session->usesSharedCompression() && text->size() >= update.threshold) {
+            if (!update.deflated) {
+                std::string out;
+                update.deflater->compress(*text, out);
+                update.deflated = makeSharedBuffer(std::move(out));
+            }
+            session->send(update.deflated, true);
+        } else {
+            session->send(text, false);
+        }
+    }
+
+    // Encode channel data in the binary protocol for the given subscription type
+    void encodeBinary(const BinaryEncoder& encoder, const std::string& type, const json& data, std::string& out) {
+        if (type == "orderbook") {
+            encoder.encodeBook(data, out);
+        } else if (type == "ticker") {
+            encoder.encodeTicker(data, out);
+        } else if (type == "trades") {
+            encoder.encodeTrades(data, out);
+        } else if (type == "position") {
+            encoder.encodePosition(data, out);
+        } else if (type == "book_analytics") {
+            encoder.encodeBookAnalytics(data, out);
+        } else if (type == "greeks") {
+            encoder.encodeGreeks(data, out);
+        } else if (type.compare(0, 5, "bars_") == 0) {
+            encoder.encodeBar(data, out);
+        }
+    }
+
+    json levelsToJson(const std::vector<double>& prices, const std::vector<double>& amounts) {
+        json levels = json::array();
+        for (std::size_t i = 0; i < prices.size(); ++i) {
+            levels.push_back({prices[i], amounts[i]});
+        }
+        return levels;
+    }
+
+    BinaryLevelArrays levelArrays(const std::vector<double>& prices, const std::vector<double>& amounts) {
+        return {prices.data(), amounts.data(), prices.size()};
+    }
+
+    // Best price of a book side, 0 while it is empty
+    double bestPrice(const OrderBook::Side& side) {
+        return side.size() > 0 ? side.prices[0] : 0.0;
+    }
+
+    std::string bookSnapshotText(const OrderBook& book, uint64_t sequence) {
+        json snapshot = {
+            {"type", "snapshot"},
+            {"instrument_name", book.instrument()},
+            {"sequence", sequence},
+            {"change_id", book.changeId()},
+            {"timestamp", book.timestamp()},
+            {"bids", levelsToJson(book.bids().prices, book.bids().amounts)},
+            {"asks", levelsToJson(book.asks().prices, book.asks().amounts)}
+        };
+        return snapshot.dump();
+    }
+
+    // A book snapshot in Deribit's own notification format, for full book subscribers
+    std::string deribitSnapshotText(const OrderBook& book) {
+        auto levels = [](const OrderBook::Side& side) {
+            json entries = json::array();
+            for (std::size_t i = 0; i < side.prices.size(); ++i) {
+                entries.push_back({"new", side.prices[i], side.amounts[i]});
+            }
+            return entries;
+        };
+        json snapshot = {
+            {"type", "snapshot"},
+            {"instrument_name", book.instrument()},
+            {"change_id", book.changeId()},
+            {"timestamp", book.timestamp()},
+            {"bids", levels(book.bids())},
+            {"asks", levels(book.asks())}
+        };
+        return snapshot.dump();
+    }
+
+    void encodeBookSnapshot(const BinaryEncoder& encoder, const OrderBook& book, uint64_t sequence, std::string& out) {
+        encoder.encodeBook(book.instrument(), sequence, 0, book.timestamp(), true,
+                           levelArrays(book.bids().prices, book.bids().amounts),
+                           levelArrays(book.asks().prices, book.asks().amounts), out);
+    }
+
+    // Deribit channel carrying a subscription type for one instrument
+    std::string channelFor(const std::string& type, const std::string& instrument) {
+        if (type == "orderbook" || type == "orderbook_delta" || type == "book_analytics" || type == "greeks") {
+            return "book." + instrument + ".100ms";
+        }
+        if (type.compare(0, 5, "bars_") == 0) {
+            return "trades." + instrument + ".100ms";
+        }
+        return type + "." + instrument + ".100ms";
+    }
+
+    // Compare without stopping at the first difference, so the time taken does not reveal the token
+    bool tokensEqual(const std::string& given, const std::string& expected) {
+        unsigned char difference = given.size() != expected.size();
+        for (std::size_t i = 0; i < given.size(); ++i) {
+            difference |= static_cast<unsigned char>(given[i] ^ expected[i % expected.size()]);
+        }
+        return difference == 0;
+    }
+
+    // Client requests as logged, without the order entry token
+    json withoutToken(json request) {
+        if (request.is_object()) {
+            request.erase("token");
+        }
+        return request;
+    }
+
+    std::vector<std::string> splitChannels(const std::string& list) {
+        std::vector<std::string> channels;
+        std::stringstream stream(list);
+        std::string channel;
+        while (std::getline(stream, channel, ',')) {
+            if (!channel.empty()) {
+                channels.push_back(channel);
             }
         }
+        return channels;
     }
 }
 
 WebSocketManager::WebSocketManager(const std::string& server_address, unsigned short server_port) {
+    std::string depth = EnvHandler::getEnvVariable("BOOK_ANALYTICS_DEPTH");
+    if (!depth.empty()) {
+        analyticsDepth = std::max(1, std::stoi(depth));
+    }
     server = std::make_shared<WebSocketServer>(server_address, server_port);
     client = std::make_unique<WebSocketClient>();
+    setupRecorder();
+    setupRing();
+    setupMulticast();
+    if (server->compressionConfig().mode == CompressionConfig::Mode::SHARED) {
+        deflater = std::make_unique<MessageDeflate>(server->compressionConfig());
+    }
+    setupOptionChains();
+    setupBars();
+    // Binary messages count prices in instrument ticks, known from the instrument list
+    if (EnvHandler::getEnvVariable("BINARY_PROTOCOL") == "true" || ringBinary || multicast) {
+        instrumentsRequested = true;
+    }
+    orderEntryToken = EnvHandler::getEnvVariable("ORDER_ENTRY_TOKEN");
     setupLocalServer();
     setupDeribitClient();
+    orderHandler.risk().setFollow([this](const std::string& instrument) {
+        followRisk(instrument);
+    });
+    // Orders that end on the exchange release their reservations
+    if (!EnvHandler::getEnvVariable("DERIBIT_API_KEY").empty()) {
+        subscribePrivateChannel("user.orders.any.any.raw");
+    }
+    orderHandler.setFallback([this](const std::string& method, const json& params,
+                                    std::chrono::steady_clock::time_point deadline, ResponseCallback callback) {
+        return sendRpc(method, params, deadline, std::move(callback));
+    });
+
+    std::string slice = EnvHandler::getEnvVariable("EXECUTION_SLICE_MS");
+    execution = std::make_shared<ExecutionEngine>(orderHandler,
+                                                  std::chrono::milliseconds(slice.empty() ? 1000 : std::stol(slice)));
+    execution->setFollow([this](const std::string& instrument) {
+        handleOrderBookSubscription(instrument);
+        subscribeSymbol("trades", instrument, 126);
+
+        // A book already followed for clients gives the prices before its next update
+        std::lock_guard<std::mutex> lock(booksMutex);
+        auto it = books.find(instrument);
+        if (it != books.end() && !it->second.resync) {
+            execution->onBook(instrument, bestPrice(it->second.book.bids()), bestPrice(it->second.book.asks()));
+        }
+    });
 }
 
 WebSocketManager::~WebSocketManager() {
@@ -48,170 +332,1847 @@ WebSocketManager::~WebSocketManager() {
 }
 
 void WebSocketManager::setupLocalServer() {
+    // Same-host clients can connect over a Unix domain socket instead of loopback TCP
+    std::string localSocket = EnvHandler::getEnvVariable("LOCAL_SOCKET_PATH");
+    if (!localSocket.empty()) {
+        try {
+            server->listenLocal(localSocket);
+            std::cout << "Accepting local clients on " << localSocket << std::endl;
+        } catch (const std::exception& e) {
+            std::cerr << "Failed to listen on " << localSocket << ": " << e.what() << std::endl;
+        }
+    }
+
     server->onMessage([this](std::shared_ptr<WebSocketSession> session, const std::string& message) {
         try {
             json j = json::parse(message);
-            std::cout << "Client request received: " << j.dump(2) << std::endl;
+            if (!j.is_object() || !j.contains("method") || !j["method"].is_string()) {
+                std::cout << "Invalid message from client: " << message << std::endl;
+                return;
+            }
+            if (j["method"] == "kill_switch") {
+                if (authorizeOrderEntry(session, j)) {
+                    handleKillSwitchRequest(session, j); // Ahead of the request log
+                }
+                return;
+            }
+            std::cout << "Client request received: " << withoutToken(j).dump(2) << std::endl;
             
             if (j.contains("method")) {
                 const std::string& method = j["method"];
-                if (j.contains("symbol")) {
+                if (method == "resume_trading") {
+                    if (!authorizeOrderEntry(session, j)) {
+                        return;
+                    }
+                    orderHandler.resume();
+                    std::cout << "Trading resumed" << std::endl;
+                    session->send(json{{"method", method}, {"id", j.value("id", json())}, {"result", "ok"}}.dump(), false);
+                }
+                else if (method == "set_compression") {
+                    // Large text updates then arrive as binary frames holding a raw deflate stream
+                    bool shared = j.value("mode", "") == "shared";
+                    if (shared && !deflater) {
+                        std::cerr << "Shared compression requested but WS_COMPRESSION is not 'shared'" << std::endl;
+                        return;
+                    }
+                    session->setSharedCompression(shared);
+                }
+                else if (method == "place_order" || method == "cancel_order" || method == "edit_order") {
+                    if (authorizeOrderEntry(session, j)) {
+                        handleOrderRequest(session, j);
+                    }
+                }
+                else if (method == "start_algo" || method == "cancel_algo" || method == "get_algos") {
+                    if (authorizeOrderEntry(session, j)) {
+                        handleAlgoRequest(session, j);
+                    }
+                }
+                else if (j.contains("symbol")) {
                     const std::string& symbol = j["symbol"];
+                    int intervalMs = 0;
+                    if (j.contains("interval_ms")) {
+                        if (!j["interval_ms"].is_number_integer()) {
+                            std::cerr << "Subscription interval_ms must be an integer: " << j["interval_ms"].dump() << std::endl;
+                            return;
+                        }
+                        intervalMs = static_cast<int>(std::clamp<int64_t>(j["interval_ms"].get<int64_t>(), 0, std::numeric_limits<int>::max()));
+                    }
+                    if (intervalMs > 0) {
+                        addThrottleInterval(intervalMs);
+                    }
                     
-                    if (method == "subscribe_orderbook") {
+                    if (method == "subscribe_orderbook" && j.value("mode", "") == "delta") {
+                        {
+                            // Registered under booksMutex so no delta can slip between the snapshot and the subscription
+                            std::lock_guard<std::mutex> lock(booksMutex);
+                            addSubscription("orderbook_delta", symbol, session);
+                            for (const auto& entry : books) {
+                                if (!entry.second.resync && TopicTrie::matches(symbol, entry.first)) {
+                                    sendBookSnapshot(session, entry.second);
+                                }
+                            }
+                        }
                         handleOrderBookSubscription(symbol);
-                        // Add to subscriptions
-                        subscriptions.push_back({"orderbook", symbol, session});
                     }
-                    else if (method == "subscribe_position") {
-                        // Handle position subscription
-                        if (!client || !isConnected()) {
-                            std::cerr << "Cannot subscribe - not connected to Deribit" << std::endl;
+                    else if (method == "subscribe_orderbook") {
+                        {
+                            // Add to subscriptions before subscribing, so pattern expansion sees it
+                            std::lock_guard<std::mutex> lock(booksMutex);
+                            addSubscription("orderbook", symbol, session, intervalMs);
+                            sendCachedBooks(session, symbol, intervalMs > 0);
+                        }
+                        handleOrderBookSubscription(symbol);
+                    }
+                    else if (method == "subscribe_book_analytics") {
+                        {
+                            std::lock_guard<std::mutex> lock(booksMutex);
+                            addSubscription("book_analytics", symbol, session, intervalMs);
+                            sendCachedAnalytics(session, symbol);
+                        }
+                        handleOrderBookSubscription(symbol);
+                    }
+                    else if (method == "subscribe_greeks") {
+                        // Greeks cover the options of OPTION_CHAIN_CURRENCIES, whose books the gateway follows itself;
+                        // registered under chainsMutex so no update can slip between the snapshot and the subscription
+                        std::lock_guard<std::mutex> lock(chainsMutex);
+                        addSubscription("greeks", symbol, session, intervalMs);
+                        sendCachedGreeks(session, symbol);
+                    }
+                    else if (method == "get_orderbook_snapshot") {
+                        std::lock_guard<std::mutex> lock(booksMutex);
+                        auto it = books.find(symbol);
+                        if (it != books.end() && !it->second.resync) {
+                            sendBookSnapshot(session, it->second);
+                        }
+                    }
+                    else if (method == "subscribe_ticker") {
+                        {
+                            std::lock_guard<std::mutex> lock(stateMutex);
+                            addSubscription("ticker", symbol, session, intervalMs);
+                            sendCachedState(session, "ticker", symbol);
+                        }
+                        subscribeSymbol("ticker", symbol, 125);
+                    }
+                    else if (method == "subscribe_bars") {
+                        if (j.contains("resolution") && !j["resolution"].is_string()) {
+                            std::cerr << "Bar resolution must be a string such as \"1m\": " << j["resolution"].dump() << std::endl;
                             return;
                         }
-
+                        std::string name = j.value("resolution", "1m");
+                        auto it = barResolutions.end();
                         try {
-                            json subscribeMsg = {
-                                {"method", "private/subscribe"},
-                                {"params", {
-                                    {"channels", {
-                                        "user.position." + symbol
-                                    }}
-                                }},
-                                {"jsonrpc", "2.0"},
-                                {"id", 124}
-                            };
-                            
-                            std::cout << "Subscribing to position updates for " << symbol << std::endl;
-                            if (client) {
-                                client->sendMessage(subscribeMsg.dump());
-                            }
+                            it = std::find(barResolutions.begin(), barResolutions.end(),
+                                           BarAggregator::parseResolution(name));
+                        } catch (const std::invalid_argument&) {
+                        }
+                        if (it == barResolutions.end()) {
+                            std::cerr << "Bars requested at resolution '" << name << "', not in BAR_RESOLUTIONS" << std::endl;
+                            return;
+                        }
+                        std::size_t index = it - barResolutions.begin();
+                        {
+                            std::lock_guard<std::mutex> lock(barsMutex);
+                            addSubscription(barTypes[index], symbol, session, intervalMs);
+                            sendCachedBars(session, symbol, index);
+                        }
+                        subscribeSymbol("trades", symbol, 126);
+                    }
+                    else if (method == "subscribe_trades") {
+                        addSubscription("trades", symbol, session, intervalMs);
+                        subscribeSymbol("trades", symbol, 126);
+                    }
+                    else if (method == "subscribe_position") {
+                        {
                             // Add to subscriptions
-                            subscriptions.push_back({"position", symbol, session});
-                        } catch (const std::exception& e) {
-                            std::cerr << "Error subscribing to position updates: " << e.what() << std::endl;
+                            std::lock_guard<std::mutex> lock(stateMutex);
+                            addSubscription("position", symbol, session, intervalMs);
+                            sendCachedState(session, "position", symbol);
                         }
+                        std::cout << "Subscribing to position updates for " << symbol << std::endl;
+                        subscribePrivateChannel("user.position." + symbol);
                     }
                 }
             }
         } catch (const json::parse_error& e) {
             std::cout << "Invalid message from client: " << message << std::endl;
+        } catch (const std::exception& e) {
+            // Anything escaping here would end the server thread's io_context run, and the process
+            std::cerr << "Failed to handle client message: " << e.what() << std::endl;
         }
     });
 
-    server->onDisconnect([](std::shared_ptr<WebSocketSession> session) {
-        cleanupDeadSubscriptions();
+    server->onDisconnect([this](std::shared_ptr<WebSocketSession> session) {
+        {
+            std::lock_guard<std::mutex> lock(subscriptionsMutex);
+            removeSubscriptions(session);
+        }
+        pruneStaleBooks();
     });
 }
 
-void WebSocketManager::handleOrderBookSubscription(const std::string& symbol) {
-    if (!client || !isConnected()) {
-        std::cerr << "Cannot subscribe - not connected to Deribit" << std::endl;
+void WebSocketManager::setupRecorder() {
+    std::string directory = EnvHandler::getEnvVariable("CAPTURE_DIR");
+    if (directory.empty()) {
         return;
     }
 
+    CaptureConfig config;
+    config.directory = directory;
+    config.dictionaryPath = EnvHandler::getEnvVariable("CAPTURE_DICTIONARY");
+
     try {
-                    json subscribeMsg = {
-            {"method", "public/subscribe"},
+        recorder = std::make_unique<CaptureWriter>(config);
+        std::cout << "Recording Deribit frames to " << directory << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << "Failed to start capture: " << e.what() << std::endl;
+    }
+}
+
+void WebSocketManager::setupRing() {
+    std::string name = EnvHandler::getEnvVariable("SHM_RING_NAME");
+    if (name.empty()) {
+        return;
+    }
+
+    std::size_t sizeMb = 64;
+    std::string size = EnvHandler::getEnvVariable("SHM_RING_SIZE_MB");
+    if (!size.empty()) {
+        sizeMb = std::stoul(size);
+    }
+    ringBinary = EnvHandler::getEnvVariable("SHM_RING_BINARY") == "true";
+
+    // Channels subscribed on connect for ring consumers, which cannot subscribe themselves
+    std::vector<std::string> ringChannels = splitChannels(EnvHandler::getEnvVariable("SHM_RING_CHANNELS"));
+
+    try {
+        ring = std::make_unique<ShmRingWriter>(name, sizeMb * 1024 * 1024);
+        std::cout << "Publishing to shared memory ring " << name << std::endl;
+        subscribeChannels(ringChannels, 128);
+    } catch (const std::exception& e) {
+        std::cerr << "Failed to create shared memory ring: " << e.what() << std::endl;
+    }
+}
+
+void WebSocketManager::setupMulticast() {
+    std::string group = EnvHandler::getEnvVariable("MULTICAST_GROUP");
+    if (group.empty()) {
+        return;
+    }
+
+    MulticastConfig config;
+    config.group = group;
+    config.interfaceAddress = EnvHandler::getEnvVariable("MULTICAST_INTERFACE");
+    std::string value = EnvHandler::getEnvVariable("MULTICAST_PORT");
+    if (!value.empty()) {
+        config.port = static_cast<unsigned short>(std::stoi(value));
+    }
+    value = EnvHandler::getEnvVariable("MULTICAST_RECOVERY_PORT");
+    if (!value.empty()) {
+        config.recoveryPort = static_cast<unsigned short>(std::stoi(value));
+    }
+    value = EnvHandler::getEnvVariable("MULTICAST_TTL");
+    if (!value.empty()) {
+        config.ttl = std::stoi(value);
+    }
+    std::vector<std::string> multicastChannels = splitChannels(EnvHandler::getEnvVariable("MULTICAST_CHANNELS"));
+
+    // Snapshots carry Deribit's change_id as their sequence, so the book changes that follow chain onto them
+    auto snapshotProvider = [this](const std::string& instrument, std::string& out) {
+        std::lock_guard<std::mutex> lock(booksMutex);
+        auto it = books.find(instrument);
+        if (it == books.end() || it->second.resync) {
+            return false;
+        }
+        const OrderBook& book = it->second.book;
+        encoder.encodeBook(instrument, book.changeId(), 0, book.timestamp(), true,
+                           levelArrays(book.bids().prices, book.bids().amounts),
+                           levelArrays(book.asks().prices, book.asks().amounts), out);
+        return true;
+    };
+
+    try {
+        multicast = std::make_unique<MulticastPublisher>(config, snapshotProvider);
+        std::cout << "Publishing market data to multicast group " << group << ":" << config.port
+                  << ", recovery on port " << config.recoveryPort << std::endl;
+        subscribeChannels(multicastChannels, 129);
+    } catch (const std::exception& e) {
+        std::cerr << "Failed to start multicast publisher: " << e.what() << std::endl;
+    }
+}
+
+void WebSocketManager::handleOrderBookSubscription(const std::string& symbol) {
+    subscribeSymbol("orderbook", symbol, 123);
+}
+
+void WebSocketManager::subscribeSymbol(const std::string& type, const std::string& symbol, int id) {
+    if (!TopicTrie::isPattern(symbol)) {
+        subscribeChannel(channelFor(type, symbol), id);
+        return;
+    }
+
+    // Patterns expand to the instruments known so far; later ones arrive through addInstruments
+    std::vector<std::string> channels;
+    {
+        std::lock_guard<std::mutex> lock(instrumentsMutex);
+        for (const auto& instrument : instruments) {
+            if (TopicTrie::matches(symbol, instrument)) {
+                channels.push_back(channelFor(type, instrument));
+            }
+        }
+    }
+    subscribeChannels(channels, 132);
+    if (!instrumentsRequested.exchange(true)) {
+        requestInstruments();
+    }
+}
+
+void WebSocketManager::requestInstruments() {
+    json request = {
+        {"method", "public/get_instruments"},
+        {"params", {
+            {"currency", "any"},
+            {"expired", false}
+        }},
+        {"jsonrpc", "2.0"},
+        {"id", 130}
+    };
+    sendToDeribit(request.dump());
+    subscribeChannel("instrument.state.any.any", 131);
+}
+
+void WebSocketManager::setupOptionChains() {
+    for (const auto& currency : splitChannels(EnvHandler::getEnvVariable("OPTION_CHAIN_CURRENCIES"))) {
+        chainCurrencies.push_back(currency);
+        chains[currency];
+    }
+    std::string interval = EnvHandler::getEnvVariable("OPTION_CHAIN_INTERVAL_MS");
+    if (!interval.empty()) {
+        chainInterval = std::chrono::milliseconds(std::max(1, std::stoi(interval)));
+    }
+}
+
+void WebSocketManager::requestOptionChains() {
+    for (const auto& currency : chainCurrencies) {
+        json request = {
+            {"method", "public/get_instruments"},
             {"params", {
-                {"channels", {"book." + symbol + ".100ms"}}
+                {"currency", currency},
+                {"kind", "option"},
+                {"expired", false}
             }},
             {"jsonrpc", "2.0"},
-            {"id", 123}
+            {"id", 139}
         };
-        
-        std::cout << "Subscribing to orderbook for " << symbol << std::endl;
-        if (client) {
-            client->sendMessage(subscribeMsg.dump());
-        }
-    } catch (const std::exception& e) {
-        std::cerr << "Error subscribing to orderbook: " << e.what() << std::endl;
+        sendToDeribit(request.dump());
+
+        std::string index = currency + "_usd";
+        std::transform(index.begin(), index.end(), index.begin(), ::tolower);
+        subscribeChannel("deribit_price_index." + index, 123);
     }
 }
 
-void WebSocketManager::setupDeribitClient() {
-    client->onOpen([this]() {
-        std::cout << "\nDeribit WebSocket connected!" << std::endl;
-        connected = true;
-    });
-
-    client->onMessage([this](const std::string& message) {
-        try {
-            json j = json::parse(message);
-            // std::cout << "Received from Deribit: " << j.dump(2) << std::endl;
-            
-            // Handle subscription confirmation
-            if (j.contains("id")) {
-                std::cout << "Subscription response: " << j.dump(2) << std::endl;
-                if (j.contains("error")) {
-                    std::cerr << "Subscription error: " << j["error"].dump(2) << std::endl;
-                }
-                return;
+void WebSocketManager::addOptions(const json& options) {
+    std::vector<std::string> channels;
+    {
+        std::lock_guard<std::mutex> lock(chainsMutex);
+        for (const auto& option : options) {
+            encoder.setTickSize(option["instrument_name"], option.value("tick_size", 0.0));
+            auto it = chains.find(option.value("base_currency", ""));
+            if (it == chains.end()) {
+                continue;
             }
-            
-            // Handle orderbook data
-            if (j.contains("params")) {
-                if (j["params"].contains("channel") && j["params"].contains("data")) {
-                    std::string channel = j["params"]["channel"];
-                    
-                    // Parse channel to determine type and symbol
-                    if (channel.substr(0, 5) == "book.") {
-                        size_t pos = channel.find('.');
-                        std::string symbol = channel.substr(pos + 1);
-                        pos = symbol.find('.');
-                        symbol = symbol.substr(0, pos);
-                        
-                        json orderbook = j["params"]["data"];
-                        broadcastToSubscribers(orderbook, "orderbook", symbol, server);
-                    }
-                    else if (channel.substr(0, 13) == "user.position.") {
-                        std::string symbol = channel.substr(13);
-                        json position = j["params"]["data"];
-                        broadcastToSubscribers(position, "position", symbol, server);
-                    }
+            ChainState& state = it->second;
+            std::size_t before = state.chain.size();
+            std::size_t index = state.chain.add(option["instrument_name"], option["strike"],
+                                                option["expiration_timestamp"], option.value("option_type", "") == "call");
+            if (state.chain.size() > before) {
+                channels.push_back(channelFor("orderbook", option["instrument_name"]));
+                if (state.forward > 0) {
+                    state.chain.setForward(index, state.forward);
                 }
             }
-        } catch (const json::parse_error& e) {
-            std::cout << "Raw message from Deribit: " << message << std::endl;
         }
-    });
+    }
 
-    client->onClose([this]() {
-        std::cout << "Deribit connection closed" << std::endl;
-        connected = false;
-        running = false;
-    });
+    if (!channels.empty()) {
+        std::cout << "Option chains: following " << channels.size() << " new option books" << std::endl;
+        subscribeChannels(channels, 132);
+    }
+}
 
-    client->onError([](const std::string& error) {
-        if (error.find("Operation canceled") == std::string::npos &&
-            error.find("stream truncated") == std::string::npos &&
-            error.find("End of file") == std::string::npos) {
-            std::cerr << "Deribit WebSocket error: " << error << std::endl;
+void WebSocketManager::updateOptionPrice(const std::string& symbol, double mid) {
+    if (chainCurrencies.empty() || mid <= 0) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(chainsMutex);
+    auto it = chains.find(symbol.substr(0, symbol.find('-')));
+    std::size_t index;
+    if (it != chains.end() && it->second.chain.find(symbol, index)) {
+        it->second.chain.setPrice(index, mid);
+    }
+}
+
+void WebSocketManager::recomputeOptionChains() {
+    if (chainCurrencies.empty()) {
+        return;
+    }
+    auto now = std::chrono::steady_clock::now();
+    if (now - chainRecomputed < chainInterval) {
+        return;
+    }
+    chainRecomputed = now;
+
+    int64_t nowMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    std::lock_guard<std::mutex> lock(chainsMutex);
+    for (auto& entry : chains) {
+        OptionChain& chain = entry.second.chain;
+        if (chain.pending() == 0) {
+            continue;
         }
-    });
+        for (uint32_t index : chain.recompute(nowMs)) {
+            if (hasConsumers("greeks", chain.name(index))) {
+                json greeks = chain.toJson(index);
+                greeks["timestamp"] = nowMs;
+                broadcastToSubscribers(greeks, "greeks", chain.name(index));
+            }
+        }
+    }
 }
 
-void WebSocketManager::start() {
-    std::cout << "Starting local WebSocket server..." << std::endl;
-    server->run();
+void WebSocketManager::sendCachedGreeks(const std::shared_ptr<WebSocketSession>& session, const std::string& symbol) {
+    for (auto& entry : chains) {
+        const OptionChain& chain = entry.second.chain;
+        for (std::size_t i = 0; i < chain.size(); ++i) {
+            if (!TopicTrie::matches(symbol, chain.name(i))) {
+                continue;
+            }
+            json data = chain.toJson(i);
+            EncodedUpdate update(deflater.get(), server->compressionConfig().threshold);
+            sendEncoded(session, update,
+                        [&data]() { return data.dump(); },
+                        [&](std::string& out) { encoder.encodeGreeks(data, out); });
+        }
+    }
 }
 
-void WebSocketManager::stop() {
-    if (client && connected) {
-        std::cout << "Closing Deribit connection..." << std::endl;
-        client->close();
+void WebSocketManager::setupBars() {
+    for (const auto& name : splitChannels(EnvHandler::getEnvVariable("BAR_RESOLUTIONS"))) {
+        barResolutions.push_back(BarAggregator::parseResolution(name));
+    }
+    std::sort(barResolutions.begin(), barResolutions.end());
+    barResolutions.erase(std::unique(barResolutions.begin(), barResolutions.end()), barResolutions.end());
+    if (barResolutions.size() > BarAggregator::MAX_RESOLUTIONS) {
+        barResolutions.resize(BarAggregator::MAX_RESOLUTIONS);
+    }
+    for (int64_t resolution : barResolutions) {
+        barTypes.push_back("bars_" + BarAggregator::resolutionName(resolution));
     }
 
-    if (server) {
-        std::cout << "Stopping WebSocket server..." << std::endl;
-        server->stop();
+    std::string history = EnvHandler::getEnvVariable("BAR_HISTORY");
+    if (!history.empty()) {
+        barHistory = std::max(1, std::stoi(history));
+    }
+}
+
+void WebSocketManager::updateBars(const std::string& symbol, const json& trades) {
+    if (barResolutions.empty() || trades.empty()) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(barsMutex);
+    BarAggregator& aggregator = bars.try_emplace(symbol, barResolutions, barHistory).first->second;
+    for (const auto& trade : trades) {
+        uint32_t closed = aggregator.add(trade.value("price", 0.0), trade.value("amount", 0.0),
+                                         trade.value("timestamp", int64_t(0)));
+        for (std::size_t i = 0; closed != 0; ++i, closed >>= 1) {
+            const BarSeries& series = aggregator.series(i);
+            if ((closed & 1) && hasConsumers(barTypes[i], symbol)) {
+                const Bar& bar = series.at(series.size() - 2);
+                broadcastToSubscribers(BarAggregator::toJson(symbol, series.resolution(), bar, true), barTypes[i], symbol);
+            }
+        }
     }
 
-    running = false;
+    for (std::size_t i = 0; i < aggregator.size(); ++i) {
+        const BarSeries& series = aggregator.series(i);
+        if (hasConsumers(barTypes[i], symbol)) {
+            broadcastToSubscribers(BarAggregator::toJson(symbol, series.resolution(), series.current(), false),
+                                   barTypes[i], symbol);
+        }
+    }
 }
 
-void WebSocketManager::connectToDeribit(const std::string& host, const std::string& port, const std::string& path) {
-    client->connect(host, port, path);
+void WebSocketManager::sendCachedBars(const std::shared_ptr<WebSocketSession>& session, const std::string& symbol,
+                                      std::size_t resolution) {
+    for (const auto& entry : bars) {
+        if (!TopicTrie::matches(symbol, entry.first)) {
+            continue;
+        }
+
+        const BarSeries& series = entry.second.series(resolution);
+        for (std::size_t i = 0; i < series.size(); ++i) {
+            json data = BarAggregator::toJson(entry.first, series.resolution(), series.at(i), i + 1 < series.size());
+            EncodedUpdate update(deflater.get(), server->compressionConfig().threshold);
+            sendEncoded(session, update,
+                        [&data]() { return data.dump(); },
+                        [&](std::string& out) { encoder.encodeBar(data, out); });
+        }
+    }
+}
+
+void WebSocketManager::addInstruments(const std::vector<std::string>& names) {
+    std::vector<std::string> added;
+    {
+        std::lock_guard<std::mutex> lock(instrumentsMutex);
+        for (const auto& name : names) {
+            if (instruments.insert(name).second) {
+                added.push_back(name);
+            }
+        }
+    }
+    if (added.empty()) {
+        return;
+    }
+
+    std::vector<std::string> channels;
+    for (const auto& subscription : patternSubscriptions()) {
+        for (const auto& name : added) {
+            if (TopicTrie::matches(subscription.symbol, name)) {
+                channels.push_back(channelFor(subscription.type, name));
+            }
+        }
+    }
+    std::sort(channels.begin(), channels.end());
+    channels.erase(std::unique(channels.begin(), channels.end()), channels.end());
+    subscribeChannels(channels, 132);
+}
+
+void WebSocketManager::subscribeChannel(const std::string& channel, int id) {
+    subscribeChannels({channel}, id);
+}
+
+void WebSocketManager::subscribeChannels(const std::vector<std::string>& channels, int id) {
+    if (channels.empty()) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(channelsMutex);
+        publicChannels.insert(channels.begin(), channels.end());
+    }
+    // Connections that are down get it with every other channel once they reconnect
+    try {
+        json subscribeMsg = {
+            {"method", "public/subscribe"},
+            {"params", {
+                {"channels", channels}
+            }},
+            {"jsonrpc", "2.0"},
+            {"id", id}
+        };
+        
+        if (channels.size() == 1) {
+            std::cout << "Subscribing to " << channels.front() << std::endl;
+        } else {
+            std::cout << "Subscribing to " << channels.size() << " channels" << std::endl;
+        }
+        std::string text = subscribeMsg.dump();
+        for (const auto& link : links) {
+            if (link.client->isOpen()) {
+                link.client->sendMessage(text);
+            }
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Error subscribing to " << channels.front() << ": " << e.what() << std::endl;
+    }
+}
+
+void WebSocketManager::subscribePrivateChannel(const std::string& channel) {
+    {
+        std::lock_guard<std::mutex> lock(channelsMutex);
+        privateChannels.insert(channel);
+    }
+    if (authenticated) {
+        sendPrivateSubscription({channel});
+    } else if (EnvHandler::getEnvVariable("DERIBIT_API_KEY").empty()) {
+        std::cerr << "Cannot subscribe to " << channel << " - no API credentials" << std::endl;
+    }
+    // Otherwise sent once the connection is authenticated
+}
+
+void WebSocketManager::sendPrivateSubscription(const std::vector<std::string>& channels) {
+    if (channels.empty()) {
+        return;
+    }
+
+    json subscribeMsg = {
+        {"method", "private/subscribe"},
+        {"params", {
+            {"channels", channels}
+        }},
+        {"jsonrpc", "2.0"},
+        {"id", 124}
+    };
+    sendToDeribit(subscribeMsg.dump());
+}
+
+void WebSocketManager::authenticate() {
+    std::string key = EnvHandler::getEnvVariable("DERIBIT_API_KEY");
+    std::string secret = EnvHandler::getEnvVariable("DERIBIT_API_SECRET");
+    if (key.empty() || secret.empty()) {
+        return;
+    }
+
+    json authMsg = {
+        {"method", "public/auth"},
+        {"params", {
+            {"grant_type", "client_credentials"},
+            {"client_id", key},
+            {"client_secret", secret}
+        }},
+        {"jsonrpc", "2.0"},
+        {"id", 133}
+    };
+    sendToDeribit(authMsg.dump());
+}
+
+void WebSocketManager::enableHeartbeat(WebSocketClient& feed) {
+    if (heartbeatInterval <= 0) {
+        return;
+    }
+
+    json heartbeatMsg = {
+        {"method", "public/set_heartbeat"},
+        {"params", {
+            {"interval", heartbeatInterval}
+        }},
+        {"jsonrpc", "2.0"},
+        {"id", 136}
+    };
+    feed.sendMessage(heartbeatMsg.dump());
+}
+
+void WebSocketManager::resubscribeAll(WebSocketClient& feed) {
+    std::vector<std::string> channels;
+    {
+        std::lock_guard<std::mutex> lock(channelsMutex);
+        channels.assign(publicChannels.begin(), publicChannels.end());
+    }
+    if (channels.empty()) {
+        return;
+    }
+
+    json subscribeMsg = {
+        {"method", "public/subscribe"},
+        {"params", {
+            {"channels", channels}
+        }},
+        {"jsonrpc", "2.0"},
+        {"id", 134}
+    };
+    std::cout << "Resubscribing to " << channels.size() << " channels" << std::endl;
+    feed.sendMessage(subscribeMsg.dump());
+}
+
+void WebSocketManager::markStale() {
+    // Every book must be rebuilt from the snapshot Deribit sends after resubscription
+    {
+        std::lock_guard<std::mutex> lock(booksMutex);
+        for (auto& entry : books) {
+            entry.second.resync = true;
+            staleBooks.insert(entry.first);
+        }
+    }
+
+    json notice = {{"type", "status"}, {"state", "stale"}, {"reason", "upstream disconnected"}};
+    server->broadcast(makeSharedBuffer(notice.dump()));
+}
+
+void WebSocketManager::runLink() {
+    std::mt19937 rng(std::random_device{}());
+
+    std::unique_lock<std::mutex> lock(linkMutex);
+    auto rpcDeadline = std::chrono::steady_clock::time_point::max();
+    while (running) {
+        // Watchdog: check the connections several times per timeout
+        auto wake = std::chrono::steady_clock::now() +
+                    (heartbeatTimeout.count() > 0 ? heartbeatTimeout / 4 : std::chrono::milliseconds(60000));
+        wake = std::min(wake, rpcDeadline);
+        for (const auto& link : links) {
+            if (link.down) {
+                wake = std::min(wake, link.retryAt);
+            }
+        }
+        linkCV.wait_until(lock, wake, [this] { return !running || linkChanged; });
+        linkChanged = false;
+        if (!running) {
+            break;
+        }
+
+        // Failed-over requests get the same deadline as on REST, whether or not Deribit answers
+        lock.unlock();
+        rpcDeadline = expirePendingRpc(std::chrono::steady_clock::now());
+        lock.lock();
+
+        auto now = std::chrono::steady_clock::now();
+        for (std::size_t i = 0; i < links.size() && running; ++i) {
+            WebSocketClient* feed = links[i].client;
+
+            if (!links[i].down) {
+                // A half-open connection never fails its read; heartbeats make silence detectable
+                auto silence = std::chrono::duration_cast<std::chrono::milliseconds>(now - feed->lastReceived());
+                if (heartbeatTimeout.count() > 0 && silence > heartbeatTimeout) {
+                    std::cerr << "No data from Deribit connection " << i << " for " << silence.count()
+                              << " ms, dropping it" << std::endl;
+                    lock.unlock();
+                    feed->abort(); // The failed read reports the drop through onClose
+                    lock.lock();
+                }
+                continue;
+            }
+            if (links[i].retryAt > now) {
+                continue;
+            }
+
+            // Cleared first, so a drop reported while connecting is not lost
+            links[i].down = false;
+            lock.unlock();
+            bool opened = feed->connect(deribitHost, deribitPort, deribitPath);
+            lock.lock();
+
+            if (opened) {
+                links[i].backoff = reconnectMin;
+                continue;
+            }
+
+            // Exponential backoff with jitter, so many gateways do not reconnect in lockstep
+            std::uniform_int_distribution<long> jitter(0, links[i].backoff.count() / 2);
+            auto delay = links[i].backoff + std::chrono::milliseconds(jitter(rng));
+            std::cerr << "Reconnecting Deribit connection " << i << " in " << delay.count() << " ms" << std::endl;
+            links[i].down = true;
+            links[i].retryAt = std::chrono::steady_clock::now() + delay;
+            links[i].backoff = std::min(links[i].backoff * 2, reconnectMax);
+        }
+    }
+}
+
+void WebSocketManager::onFeedDown(std::size_t feed) {
+    // Books keep flowing while any other connection is open
+    if (--openFeeds == 0) {
+        markStale();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(linkMutex);
+        links[feed].down = true;
+        links[feed].retryAt = std::chrono::steady_clock::now();
+        linkChanged = true;
+    }
+    linkCV.notify_all();
+}
+
+void WebSocketManager::onUpstreamMessage(std::size_t feed, const std::string& message) {
+    if (!arbiter) {
+        handleUpstreamMessage(message);
+        recomputeOptionChains();
+        return;
+    }
+
+    // The key is found before waiting for the lock, so duplicates cost a scan and a lookup
+    auto arrival = FeedArbiter::Clock::now();
+    FeedArbiter::Key key;
+    bool keyed = FeedArbiter::parseKey(message, key);
+
+    // Held while handling too, so updates accepted from different connections are handled in order
+    std::lock_guard<std::mutex> lock(upstreamMutex);
+    uint64_t forwarded = 0;
+    if (!keyed) {
+        // Responses and unsequenced notifications only count from the primary connection
+        if (feed == 0) {
+            handleUpstreamMessage(message);
+        }
+    } else if (arbiter->accept(feed, key, arrival, forwarded)) {
+        if (key.firstSequence > forwarded || key.sequence == forwarded) {
+            handleUpstreamMessage(message);
+        } else {
+            // Trades batched differently by another connection; only the ones not forwarded yet go on
+            json j = json::parse(message, nullptr, false);
+            if (!j.is_discarded() && j.contains("params") && j["params"].contains("data") &&
+                j["params"]["data"].is_array()) {
+                json fresh = json::array();
+                for (const auto& trade : j["params"]["data"]) {
+                    if (trade.value("trade_seq", uint64_t(0)) > forwarded) {
+                        fresh.push_back(trade);
+                    }
+                }
+                j["params"]["data"] = std::move(fresh);
+                handleUpstreamMessage(j.dump());
+            }
+        }
+    }
+    recomputeOptionChains();
+}
+
+json WebSocketManager::feedStats() {
+    json result = json::array();
+    std::lock_guard<std::mutex> lock(upstreamMutex);
+    for (std::size_t i = 0; i < links.size(); ++i) {
+        json entry = {{"feed", i}, {"connected", links[i].client->isOpen()}};
+        if (arbiter) {
+            const FeedArbiter::FeedStats& stats = arbiter->stats(i);
+            uint64_t total = stats.wins + stats.duplicates;
+            entry["wins"] = stats.wins;
+            entry["duplicates"] = stats.duplicates;
+            entry["win_rate"] = total ? static_cast<double>(stats.wins) / total : 0.0;
+            entry["mean_lag_us"] = stats.lagSamples ? static_cast<double>(stats.lagTotalUs) / stats.lagSamples : 0.0;
+            entry["max_lag_us"] = stats.lagMaxUs;
+        }
+        result.push_back(entry);
+    }
+    return result;
+}
+
+void WebSocketManager::broadcastToSubscribers(const json& data, const std::string& type, const std::string& symbol) {
+    // Each representation is built at most once per update, whatever the subscriber count
+    EncodedUpdate update(deflater.get(), server->compressionConfig().threshold);
+    auto makeText = [&data]() { return data.dump(); };
+    auto makeBinary = [&](std::string& out) { encodeBinary(encoder, type, data, out); };
+
+    // Cached and sent under stateMutex, so a new subscriber gets either this update or a cache holding it
+    std::unique_lock<std::mutex> stateLock(stateMutex, std::defer_lock);
+    if (type == "ticker" || type == "position") {
+        stateLock.lock();
+        latestState[type][symbol] = data;
+    }
+
+    forEachSubscriber(type, symbol, [&](const std::shared_ptr<WebSocketSession>& session) {
+        sendEncoded(session, update, makeText, makeBinary);
+    });
+
+    // Only the Deribit read thread gets here, so the ring has a single producer
+    if (ring) {
+        std::string topic = type + "." + symbol;
+        if (ringBinary) {
+            ring->publish(topic, *update.binaryBuffer(makeBinary), true);
+        } else {
+            ring->publish(topic, *update.textBuffer(makeText), false);
+        }
+    }
+
+    // Positions are private to this account and never leave the host
+    if (multicast && type != "position") {
+        if (!multicast->publish(*update.binaryBuffer(makeBinary))) {
+            std::cerr << "Update for " << symbol << " too large for a multicast packet" << std::endl;
+        }
+    }
+
+    sampleThrottled(data, type, symbol);
+}
+
+void WebSocketManager::addThrottleInterval(int intervalMs) {
+    {
+        std::lock_guard<std::mutex> lock(throttleMutex);
+        auto interval = std::chrono::milliseconds(intervalMs);
+        throttleBuckets.try_emplace(intervalMs, ThrottleBucket{interval, std::chrono::steady_clock::now() + interval, {}});
+    }
+    throttleCV.notify_one();
+}
+
+void WebSocketManager::sampleThrottled(const json& data, const std::string& type, const std::string& symbol) {
+    std::vector<int> intervals;
+    {
+        std::lock_guard<std::mutex> lock(throttleMutex);
+        for (const auto& entry : throttleBuckets) {
+            intervals.push_back(entry.first);
+        }
+    }
+
+    for (int interval : intervals) {
+        if (!hasSubscribers(subscriptionKey(type, interval), symbol)) {
+            continue;
+        }
+
+        std::lock_guard<std::mutex> lock(throttleMutex);
+        json& pending = throttleBuckets.at(interval).pending[{type, symbol}];
+        if (type == "trades") {
+            // Trades are events, so every trade of the interval is delivered in one batch
+            if (!pending.is_array()) {
+                pending = json::array();
+            }
+            for (const auto& trade : data) {
+                pending.push_back(trade);
+            }
+        } else if (type == "orderbook") {
+            pending = true; // The snapshot is taken from the book when the interval ends
+        } else {
+            pending = data;
+        }
+    }
+}
+
+void WebSocketManager::runSampler() {
+    std::unique_lock<std::mutex> lock(throttleMutex);
+    while (running) {
+        auto next = std::chrono::steady_clock::time_point::max();
+        for (const auto& entry : throttleBuckets) {
+            next = std::min(next, entry.second.due);
+        }
+        if (next == std::chrono::steady_clock::time_point::max()) {
+            throttleCV.wait(lock);
+        } else {
+            throttleCV.wait_until(lock, next);
+        }
+
+        auto now = std::chrono::steady_clock::now();
+        for (auto& entry : throttleBuckets) {
+            ThrottleBucket& bucket = entry.second;
+            if (!running || bucket.due > now) {
+                continue;
+            }
+
+            // A late sampler skips the missed ticks rather than bursting to catch up
+            bucket.due += bucket.interval;
+            if (bucket.due <= now) {
+                bucket.due = now + bucket.interval;
+            }
+
+            auto pending = std::move(bucket.pending);
+            bucket.pending.clear();
+            if (pending.empty()) {
+                continue;
+            }
+
+            // Buckets are never erased, so the iterator survives while the lock is released
+            lock.unlock();
+            flushThrottled(entry.first, pending);
+            lock.lock();
+        }
+    }
+}
+
+void WebSocketManager::flushThrottled(int intervalMs, const std::map<std::pair<std::string, std::string>, json>& pending) {
+    for (const auto& entry : pending) {
+        const std::string& type = entry.first.first;
+        const std::string& symbol = entry.first.second;
+        std::string key = subscriptionKey(type, intervalMs);
+
+        // Each update is encoded once for every session sharing the interval
+        EncodedUpdate update(deflater.get(), server->compressionConfig().threshold);
+        if (type == "orderbook") {
+            std::lock_guard<std::mutex> lock(booksMutex);
+            auto it = books.find(symbol);
+            if (it == books.end() || it->second.resync) {
+                continue;
+            }
+            const BookState& state = it->second;
+            forEachSubscriber(key, symbol, [&](const std::shared_ptr<WebSocketSession>& session) {
+                sendEncoded(session, update,
+                            [&]() { return bookSnapshotText(state.book, state.sequence); },
+                            [&](std::string& out) { encodeBookSnapshot(encoder, state.book, state.sequence, out); });
+            });
+        } else {
+            const json& data = entry.second;
+            forEachSubscriber(key, symbol, [&](const std::shared_ptr<WebSocketSession>& session) {
+                sendEncoded(session, update,
+                            [&data]() { return data.dump(); },
+                            [&](std::string& out) { encodeBinary(encoder, type, data, out); });
+            });
+        }
+    }
+}
+
+void WebSocketManager::handleBookUpdate(const std::string& symbol, const json& data) {
+    std::lock_guard<std::mutex> lock(booksMutex);
+    BookState& state = books.try_emplace(symbol, symbol, analyticsDepth).first->second;
+
+    // Forwarded under booksMutex, so a new subscriber's snapshot and this change never cross
+    broadcastToSubscribers(data, "orderbook", symbol);
+
+    if (!state.book.apply(data, &state.changes)) {
+        if (!state.resync) {
+            std::cerr << "Order book gap for " << symbol << ", requesting a new snapshot" << std::endl;
+            state.resync = true;
+            resubscribeBook(symbol);
+        }
+        return;
+    }
+
+    if (state.resync) {
+        // Subscribers replace their book on a snapshot, whatever they held before
+        state.resync = false;
+        ++state.sequence;
+        if (staleBooks.erase(symbol)) {
+            notifyResynced(symbol);
+        }
+        forEachSubscriber("orderbook_delta", symbol, [this, &state](const std::shared_ptr<WebSocketSession>& session) {
+            sendBookSnapshot(session, state);
+        });
+        state.analytics.update(state.book, nullptr);
+        publishAnalytics(symbol, state);
+        updateOptionPrice(symbol, state.analytics.mid());
+        execution->onBook(symbol, bestPrice(state.book.bids()), bestPrice(state.book.asks()));
+        return;
+    }
+
+    if (state.changes.empty()) {
+        return;
+    }
+
+    ++state.sequence;
+    const OrderBook::Changes& changes = state.changes;
+    EncodedUpdate update(deflater.get(), server->compressionConfig().threshold);
+    forEachSubscriber("orderbook_delta", symbol, [&](const std::shared_ptr<WebSocketSession>& session) {
+        sendEncoded(session, update,
+                    [&]() {
+                        json delta = {
+                            {"type", "delta"},
+                            {"instrument_name", symbol},
+                            {"sequence", state.sequence},
+                            {"prev_sequence", state.sequence - 1},
+                            {"change_id", state.book.changeId()},
+                            {"timestamp", state.book.timestamp()},
+                            {"bids", levelsToJson(changes.bids.prices, changes.bids.amounts)},
+                            {"asks", levelsToJson(changes.asks.prices, changes.asks.amounts)}
+                        };
+                        return delta.dump();
+                    },
+                    [&](std::string& out) {
+                        encoder.encodeBook(symbol, state.sequence, state.sequence - 1, state.book.timestamp(), false,
+                                           levelArrays(changes.bids.prices, changes.bids.amounts),
+                                           levelArrays(changes.asks.prices, changes.asks.amounts), out);
+                    });
+    });
+
+    // Kept current whether or not anyone listens, so a new subscriber never waits for a full recompute
+    if (state.analytics.update(state.book, &changes)) {
+        publishAnalytics(symbol, state);
+        updateOptionPrice(symbol, state.analytics.mid());
+        execution->onBook(symbol, bestPrice(state.book.bids()), bestPrice(state.book.asks()));
+    }
+}
+
+void WebSocketManager::publishAnalytics(const std::string& symbol, const BookState& state) {
+    if (hasConsumers("book_analytics", symbol)) {
+        broadcastToSubscribers(state.analytics.toJson(state.book), "book_analytics", symbol);
+    }
+}
+
+bool WebSocketManager::hasConsumers(const std::string& type, const std::string& symbol) {
+    if (ring || multicast || hasSubscribers(type, symbol)) {
+        return true;
+    }
+
+    std::vector<int> intervals;
+    {
+        std::lock_guard<std::mutex> lock(throttleMutex);
+        for (const auto& entry : throttleBuckets) {
+            intervals.push_back(entry.first);
+        }
+    }
+    return std::any_of(intervals.begin(), intervals.end(), [&](int interval) {
+        return hasSubscribers(subscriptionKey(type, interval), symbol);
+    });
+}
+
+void WebSocketManager::notifyResynced(const std::string& symbol) {
+    auto notice = makeSharedBuffer(json{{"type", "status"}, {"state", "live"}, {"instrument_name", symbol}}.dump());
+    for (const char* type : {"orderbook", "orderbook_delta"}) {
+        forEachSubscriber(type, symbol, [&notice](const std::shared_ptr<WebSocketSession>& session) {
+            session->send(notice, false);
+        });
+    }
+
+    if (staleBooks.empty()) {
+        notifyAllResynced();
+    }
+}
+
+void WebSocketManager::notifyAllResynced() {
+    std::cout << "All books resynced after reconnect" << std::endl;
+    server->broadcast(makeSharedBuffer(json{{"type", "status"}, {"state", "live"}}.dump()));
+}
+
+void WebSocketManager::pruneStaleBooks() {
+    std::vector<std::string> keys;
+    {
+        std::lock_guard<std::mutex> lock(throttleMutex);
+        for (const char* type : {"orderbook", "orderbook_delta"}) {
+            keys.push_back(type);
+            for (const auto& entry : throttleBuckets) {
+                keys.push_back(subscriptionKey(type, entry.first));
+            }
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(booksMutex);
+    if (staleBooks.empty()) {
+        return;
+    }
+    for (auto it = staleBooks.begin(); it != staleBooks.end();) {
+        bool followed = std::any_of(keys.begin(), keys.end(), [&](const std::string& key) {
+            return hasSubscribers(key, *it);
+        });
+        it = followed ? std::next(it) : staleBooks.erase(it);
+    }
+    if (staleBooks.empty()) {
+        notifyAllResynced();
+    }
+}
+
+void WebSocketManager::sendBookSnapshot(const std::shared_ptr<WebSocketSession>& session, const BookState& state) {
+    EncodedUpdate update(deflater.get(), server->compressionConfig().threshold);
+    sendEncoded(session, update,
+                [&]() { return bookSnapshotText(state.book, state.sequence); },
+                [&](std::string& out) { encodeBookSnapshot(encoder, state.book, state.sequence, out); });
+}
+
+void WebSocketManager::sendCachedBooks(const std::shared_ptr<WebSocketSession>& session, const std::string& symbol,
+                                       bool sampled) {
+    for (const auto& entry : books) {
+        const BookState& state = entry.second;
+        if (state.resync || !TopicTrie::matches(symbol, entry.first)) {
+            continue;
+        }
+
+        // Sampled subscribers get the same snapshots as their interval deliveries
+        EncodedUpdate update(deflater.get(), server->compressionConfig().threshold);
+        if (sampled) {
+            sendEncoded(session, update,
+                        [&]() { return bookSnapshotText(state.book, state.sequence); },
+                        [&](std::string& out) { encodeBookSnapshot(encoder, state.book, state.sequence, out); });
+        } else {
+            sendEncoded(session, update,
+                        [&]() { return deribitSnapshotText(state.book); },
+                        [&](std::string& out) { encodeBookSnapshot(encoder, state.book, state.book.changeId(), out); });
+        }
+    }
+}
+
+void WebSocketManager::sendCachedAnalytics(const std::shared_ptr<WebSocketSession>& session,
+                                           const std::string& symbol) {
+    for (const auto& entry : books) {
+        const BookState& state = entry.second;
+        if (state.resync || !TopicTrie::matches(symbol, entry.first)) {
+            continue;
+        }
+
+        json data = state.analytics.toJson(state.book);
+        EncodedUpdate update(deflater.get(), server->compressionConfig().threshold);
+        sendEncoded(session, update,
+                    [&data]() { return data.dump(); },
+                    [&](std::string& out) { encoder.encodeBookAnalytics(data, out); });
+    }
+}
+
+void WebSocketManager::sendCachedState(const std::shared_ptr<WebSocketSession>& session, const std::string& type,
+                                       const std::string& symbol) {
+    auto it = latestState.find(type);
+    if (it == latestState.end()) {
+        return;
+    }
+
+    for (const auto& entry : it->second) {
+        if (TopicTrie::matches(symbol, entry.first)) {
+            const json& data = entry.second;
+            EncodedUpdate update(deflater.get(), server->compressionConfig().threshold);
+            sendEncoded(session, update,
+                        [&data]() { return data.dump(); },
+                        [&](std::string& out) { encodeBinary(encoder, type, data, out); });
+        }
+    }
+}
+
+bool WebSocketManager::authorizeOrderEntry(const std::shared_ptr<WebSocketSession>& session, const json& request) {
+    if (session->isLocal()) {
+        return true;
+    }
+    auto token = request.find("token");
+    if (!orderEntryToken.empty() && token != request.end() && token->is_string() &&
+        tokensEqual(token->get_ref<const std::string&>(), orderEntryToken)) {
+        return true;
+    }
+
+    std::cerr << "Refused " << request["method"].get<std::string>() << " from a remote client" << std::endl;
+    session->send(json{{"method", request["method"]}, {"id", request.contains("id") ? request["id"] : json()},
+                       {"error", {{"message", "order entry is only accepted from local clients or with ORDER_ENTRY_TOKEN"}}}}.dump(),
+                  false);
+    return false;
+}
+
+void WebSocketManager::handleOrderRequest(const std::shared_ptr<WebSocketSession>& session, const json& request) {
+    const std::string method = request["method"];
+    json id = request.contains("id") ? request["id"] : json();
+
+    // The session may be gone by the time Deribit answers
+    std::weak_ptr<WebSocketSession> weakSession = session;
+    auto reply = [weakSession, method, id](const json& response, std::exception_ptr error) {
+        auto session = weakSession.lock();
+        if (!session) {
+            return;
+        }
+
+        json message = {{"method", method}, {"id", id}};
+        if (error) {
+            try {
+                std::rethrow_exception(error);
+            } catch (const std::exception& e) {
+                message["error"] = {{"message", e.what()}};
+            }
+        } else if (response.contains("error")) {
+            message["error"] = response["error"];
+        } else {
+            message["result"] = response.value("result", json());
+        }
+        session->send(message.dump(), false);
+    };
+
+    try {
+        if (method == "place_order") {
+            orderHandler.placeOrder(request.at("instrument_name"), request.at("side"), request.value("type", "limit"),
+                                    request.at("amount"), request.value("price", 0.0),
+                                    request.value("reduce_only", false), request.value("label", ""),
+                                    request.value("time_in_force", ""), reply);
+        } else if (method == "cancel_order") {
+            orderHandler.cancelOrder(request.at("order_id"), reply);
+        } else {
+            orderHandler.modifyOrder(request.at("order_id"), request.at("price"), request.at("amount"), reply);
+        }
+    } catch (const std::exception& e) {
+        // Malformed requests are answered at once, with the same correlation id
+        reply(json(), std::make_exception_ptr(std::invalid_argument(e.what())));
+    }
+}
+
+void WebSocketManager::handleKillSwitchRequest(const std::shared_ptr<WebSocketSession>& session, const json& request) {
+    json id = request.contains("id") ? request["id"] : json();
+    std::weak_ptr<WebSocketSession> weakSession = session;
+    killSwitch([weakSession, id](const json& report) {
+        if (auto session = weakSession.lock()) {
+            session->send(json{{"method", "kill_switch"}, {"id", id}, {"result", report}}.dump(), false);
+        }
+    });
+}
+
+void WebSocketManager::handleAlgoRequest(const std::shared_ptr<WebSocketSession>& session, const json& request) {
+    const std::string method = request["method"];
+    json reply = {{"method", method}, {"id", request.contains("id") ? request["id"] : json()}};
+
+    try {
+        if (method == "start_algo") {
+            ExecutionEngine::ParentSpec spec;
+            spec.algorithm = ExecutionEngine::algorithmFromString(request.at("algorithm"));
+            spec.instrument = request.at("instrument_name");
+            spec.side = request.at("side");
+            spec.amount = request.at("amount");
+            spec.lotSize = request.value("lot_size", 1.0);
+            spec.duration = std::chrono::milliseconds(request.at("duration_ms").get<int64_t>());
+            spec.participation = request.value("participation", 0.0);
+            spec.limitPrice = request.value("limit_price", 0.0);
+            reply["result"] = {{"algo_id", execution->submit(spec)}};
+        } else if (method == "cancel_algo") {
+            reply["result"] = {{"cancelled", execution->cancel(request.at("algo_id"))}};
+        } else {
+            reply["result"] = execution->status();
+        }
+    } catch (const std::exception& e) {
+        reply["error"] = {{"message", e.what()}};
+    }
+    session->send(reply.dump(), false);
+}
+
+void WebSocketManager::killSwitch(std::function<void(const json&)> done) {
+    auto run = std::make_shared<KillSwitchRun>();
+    run->start = std::chrono::steady_clock::now();
+    run->done = std::move(done);
+
+    // Both transports are fired before anything else; whichever Deribit answers first confirms
+    bool viaWebSocket = connected && authenticated;
+    run->pending = viaWebSocket ? 2 : 1;
+    if (viaWebSocket) {
+        {
+            std::lock_guard<std::mutex> lock(killMutex);
+            killWaiting.push_back(run);
+        }
+        client->sendMessage(R"({"jsonrpc":"2.0","id":137,"method":"private/cancel_all","params":{}})");
+    }
+    orderHandler.cancelAllNow([this, run](const json& response, std::exception_ptr error) {
+        completeKill(run, "rest", response, error);
+    });
+    std::size_t algos = execution->cancelAll("kill switch");
+
+    std::cout << "Kill switch fired over " << (viaWebSocket ? "WebSocket and REST" : "REST")
+              << ", " << algos << " execution algorithms cancelled" << std::endl;
+}
+
+void WebSocketManager::completeKill(const std::shared_ptr<KillSwitchRun>& run, const std::string& transport,
+                                    const json& response, std::exception_ptr error) {
+    auto latency = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - run->start).count();
+
+    json entry = {{"transport", transport}, {"latency_us", latency}};
+    if (error) {
+        try {
+            std::rethrow_exception(error);
+        } catch (const std::exception& e) {
+            entry["error"] = e.what();
+        }
+    } else if (response.contains("error")) {
+        entry["error"] = response["error"];
+    } else {
+        entry["cancelled"] = response.value("result", json());
+    }
+
+    json report;
+    {
+        std::lock_guard<std::mutex> lock(killMutex);
+        run->transports.push_back(entry);
+        if (--run->pending > 0) {
+            return;
+        }
+
+        // Transports are recorded in the order they answered
+        json first;
+        for (const auto& answer : run->transports) {
+            if (!answer.contains("error")) {
+                first = answer["latency_us"];
+                break;
+            }
+        }
+        report = {{"transports", run->transports}, {"first_confirmation_us", first}, {"halted", orderHandler.isHalted()}};
+    }
+
+    std::cout << "Kill switch: " << report.dump() << std::endl;
+    if (run->done) {
+        run->done(report);
+    }
+}
+
+void WebSocketManager::completeWebSocketKills(const json& response, std::exception_ptr error) {
+    std::vector<std::shared_ptr<KillSwitchRun>> runs;
+    {
+        std::lock_guard<std::mutex> lock(killMutex);
+        runs.swap(killWaiting);
+    }
+    for (const auto& run : runs) {
+        completeKill(run, "websocket", response, error);
+    }
+}
+
+bool WebSocketManager::sendRpc(const std::string& method, const json& params,
+                               std::chrono::steady_clock::time_point deadline, ResponseCallback callback) {
+    if (!connected || !authenticated) {
+        return false;
+    }
+
+    uint64_t id = nextRpcId++;
+    {
+        std::lock_guard<std::mutex> lock(rpcMutex);
+        pendingRpc.emplace(id, PendingRpc{std::move(callback), deadline});
+    }
+    {
+        // The link thread expires it at its deadline
+        std::lock_guard<std::mutex> lock(linkMutex);
+        linkChanged = true;
+    }
+    linkCV.notify_all();
+    sendToDeribit(json{{"jsonrpc", "2.0"}, {"id", id}, {"method", method}, {"params", params}}.dump());
+    return true;
+}
+
+void WebSocketManager::failPendingRpc(std::exception_ptr error) {
+    std::unordered_map<uint64_t, PendingRpc> pending;
+    {
+        std::lock_guard<std::mutex> lock(rpcMutex);
+        pending.swap(pendingRpc);
+    }
+    for (auto& entry : pending) {
+        entry.second.callback(json(), error);
+    }
+}
+
+std::chrono::steady_clock::time_point WebSocketManager::expirePendingRpc(std::chrono::steady_clock::time_point now) {
+    std::vector<ResponseCallback> expired;
+    auto next = std::chrono::steady_clock::time_point::max();
+    {
+        std::lock_guard<std::mutex> lock(rpcMutex);
+        for (auto it = pendingRpc.begin(); it != pendingRpc.end();) {
+            if (it->second.deadline <= now) {
+                expired.push_back(std::move(it->second.callback));
+                it = pendingRpc.erase(it);
+            } else {
+                next = std::min(next, it->second.deadline);
+                ++it;
+            }
+        }
+    }
+
+    // A late answer finds no callback and is dropped
+    auto error = std::make_exception_ptr(std::runtime_error("Request expired before Deribit answered"));
+    for (auto& callback : expired) {
+        callback(json(), error);
+    }
+    return next;
+}
+
+void WebSocketManager::enableCancelOnDisconnect() {
+    std::string scope = EnvHandler::getEnvVariable("CANCEL_ON_DISCONNECT");
+    if (scope.empty()) {
+        return;
+    }
+
+    json codMsg = {
+        {"method", "private/enable_cancel_on_disconnect"},
+        {"params", {
+            {"scope", scope}
+        }},
+        {"jsonrpc", "2.0"},
+        {"id", 138}
+    };
+    sendToDeribit(codMsg.dump());
+}
+
+void WebSocketManager::followRisk(const std::string& instrument) {
+    {
+        std::lock_guard<std::mutex> lock(channelsMutex);
+        if (!riskInstruments.insert(instrument).second) {
+            return;
+        }
+    }
+    std::cout << "Following " << instrument << " for pre-trade checks" << std::endl;
+    subscribeSymbol("ticker", instrument, 125);
+    subscribePrivateChannel("user.position." + instrument);
+    // The channel only reports changes; the current position is asked for once
+    if (authenticated) {
+        requestPosition(instrument);
+    }
+}
+
+void WebSocketManager::requestPosition(const std::string& instrument) {
+    json request = {
+        {"method", "private/get_position"},
+        {"params", {
+            {"instrument_name", instrument}
+        }},
+        {"jsonrpc", "2.0"},
+        {"id", 141}
+    };
+    sendToDeribit(request.dump());
+}
+
+void WebSocketManager::reconcileOrders() {
+    // Orders that ended while disconnected sent their notifications to no one
+    reconcileMark = orderHandler.risk().reconcileStart();
+    json request = {
+        {"method", "private/get_open_orders"},
+        {"params", json::object()},
+        {"jsonrpc", "2.0"},
+        {"id", 140}
+    };
+    sendToDeribit(request.dump());
+
+    std::vector<std::string> followed;
+    {
+        std::lock_guard<std::mutex> lock(channelsMutex);
+        followed.assign(riskInstruments.begin(), riskInstruments.end());
+    }
+    for (const auto& instrument : followed) {
+        requestPosition(instrument);
+    }
+}
+
+void WebSocketManager::trackOrders(const json& orders) {
+    if (!orders.is_array()) {
+        trackOrders(json::array({orders}));
+        return;
+    }
+    for (const auto& order : orders) {
+        if (!order.is_object() || !order.contains("order_id") || !order["order_id"].is_string()) {
+            continue;
+        }
+        orderHandler.risk().onOrder(order["order_id"], order.value("instrument_name", ""),
+                                    order.value("direction", "") == "buy", order.value("order_state", ""),
+                                    order.value("amount", 0.0), order.value("filled_amount", 0.0), 0);
+    }
+}
+
+void WebSocketManager::resubscribeBook(const std::string& symbol) {
+    // Deribit sends a fresh snapshot when a book channel is subscribed again
+    std::string channel = "book." + symbol + ".100ms";
+    json unsubscribeMsg = {
+        {"method", "public/unsubscribe"},
+        {"params", {
+            {"channels", {channel}}
+        }},
+        {"jsonrpc", "2.0"},
+        {"id", 127}
+    };
+    sendToDeribit(unsubscribeMsg.dump());
+    subscribeChannel(channel, 123);
+}
+
+void WebSocketManager::setupDeribitClient() {
+    client->onOpen([this]() {
+        std::cout << "\nDeribit WebSocket connected!" << std::endl;
+        connected = true;
+
+        ++openFeeds;
+
+        // Private channels follow once the auth response arrives
+        enableHeartbeat(*client);
+        authenticate();
+        resubscribeAll(*client);
+        if (instrumentsRequested) {
+            requestInstruments();
+        }
+        requestOptionChains();
+    });
+
+    client->onMessage([this](const std::string& message) {
+        onUpstreamMessage(0, message);
+    });
+
+    // Runs on the client's read thread; the link thread does the reconnecting
+    client->onClose([this]() {
+        std::cout << "Deribit connection closed" << std::endl;
+        connected = false;
+        authenticated = false;
+        auto closed = std::make_exception_ptr(std::runtime_error("Connection closed"));
+        completeWebSocketKills(json(), closed);
+        failPendingRpc(closed);
+        onFeedDown(0);
+    });
+
+    client->onError([](const std::string& error) {
+        if (error.find("Operation canceled") == std::string::npos &&
+            error.find("stream truncated") == std::string::npos &&
+            error.find("End of file") == std::string::npos) {
+            std::cerr << "Deribit WebSocket error: " << error << std::endl;
+        }
+    });
+
+    links.push_back(FeedLink{client.get(), true, std::chrono::milliseconds(0), std::chrono::steady_clock::time_point()});
+
+    // Redundant connections carry the public channels only; RPC stays on the primary
+    std::string value = EnvHandler::getEnvVariable("UPSTREAM_FEEDS");
+    std::size_t feeds = value.empty() ? 1 : std::max(1, std::stoi(value));
+    for (std::size_t i = 1; i < feeds; ++i) {
+        backupClients.push_back(std::make_unique<WebSocketClient>());
+        WebSocketClient* feed = backupClients.back().get();
+
+        feed->onOpen([this, i, feed]() {
+            std::cout << "Redundant Deribit connection " << i << " connected" << std::endl;
+            ++openFeeds;
+            enableHeartbeat(*feed);
+            resubscribeAll(*feed);
+        });
+        feed->onMessage([this, i](const std::string& message) {
+            onUpstreamMessage(i, message);
+        });
+        feed->onClose([this, i]() {
+            std::cout << "Redundant Deribit connection " << i << " closed" << std::endl;
+            onFeedDown(i);
+        });
+        feed->onError([i](const std::string& error) {
+            if (error.find("Operation canceled") == std::string::npos &&
+                error.find("stream truncated") == std::string::npos &&
+                error.find("End of file") == std::string::npos) {
+                std::cerr << "Deribit connection " << i << " error: " << error << std::endl;
+            }
+        });
+
+        links.push_back(FeedLink{feed, true, std::chrono::milliseconds(0), std::chrono::steady_clock::time_point()});
+    }
+    if (feeds > 1) {
+        arbiter = std::make_unique<FeedArbiter>(feeds);
+    }
+}
+
+void WebSocketManager::handleUpstreamMessage(const std::string& message) {
+    if (recorder) {
+        recorder->record(message);
+    }
+
+    try {
+        json j = json::parse(message);
+        // std::cout << "Received from Deribit: " << j.dump(2) << std::endl;
+
+        // Kill switch confirmation, checked first
+        if (j.value("id", 0) == 137) {
+            if (j.contains("result")) {
+                orderHandler.risk().clearOrders();
+            }
+            completeWebSocketKills(j, nullptr);
+            return;
+        }
+        
+        // Order request failed over from REST
+        if (j.value("id", uint64_t(0)) >= 1000) {
+            ResponseCallback callback;
+            {
+                std::lock_guard<std::mutex> lock(rpcMutex);
+                auto it = pendingRpc.find(j["id"].get<uint64_t>());
+                if (it != pendingRpc.end()) {
+                    callback = std::move(it->second.callback);
+                    pendingRpc.erase(it);
+                }
+            }
+            if (callback) {
+                callback(j, nullptr);
+            }
+            return;
+        }
+
+        // Options of a chain currency
+        if (j.value("id", 0) == 139) {
+            if (j.contains("result")) {
+                addOptions(j["result"]);
+            } else {
+                std::cerr << "Option chain request failed: " << j.value("error", json()).dump() << std::endl;
+            }
+            return;
+        }
+
+        // Instrument list backing pattern subscriptions and binary tick sizes
+        if (j.value("id", 0) == 130 && j.contains("result")) {
+            std::vector<std::string> names;
+            for (const auto& instrument : j["result"]) {
+                names.push_back(instrument["instrument_name"]);
+                encoder.setTickSize(names.back(), instrument.value("tick_size", 0.0));
+            }
+            addInstruments(names);
+            return;
+        }
+
+        // Authentication of this connection, needed for private channels
+        if (j.value("id", 0) == 133) {
+            if (j.contains("result")) {
+                authenticated = true;
+                enableCancelOnDisconnect();
+                std::vector<std::string> channels;
+                {
+                    std::lock_guard<std::mutex> lock(channelsMutex);
+                    channels.assign(privateChannels.begin(), privateChannels.end());
+                }
+                sendPrivateSubscription(channels);
+                reconcileOrders();
+            } else {
+                std::cerr << "Deribit authentication failed: " << j.value("error", json()).dump() << std::endl;
+            }
+            return;
+        }
+
+        // Open orders after authentication; tracked orders missing from them have ended
+        if (j.value("id", 0) == 140) {
+            if (j.contains("result") && j["result"].is_array()) {
+                std::unordered_set<std::string> open;
+                for (const auto& order : j["result"]) {
+                    if (order.contains("order_id") && order["order_id"].is_string()) {
+                        open.insert(order["order_id"].get<std::string>());
+                    }
+                }
+                orderHandler.risk().reconcile(open, reconcileMark);
+                trackOrders(j["result"]);
+            } else {
+                std::cerr << "Open orders request failed: " << j.value("error", json()).dump() << std::endl;
+            }
+            return;
+        }
+
+        if (j.value("id", 0) == 141) {
+            if (j.contains("result") && j["result"].is_object() && j["result"].contains("instrument_name")) {
+                orderHandler.risk().updatePosition(j["result"]["instrument_name"], j["result"].value("size", 0.0));
+            } else {
+                std::cerr << "Position request failed: " << j.value("error", json()).dump() << std::endl;
+            }
+            return;
+        }
+
+        // Heartbeat setup and test_request answers need no handling
+        if (j.value("id", 0) == 135 || j.value("id", 0) == 136) {
+            if (j.contains("error")) {
+                std::cerr << "Deribit heartbeat error: " << j["error"].dump() << std::endl;
+            }
+            return;
+        }
+
+        if (j.value("id", 0) == 138) {
+            if (j.contains("error")) {
+                std::cerr << "Cancel-on-disconnect not enabled: " << j["error"].dump() << std::endl;
+            } else {
+                std::cout << "Cancel-on-disconnect enabled" << std::endl;
+            }
+            return;
+        }
+
+        // Handle subscription confirmation
+        if (j.contains("id")) {
+            std::cout << "Subscription response: " << j.dump(2) << std::endl;
+            if (j.contains("error")) {
+                std::cerr << "Subscription error: " << j["error"].dump(2) << std::endl;
+            }
+            return;
+        }
+        
+        // Handle orderbook data
+        if (j.contains("params")) {
+            if (j["params"].contains("channel") && j["params"].contains("data")) {
+                std::string channel = j["params"]["channel"];
+                
+                // Parse channel to determine type and symbol
+                if (channel.rfind("instrument.state.", 0) == 0) {
+                    const json& data = j["params"]["data"];
+                    std::string state = data.value("state", "");
+                    if (state == "created" || state == "started") {
+                        addInstruments({data["instrument_name"].get<std::string>()});
+                    }
+                }
+                else if (channel.rfind("user.orders.", 0) == 0) {
+                    trackOrders(j["params"]["data"]);
+                }
+                else if (channel.rfind("user.position.", 0) == 0) {
+                    std::string symbol = channel.substr(14);
+                    json position = j["params"]["data"];
+                    orderHandler.risk().updatePosition(symbol, position.value("size", 0.0));
+                    broadcastToSubscribers(position, "position", symbol);
+                }
+                else {
+                    size_t first = channel.find('.');
+                    size_t second = channel.find('.', first + 1);
+                    if (first != std::string::npos) {
+                        std::string prefix = channel.substr(0, first);
+                        std::string symbol = channel.substr(first + 1, second == std::string::npos ? std::string::npos : second - first - 1);
+                        const json& data = j["params"]["data"];
+
+                        if (prefix == "book") {
+                            handleBookUpdate(symbol, data);
+                        }
+                        else if (prefix == "ticker") {
+                            if (data.contains("mark_price")) {
+                                orderHandler.risk().updateMark(symbol, data["mark_price"]);
+                            }
+                            broadcastToSubscribers(data, "ticker", symbol);
+                        }
+                        else if (prefix == "trades") {
+                            double volume = 0;
+                            for (const auto& trade : data) {
+                                volume += trade.value("amount", 0.0);
+                            }
+                            execution->onTrades(symbol, volume);
+                            updateBars(symbol, data);
+                            broadcastToSubscribers(data, "trades", symbol);
+                        }
+                        else if (prefix == "deribit_price_index" && data.contains("price")) {
+                            // btc_usd feeds the BTC chain
+                            std::string currency = symbol.substr(0, symbol.find('_'));
+                            std::transform(currency.begin(), currency.end(), currency.begin(), ::toupper);
+                            std::lock_guard<std::mutex> lock(chainsMutex);
+                            auto it = chains.find(currency);
+                            if (it != chains.end()) {
+                                it->second.forward = data["price"];
+                                it->second.chain.setForwardAll(it->second.forward);
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    } catch (const json::parse_error& e) {
+        std::cout << "Raw message from Deribit: " << message << std::endl;
+    }
+}
+
+void WebSocketManager::start() {
+    std::cout << "Starting local WebSocket server..." << std::endl;
+    server->run();
+    samplerThread = std::thread(&WebSocketManager::runSampler, this);
+    execution->start();
+}
+
+void WebSocketManager::stop() {
+    execution->stop();
+
+    {
+        std::lock_guard<std::mutex> lock(linkMutex);
+        running = false;
+    }
+    linkCV.notify_all();
+    if (linkThread.joinable()) {
+        linkThread.join();
+    }
+
+    if (client && connected) {
+        std::cout << "Closing Deribit connection..." << std::endl;
+        client->close();
+    }
+    for (auto& feed : backupClients) {
+        if (feed->isOpen()) {
+            feed->close();
+        }
+    }
+
+    if (server) {
+        std::cout << "Stopping WebSocket server..." << std::endl;
+        server->stop();
+    }
+
+    if (recorder) {
+        recorder->stop();
+        CaptureStats stats = recorder->stats();
+        if (stats.compressedBytes > 0) {
+            std::cout << "Capture: " << stats.frames << " frames, "
+                      << stats.rawBytes << " -> " << stats.compressedBytes << " bytes ("
+                      << static_cast<double>(stats.rawBytes) / stats.compressedBytes << "x)" << std::endl;
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(throttleMutex);
+        running = false;
+    }
+    throttleCV.notify_all();
+    if (samplerThread.joinable()) {
+        samplerThread.join();
+    }
+}
+
+void WebSocketManager::connectToDeribit(const std::string& host, const std::string& port, const std::string& path) {
+    deribitHost = host;
+    deribitPort = port;
+    deribitPath = path;
+
+    std::string value = EnvHandler::getEnvVariable("RECONNECT_BACKOFF_MIN_MS");
+    if (!value.empty()) {
+        reconnectMin = std::chrono::milliseconds(std::stol(value));
+    }
+    value = EnvHandler::getEnvVariable("RECONNECT_BACKOFF_MAX_MS");
+    if (!value.empty()) {
+        reconnectMax = std::chrono::milliseconds(std::stol(value));
+    }
+    reconnectMin = std::max(reconnectMin, std::chrono::milliseconds(1));
+
+    value = EnvHandler::getEnvVariable("HEARTBEAT_INTERVAL_S");
+    if (!value.empty()) {
+        heartbeatInterval = std::stoi(value);
+    }
+    value = EnvHandler::getEnvVariable("HEARTBEAT_TIMEOUT_MS");
+    if (!value.empty()) {
+        heartbeatTimeout = std::chrono::milliseconds(std::stol(value));
+    }
+    if (heartbeatInterval <= 0) {
+        heartbeatTimeout = std::chrono::milliseconds(0); // Without heartbeats a quiet feed is not a dead one
+    } else {
+        // Deribit rejects intervals below 10 seconds
+        heartbeatInterval = std::max(heartbeatInterval, 10);
+    }
+
+    // The primary is tried here; the link thread opens the others, and reconnects any that drop
+    for (auto& link : links) {
+        link.backoff = reconnectMin;
+        link.retryAt = std::chrono::steady_clock::now();
+    }
+    links[0].down = !client->connect(host, port, path);
+    linkThread = std::thread(&WebSocketManager::runLink, this);
 }
 
 void WebSocketManager::sendToDeribit(const std::string& message) {
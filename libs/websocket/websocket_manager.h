@@ -4,8 +4,27 @@
 #include "websocket_client.h"
 #include "websocket_server.h"
 #include "order_placement.h"
+#include "execution_engine.h"
+#include "capture_writer.h"
+#include "binary_protocol.h"
+#include "order_book.h"
+#include "book_analytics.h"
+#include "bar_aggregator.h"
+#include "option_chain.h"
+#include "shm_ring.h"
+#include "multicast_publisher.h"
+#include "feed_arbiter.h"
 #include <memory>
 #include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
 #include <nlohmann/json.hpp>
 
 using json = nlohmann::json;
@@ -75,12 +94,593 @@ public:
      */
     void handleOrderBookSubscription(const std::string& symbol);
 
+    /**
+     * @brief Get the gateway's order handler, shared with local clients
+     * 
+     * @return OrderPlacement& The order handler
+     */
+    OrderPlacement& orders() { return orderHandler; }
+
+    /**
+     * @brief Get the engine running TWAP and VWAP parent orders
+     * 
+     * @return ExecutionEngine& The execution engine, fed by the gateway's book and trade streams
+     */
+    ExecutionEngine& executionEngine() { return *execution; }
+
+    /**
+     * @brief Get the arbitration results of each Deribit connection
+     * 
+     * @return json One entry per connection with its win rate and lag behind the first copy
+     */
+    json feedStats();
+
+    /**
+     * @brief Cancel every open order on every available transport at once
+     * 
+     * private/cancel_all goes out on the authenticated Deribit WebSocket, if
+     * any, and on the order handler's dedicated REST path; trading stays
+     * halted until orders().resume(). The report lists each transport's
+     * answer and latency, and the time to the first confirmation.
+     * 
+     * @param done Receives the report once every transport has answered
+     */
+    void killSwitch(std::function<void(const json&)> done);
+
 private:
+    /**
+     * @brief Book kept for delta subscribers of one instrument
+     */
+    struct BookState {
+        BookState(const std::string& instrument, std::size_t depth) : book(instrument), analytics(depth) {}
+
+        OrderBook book; /**< Current book */
+        BookAnalytics analytics; /**< Analytics of book, updated with it */
+        OrderBook::Changes changes; /**< Levels changed by the last update */
+        uint64_t sequence = 0; /**< Sequence of the last message sent to delta subscribers */
+        bool resync = true; /**< True until a snapshot has been applied (again) */
+    };
+
+    /**
+     * @brief Option chain of one currency and the index price used as its forward
+     */
+    struct ChainState {
+        OptionChain chain; /**< Options of the currency */
+        double forward = 0; /**< Last index price, 0 until known */
+    };
+
+    /**
+     * @brief One kill switch activation waiting for its transports
+     */
+    struct KillSwitchRun {
+        std::chrono::steady_clock::time_point start; /**< When it was fired */
+        int pending = 0; /**< Transports yet to answer */
+        json transports = json::array(); /**< Answers in arrival order */
+        std::function<void(const json&)> done; /**< Receives the report */
+    };
+
+    /**
+     * @brief Reconnect state of one Deribit connection
+     */
+    struct FeedLink {
+        WebSocketClient* client; /**< The connection; index 0 is the primary */
+        bool down = true; /**< True while disconnected and not being connected */
+        std::chrono::milliseconds backoff{0}; /**< Delay before the next attempt after a failure */
+        std::chrono::steady_clock::time_point retryAt; /**< When the next attempt is due */
+    };
+
+    /**
+     * @brief Order request failed over from REST, waiting for Deribit's answer
+     */
+    struct PendingRpc {
+        ResponseCallback callback; /**< Receives the answer or the failure */
+        std::chrono::steady_clock::time_point deadline; /**< When the request is failed if still unanswered */
+    };
+
+    /**
+     * @brief Latest state held for the throttled subscriptions of one interval
+     */
+    struct ThrottleBucket {
+        std::chrono::milliseconds interval; /**< Sampling interval */
+        std::chrono::steady_clock::time_point due; /**< When the pending state is next delivered */
+        std::map<std::pair<std::string, std::string>, json> pending; /**< State by type and instrument since the last delivery */
+    };
+
     std::atomic<bool> running{true}; /**< Flag to indicate if the manager is running */
     std::atomic<bool> connected{false}; /**< Flag to indicate if the client is connected */
+    std::atomic<bool> authenticated{false}; /**< True once the current connection has authenticated */
+    std::string deribitHost; /**< Deribit host, kept for reconnecting */
+    std::string deribitPort; /**< Deribit port, kept for reconnecting */
+    std::string deribitPath; /**< Deribit WebSocket path, kept for reconnecting */
+    std::chrono::milliseconds reconnectMin{100}; /**< First reconnect delay */
+    std::chrono::milliseconds reconnectMax{10000}; /**< Largest reconnect delay */
+    int heartbeatInterval = 10; /**< Seconds between Deribit heartbeats, 0 to disable */
+    std::chrono::milliseconds heartbeatTimeout{15000}; /**< Silence after which the connection is declared dead, 0 to disable */
+    std::thread linkThread; /**< Reconnects Deribit connections that drop, and watches for silence */
+    std::mutex linkMutex; /**< Mutex for synchronizing access to the state in links and linkChanged */
+    std::condition_variable linkCV; /**< Wakes the link thread on a drop, a new failed-over request and on stop */
+    bool linkChanged = false; /**< True when a connection has dropped or a failed-over request was sent since the link thread last looked */
+    std::vector<FeedLink> links; /**< Every Deribit connection, fixed once the manager is constructed */
+    std::atomic<int> openFeeds{0}; /**< Connections currently open; books go stale when none are */
+    std::vector<std::unique_ptr<WebSocketClient>> backupClients; /**< Redundant connections when UPSTREAM_FEEDS is above 1 */
+    std::unique_ptr<FeedArbiter> arbiter; /**< Picks the first copy of each update with redundant connections */
+    std::mutex upstreamMutex; /**< Serializes arbitration and handling of upstream messages */
+    std::vector<std::shared_ptr<KillSwitchRun>> killWaiting; /**< Kill switch runs waiting for the WebSocket answer */
+    std::mutex killMutex; /**< Mutex for synchronizing access to killWaiting and the runs */
+    std::unordered_map<uint64_t, PendingRpc> pendingRpc; /**< Order requests failed over from REST, by JSON-RPC id */
+    std::mutex rpcMutex; /**< Mutex for synchronizing access to pendingRpc */
+    std::atomic<uint64_t> nextRpcId{1000}; /**< Next id for failed-over requests, above the reserved ids */
+    std::set<std::string> publicChannels; /**< Every public channel subscribed upstream, resent on reconnect */
+    std::set<std::string> privateChannels; /**< Every private channel subscribed upstream, resent after authentication */
+    std::mutex channelsMutex; /**< Mutex for synchronizing access to publicChannels, privateChannels and riskInstruments */
+    std::set<std::string> riskInstruments; /**< Instruments whose position the risk checks follow, re-requested after authentication */
+    std::atomic<uint64_t> reconcileMark{0}; /**< PreTradeRisk::reconcileStart() of the pending open orders request */
+    std::set<std::string> staleBooks; /**< Books not yet resynced since the last disconnect; guarded by booksMutex */
     std::shared_ptr<WebSocketServer> server; /**< WebSocket server instance */
     std::unique_ptr<WebSocketClient> client; /**< WebSocket client instance */
     OrderPlacement orderHandler; /**< Order placement handler */
+    std::string orderEntryToken; /**< Lets remote clients send order entry requests, from ORDER_ENTRY_TOKEN */
+    std::shared_ptr<ExecutionEngine> execution; /**< Slices TWAP and VWAP parent orders through orderHandler */
+    std::unique_ptr<CaptureWriter> recorder; /**< Records raw Deribit frames when CAPTURE_DIR is set */
+    BinaryEncoder encoder; /**< Encodes updates for binary protocol sessions */
+    std::unique_ptr<ShmRingWriter> ring; /**< Shared memory ring for co-located consumers when SHM_RING_NAME is set */
+    bool ringBinary = false; /**< Publish binary protocol messages to the ring instead of JSON */
+    std::unique_ptr<MulticastPublisher> multicast; /**< Multicast market data publisher when MULTICAST_GROUP is set */
+    std::unique_ptr<MessageDeflate> deflater; /**< Compresses broadcasts once in shared compression mode */
+    std::map<int, ThrottleBucket> throttleBuckets; /**< Throttled subscription state by interval in ms */
+    std::mutex throttleMutex; /**< Mutex for synchronizing access to throttleBuckets */
+    std::condition_variable throttleCV; /**< Wakes the sampler for new intervals and on stop */
+    std::thread samplerThread; /**< Delivers throttled subscriptions */
+    std::unordered_set<std::string> instruments; /**< Live instruments, loaded once a pattern subscription exists */
+    std::mutex instrumentsMutex; /**< Mutex for synchronizing access to instruments */
+    std::atomic<bool> instrumentsRequested{false}; /**< True once the instrument list has been requested */
+    std::unordered_map<std::string, std::unordered_map<std::string, json>> latestState; /**< Last ticker and position data by type and instrument */
+    std::mutex stateMutex; /**< Mutex for synchronizing access to latestState; taken before subscriptionsMutex */
+    std::unordered_map<std::string, BookState> books; /**< Books by instrument */
+    std::mutex booksMutex; /**< Mutex for synchronizing access to books */
+    std::size_t analyticsDepth = 10; /**< Levels per side in book analytics, from BOOK_ANALYTICS_DEPTH */
+    std::vector<std::string> chainCurrencies; /**< Currencies with an option chain, from OPTION_CHAIN_CURRENCIES */
+    std::unordered_map<std::string, ChainState> chains; /**< Option chains by currency */
+    std::mutex chainsMutex; /**< Mutex for synchronizing access to chains; taken after booksMutex */
+    std::chrono::milliseconds chainInterval{100}; /**< Least time between option chain recomputes */
+    std::chrono::steady_clock::time_point chainRecomputed; /**< When the chains were last recomputed */
+    std::vector<int64_t> barResolutions; /**< Bar intervals in milliseconds, from BAR_RESOLUTIONS */
+    std::vector<std::string> barTypes; /**< Subscription type of each bar resolution, e.g. bars_1m */
+    std::size_t barHistory = 300; /**< Bars kept per resolution and instrument, from BAR_HISTORY */
+    std::unordered_map<std::string, BarAggregator> bars; /**< Bars by instrument, for every instrument whose trades arrive */
+    std::mutex barsMutex; /**< Mutex for synchronizing access to bars; taken before subscriptionsMutex */
+
+    /**
+     * @brief Send channel data to the local sessions subscribed to it
+     * 
+     * @param data The "data" member of the notification
+     * @param type The subscription type
+     * @param symbol The instrument name
+     */
+    void broadcastToSubscribers(const json& data, const std::string& type, const std::string& symbol);
+
+    /**
+     * @brief Register a sampling interval for throttled subscriptions
+     * 
+     * @param intervalMs The interval in milliseconds
+     */
+    void addThrottleInterval(int intervalMs);
+
+    /**
+     * @brief Record channel data as the latest state for throttled subscribers
+     * 
+     * Ticker and position updates replace the pending state, trades are
+     * appended to it, and books are marked for a snapshot.
+     * 
+     * @param data The "data" member of the notification
+     * @param type The subscription type
+     * @param symbol The instrument name
+     */
+    void sampleThrottled(const json& data, const std::string& type, const std::string& symbol);
+
+    /**
+     * @brief Sampler thread: deliver each interval's pending state when it is due
+     */
+    void runSampler();
+
+    /**
+     * @brief Send the pending state of one interval to its subscribers
+     * 
+     * @param intervalMs The interval in milliseconds
+     * @param pending State by type and instrument
+     */
+    void flushThrottled(int intervalMs, const std::map<std::pair<std::string, std::string>, json>& pending);
+
+    /**
+     * @brief Forward a book notification and send the changed levels to delta subscribers
+     * 
+     * Full book subscribers get the notification as is. Delta subscribers
+     * get a snapshot instead when the book has just been (re)built, and the
+     * book is resubscribed upstream when Deribit's change_id sequence has a gap.
+     * 
+     * @param symbol The instrument name
+     * @param data The "data" member of the notification
+     */
+    void handleBookUpdate(const std::string& symbol, const json& data);
+
+    /**
+     * @brief Send the full book to one session; the caller holds booksMutex
+     * 
+     * @param session The session
+     * @param state The book state
+     */
+    void sendBookSnapshot(const std::shared_ptr<WebSocketSession>& session, const BookState& state);
+
+    /**
+     * @brief Check that a session may send order entry requests
+     * 
+     * Unix domain socket and loopback clients may; others only with a
+     * "token" member equal to ORDER_ENTRY_TOKEN. Refused requests are
+     * answered with an error.
+     * 
+     * @param session The requesting session
+     * @param request The request message
+     * @return true if the request may proceed
+     */
+    bool authorizeOrderEntry(const std::shared_ptr<WebSocketSession>& session, const json& request);
+
+    /**
+     * @brief Route a local order, cancel or edit request through the order handler
+     * 
+     * The response is sent back to the session asynchronously with the
+     * request's "id" as correlation id.
+     * 
+     * @param session The requesting session
+     * @param request The request message
+     */
+    void handleOrderRequest(const std::shared_ptr<WebSocketSession>& session, const json& request);
+
+    /**
+     * @brief Fire the kill switch for a local client and send it the report
+     * 
+     * @param session The requesting session
+     * @param request The request message
+     */
+    void handleKillSwitchRequest(const std::shared_ptr<WebSocketSession>& session, const json& request);
+
+    /**
+     * @brief Start, cancel or list execution algorithms for a local client
+     * 
+     * Answers start_algo, cancel_algo and get_algos at once, with the
+     * request's "id" as correlation id.
+     * 
+     * @param session The requesting session
+     * @param request The request message
+     */
+    void handleAlgoRequest(const std::shared_ptr<WebSocketSession>& session, const json& request);
+
+    /**
+     * @brief Record one transport's answer to a kill switch run, reporting once all have answered
+     * 
+     * @param run The run
+     * @param transport "websocket" or "rest"
+     * @param response The Deribit response
+     * @param error The failure, if the request did not complete
+     */
+    void completeKill(const std::shared_ptr<KillSwitchRun>& run, const std::string& transport,
+                      const json& response, std::exception_ptr error);
+
+    /**
+     * @brief Complete every run waiting for the WebSocket answer
+     * 
+     * @param response The Deribit response
+     * @param error The failure, if the connection dropped first
+     */
+    void completeWebSocketKills(const json& response, std::exception_ptr error);
+
+    /**
+     * @brief Send order requests over the authenticated WebSocket while the REST circuit is open
+     * 
+     * @param method The Deribit method
+     * @param params The parameters
+     * @param deadline When the link thread fails the request if Deribit has not answered
+     * @param callback Receives the response, or the failure if the connection drops or the deadline passes first
+     * @return true if sent, false if the connection is not authenticated
+     */
+    bool sendRpc(const std::string& method, const json& params, std::chrono::steady_clock::time_point deadline,
+                 ResponseCallback callback);
+
+    /**
+     * @brief Fail every failed-over request still waiting for its answer
+     * 
+     * @param error The failure
+     */
+    void failPendingRpc(std::exception_ptr error);
+
+    /**
+     * @brief Fail the failed-over requests whose deadline has passed
+     * 
+     * @param now The current time
+     * @return std::chrono::steady_clock::time_point The earliest deadline still pending, or time_point::max()
+     */
+    std::chrono::steady_clock::time_point expirePendingRpc(std::chrono::steady_clock::time_point now);
+
+    /**
+     * @brief Have Deribit cancel our orders if this connection drops, per CANCEL_ON_DISCONNECT
+     */
+    void enableCancelOnDisconnect();
+
+    /**
+     * @brief Subscribe the ticker and position of an instrument whose risk limits need them
+     *
+     * @param instrument The instrument name
+     */
+    void followRisk(const std::string& instrument);
+
+    /**
+     * @brief Ask Deribit for the position of an instrument, answered as id 141
+     *
+     * @param instrument The instrument name
+     */
+    void requestPosition(const std::string& instrument);
+
+    /**
+     * @brief Catch up the risk checks after authentication: open orders (id 140) and followed positions
+     */
+    void reconcileOrders();
+
+    /**
+     * @brief Pass Deribit order objects from user.orders or get_open_orders to the risk checks
+     *
+     * @param orders An order object or an array of them
+     */
+    void trackOrders(const json& orders);
+
+    /**
+     * @brief Send the cached books matching a subscription to a new subscriber; the caller holds booksMutex
+     * 
+     * @param session The session
+     * @param symbol The subscribed instrument name or pattern
+     * @param sampled True for a throttled subscription, which gets gateway snapshots rather than Deribit's format
+     */
+    void sendCachedBooks(const std::shared_ptr<WebSocketSession>& session, const std::string& symbol, bool sampled);
+
+    /**
+     * @brief Send the analytics of the books matching a subscription to a new subscriber; the caller holds booksMutex
+     * 
+     * @param session The session
+     * @param symbol The subscribed instrument name or pattern
+     */
+    void sendCachedAnalytics(const std::shared_ptr<WebSocketSession>& session, const std::string& symbol);
+
+    /**
+     * @brief Publish a book's analytics if anything consumes them; the caller holds booksMutex
+     * 
+     * @param symbol The instrument name
+     * @param state The book state
+     */
+    void publishAnalytics(const std::string& symbol, const BookState& state);
+
+    /**
+     * @brief Check whether an update of a type would reach anyone, at any interval or over the ring or multicast
+     * 
+     * @param type The update type
+     * @param symbol The instrument name
+     * @return true if it has a consumer
+     */
+    bool hasConsumers(const std::string& type, const std::string& symbol);
+
+    /**
+     * @brief Send the cached ticker or position state matching a subscription; the caller holds stateMutex
+     * 
+     * @param session The session
+     * @param type "ticker" or "position"
+     * @param symbol The subscribed instrument name or pattern
+     */
+    void sendCachedState(const std::shared_ptr<WebSocketSession>& session, const std::string& type,
+                         const std::string& symbol);
+
+    /**
+     * @brief Resubscribe to a book channel to get a fresh snapshot
+     * 
+     * @param symbol The instrument name
+     */
+    void resubscribeBook(const std::string& symbol);
+
+    /**
+     * @brief Subscribe upstream for a local subscription
+     * 
+     * A pattern is expanded to the matching known instruments, and the
+     * instrument list is requested on first use so that instruments listed
+     * later are subscribed as they appear.
+     * 
+     * @param type The subscription type
+     * @param symbol The instrument name or pattern
+     * @param id The JSON-RPC request id for an exact name
+     */
+    void subscribeSymbol(const std::string& type, const std::string& symbol, int id);
+
+    /**
+     * @brief Request the instrument list and subscribe to instrument state changes
+     */
+    void requestInstruments();
+
+    /**
+     * @brief Read OPTION_CHAIN_CURRENCIES and OPTION_CHAIN_INTERVAL_MS
+     */
+    void setupOptionChains();
+
+    /**
+     * @brief Request the options of every chain currency and subscribe to their index prices
+     */
+    void requestOptionChains();
+
+    /**
+     * @brief Add listed options to their chains and subscribe to their books
+     * 
+     * @param options The result of public/get_instruments
+     */
+    void addOptions(const json& options);
+
+    /**
+     * @brief Set the price of an option from its book; the caller holds booksMutex
+     * 
+     * @param symbol The instrument name
+     * @param mid The book's mid price, 0 while a side is empty
+     */
+    void updateOptionPrice(const std::string& symbol, double mid);
+
+    /**
+     * @brief Recompute the changed options once the interval has passed and publish their greeks
+     */
+    void recomputeOptionChains();
+
+    /**
+     * @brief Send the greeks of the options matching a subscription to a new subscriber; the caller holds chainsMutex
+     * 
+     * @param session The session
+     * @param symbol The subscribed instrument name or pattern
+     */
+    void sendCachedGreeks(const std::shared_ptr<WebSocketSession>& session, const std::string& symbol);
+
+    /**
+     * @brief Read BAR_RESOLUTIONS and BAR_HISTORY
+     */
+    void setupBars();
+
+    /**
+     * @brief Add a trades notification to the instrument's bars and publish the bars it changed
+     * 
+     * Bars a trade closed go out with "closed": true, then the open bar of
+     * each resolution with its latest figures.
+     * 
+     * @param symbol The instrument name
+     * @param trades The "data" member of the trades notification
+     */
+    void updateBars(const std::string& symbol, const json& trades);
+
+    /**
+     * @brief Send the bars held for the instruments matching a subscription to a new subscriber
+     * 
+     * Must be called with barsMutex held. Bars go oldest first; the last of
+     * each instrument is the open one.
+     * 
+     * @param session The session
+     * @param symbol The subscribed instrument name or pattern
+     * @param resolution Index of the resolution in barResolutions
+     */
+    void sendCachedBars(const std::shared_ptr<WebSocketSession>& session, const std::string& symbol,
+                        std::size_t resolution);
+
+    /**
+     * @brief Record instruments and subscribe the new ones matching pattern subscriptions
+     * 
+     * @param names The instrument names
+     */
+    void addInstruments(const std::vector<std::string>& names);
+
+    /**
+     * @brief Subscribe to a private Deribit channel, now or once authenticated
+     * 
+     * @param channel The channel name
+     */
+    void subscribePrivateChannel(const std::string& channel);
+
+    /**
+     * @brief Send a private/subscribe request
+     * 
+     * @param channels The channel names
+     */
+    void sendPrivateSubscription(const std::vector<std::string>& channels);
+
+    /**
+     * @brief Ask Deribit for heartbeats so a silent connection can be told from a quiet one
+     * 
+     * @param feed The connection
+     */
+    void enableHeartbeat(WebSocketClient& feed);
+
+    /**
+     * @brief Authenticate the Deribit connection with the API credentials, if any
+     */
+    void authenticate();
+
+    /**
+     * @brief Resubscribe every public channel in one request after a (re)connect
+     * 
+     * @param feed The connection
+     */
+    void resubscribeAll(WebSocketClient& feed);
+
+    /**
+     * @brief Handle a message from one Deribit connection, discarding duplicates
+     * 
+     * @param feed The connection index
+     * @param message The raw message
+     */
+    void onUpstreamMessage(std::size_t feed, const std::string& message);
+
+    /**
+     * @brief Handle a Deribit message that won arbitration
+     * 
+     * @param message The raw message
+     */
+    void handleUpstreamMessage(const std::string& message);
+
+    /**
+     * @brief Schedule a reconnect of a dropped connection; called on its read thread
+     * 
+     * @param feed The connection index
+     */
+    void onFeedDown(std::size_t feed);
+
+    /**
+     * @brief Mark all books for resync and tell local clients their state is stale
+     */
+    void markStale();
+
+    /**
+     * @brief Tell a stale book's subscribers it is live again; the caller holds booksMutex
+     * 
+     * Once every stale book has resynced, all clients are told the gateway is live.
+     * 
+     * @param symbol The instrument name
+     */
+    void notifyResynced(const std::string& symbol);
+
+    /**
+     * @brief Tell all clients the gateway is live again; the caller holds booksMutex
+     */
+    void notifyAllResynced();
+
+    /**
+     * @brief Stop waiting for stale books no session subscribes to any more
+     * 
+     * They may never get a snapshot, and nobody would be told when they did;
+     * if none are left waiting, all clients are told the gateway is live.
+     */
+    void pruneStaleBooks();
+
+    /**
+     * @brief Link thread: reconnect each dropped connection with exponential backoff
+     * 
+     * It also acts as the heartbeat watchdog, dropping any open connection
+     * that has received nothing for heartbeatTimeout.
+     */
+    void runLink();
+
+    /**
+     * @brief Subscribe to several public Deribit channels in one request
+     * 
+     * Channels are recorded even while disconnected and sent on (re)connect.
+     * 
+     * @param channels The channel names
+     * @param id The JSON-RPC request id
+     */
+    void subscribeChannels(const std::vector<std::string>& channels, int id);
+
+    /**
+     * @brief Subscribe to a public Deribit channel
+     * 
+     * @param channel The channel name
+     * @param id The JSON-RPC request id
+     */
+    void subscribeChannel(const std::string& channel, int id);
 
     /**
      * @brief Setup the Deribit WebSocket client
@@ -91,6 +691,21 @@ private:
      * @brief Setup the local WebSocket server
      */
     void setupLocalServer();
+
+    /**
+     * @brief Setup the capture recorder from the environment
+     */
+    void setupRecorder();
+
+    /**
+     * @brief Setup the shared memory ring from the environment
+     */
+    void setupRing();
+
+    /**
+     * @brief Setup the multicast publisher from the environment
+     */
+    void setupMulticast();
 };
 
 #endif // WEBSOCKET_MANAGER_H
\ No newline at end of file
@@ -1,10 +1,24 @@
 #include "websocket_server.h"
+#include <boost/asio/dispatch.hpp>
+#include <boost/asio/post.hpp>
+#include <boost/asio/strand.hpp>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
 #include <iostream>
+#include <type_traits>
 
 WebSocketServer::WebSocketServer(const std::string& address, unsigned short port)
     : acceptor(ioc)
-    , running(false) {
+    , localAcceptor(ioc)
+    , running(false)
+    , compression(CompressionConfig::fromEnvironment()) {
     
+    std::string maxQueued = EnvHandler::getEnvVariable("WS_MAX_QUEUED_MESSAGES");
+    if (!maxQueued.empty()) {
+        maxQueuedMessages = std::max(1, std::stoi(maxQueued));
+    }
+
     auto endpoint = tcp::endpoint(net::ip::make_address(address), port);
     acceptor.open(endpoint.protocol());
     acceptor.set_option(net::socket_base::reuse_address(true));
@@ -16,9 +30,23 @@ WebSocketServer::~WebSocketServer() {
     stop();
 }
 
+void WebSocketServer::listenLocal(const std::string& path) {
+    // A socket file left behind by an earlier run would make bind fail
+    std::remove(path.c_str());
+
+    net::local::stream_protocol::endpoint endpoint(path);
+    localAcceptor.open(endpoint.protocol());
+    localAcceptor.bind(endpoint);
+    localAcceptor.listen(net::socket_base::max_listen_connections);
+    localPath = path;
+}
+
 void WebSocketServer::run() {
     running = true;
-    doAccept();
+    doAccept(acceptor);
+    if (localAcceptor.is_open()) {
+        doAccept(localAcceptor);
+    }
 
     threads.reserve(std::thread::hardware_concurrency());
     for(std::size_t i = 0; i < threads.capacity(); ++i) {
@@ -39,31 +67,74 @@ void WebSocketServer::stop() {
     }
     threads.clear();
 
+    if (!localPath.empty()) {
+        beast::error_code ec;
+        localAcceptor.close(ec);
+        std::remove(localPath.c_str());
+    }
+
     std::lock_guard<std::mutex> lock(sessionsMutex);
     for(auto& session : sessions) {
         beast::error_code ec;
         session->ws().close(websocket::close_code::normal, ec);
     }
     sessions.clear();
+    sessionList.reset();
 }
 
 void WebSocketServer::broadcast(const std::string& message) {
-    std::lock_guard<std::mutex> lock(sessionsMutex);
-    for(auto& session : sessions) {
+    broadcast(makeSharedBuffer(message));
+}
+
+void WebSocketServer::broadcast(const SharedBuffer& message) {
+    std::shared_ptr<const std::vector<std::shared_ptr<WebSocketSession>>> list;
+    {
+        std::lock_guard<std::mutex> lock(sessionsMutex);
+        list = sessionList;
+    }
+    if (!list) {
+        return;
+    }
+
+    for(auto& session : *list) {
         session->send(message);
     }
 }
 
-void WebSocketServer::doAccept() {
+template <typename Acceptor>
+void WebSocketServer::doAccept(Acceptor& listener) {
     auto session = std::make_shared<WebSocketSession>(*this, ioc);
     
-    acceptor.async_accept(
+    listener.async_accept(
         session->ws().next_layer(),
-        [this, session](beast::error_code ec) {
+        [this, session, &listener](beast::error_code ec) {
             if (!ec) {
+                if constexpr (std::is_same<Acceptor, tcp::acceptor>::value) {
+                    // Updates are small and latency bound; Nagle would hold them back behind delayed ACKs
+                    beast::error_code optionError;
+                    session->ws().next_layer().set_option(tcp::no_delay(true), optionError);
+
+                    // The socket is protocol-generic, so its peer address is read back as a TCP endpoint
+                    auto peer = session->ws().next_layer().remote_endpoint(optionError);
+                    tcp::endpoint remote;
+                    if (!optionError && peer.size() <= remote.capacity()) {
+                        std::memcpy(remote.data(), peer.data(), peer.size());
+                        remote.resize(peer.size());
+                        // A dual-stack listener reports IPv4 peers as ::ffff:a.b.c.d
+                        net::ip::address address = remote.address();
+                        if (address.is_v6() && address.to_v6().is_v4_mapped()) {
+                            address = net::ip::make_address_v4(net::ip::v4_mapped, address.to_v6());
+                        }
+                        session->local_ = address.is_loopback();
+                    }
+                } else {
+                    session->local_ = true;
+                }
                 {
                     std::lock_guard<std::mutex> lock(sessionsMutex);
                     sessions.insert(session);
+                    sessionList = std::make_shared<const std::vector<std::shared_ptr<WebSocketSession>>>(
+                        sessions.begin(), sessions.end());
                 }
                 session->start();
                 if (connectHandler) {
@@ -74,7 +145,7 @@ void WebSocketServer::doAccept() {
             }
 
             if (running) {
-                doAccept();
+                doAccept(listener);
             }
         });
 }
@@ -82,6 +153,8 @@ void WebSocketServer::doAccept() {
 void WebSocketServer::removeSession(std::shared_ptr<WebSocketSession> session) {
     std::lock_guard<std::mutex> lock(sessionsMutex);
     sessions.erase(session);
+    sessionList = std::make_shared<const std::vector<std::shared_ptr<WebSocketSession>>>(
+        sessions.begin(), sessions.end());
 }
 
 void WebSocketServer::onConnect(std::function<void(std::shared_ptr<WebSocketSession>)> callback) {
@@ -102,7 +175,7 @@ void WebSocketServer::onError(std::function<void(const std::string&)> callback)
 
 
 WebSocketSession::WebSocketSession(WebSocketServer& server, net::io_context& ioc) 
-        : server(server), ws_(ioc) {
+        : server(server), ws_(net::make_strand(ioc)) {
         // Check environment variable for binary protocol
         std::string binary_protocol = EnvHandler::getEnvVariable("BINARY_PROTOCOL");
         use_binary_ = (std::string(binary_protocol) == "true");
@@ -115,13 +188,27 @@ WebSocketSession::WebSocketSession(WebSocketServer& server, net::io_context& ioc
             websocket::stream_base::timeout::suggested(
                 beast::role_type::server));
 
-        ws_.set_option(websocket::permessage_deflate{});
+        // permessage-deflate is only offered in PERMESSAGE mode; SHARED mode
+        // compresses broadcasts once in the manager instead
+        const CompressionConfig& compression = server.compressionConfig();
+        websocket::permessage_deflate pmd;
+        pmd.server_enable = compression.mode == CompressionConfig::Mode::PERMESSAGE;
+        pmd.server_max_window_bits = compression.windowBits;
+        pmd.server_no_context_takeover = compression.noContextTakeover;
+        pmd.compLevel = compression.level;
+        pmd.memLevel = compression.memLevel;
+        ws_.set_option(pmd);
         
         std::cout << "WebSocket protocol mode: " 
                   << (use_binary_ ? "binary" : "text") << std::endl;
     }
 
 void WebSocketSession::start() {
+    // Every operation on the stream runs on its strand, whichever server thread completes it
+    net::dispatch(ws_.get_executor(), [self = shared_from_this()] { self->accept(); });
+}
+
+void WebSocketSession::accept() {
     ws_.set_option(websocket::stream_base::timeout::suggested(
         beast::role_type::server));
 
@@ -134,11 +221,16 @@ void WebSocketSession::start() {
 
     ws_.async_accept(
         beast::bind_front_handler(
-            [this](beast::error_code ec) {
+            [this, self = shared_from_this()](beast::error_code ec) {
                 if(ec) {
                     if(server.errorHandler) {
                         server.errorHandler("WebSocket Accept error: " + ec.message());
                     }
+                    // Scans and plain HTTP probes would otherwise stay in the broadcast list for good
+                    if (server.disconnectHandler) {
+                        server.disconnectHandler(self);
+                    }
+                    server.removeSession(self);
                     return;
                 }
                 doRead();
@@ -158,6 +250,11 @@ void WebSocketSession::doRead() {
                 if (ec != websocket::error::closed) {
                     std::cerr << "Read error: " << ec.message() << std::endl;
                 }
+                // Broadcasts must stop referencing a session once its client is gone
+                if (server.disconnectHandler) {
+                    server.disconnectHandler(self);
+                }
+                server.removeSession(self);
                 return;
             }
             
@@ -173,19 +270,20 @@ void WebSocketSession::doRead() {
             doRead();
         });
 }
-void WebSocketSession::doWrite(const std::string& message) {
-    auto self = shared_from_this();
-    outgoing_message = message;
-    
+void WebSocketSession::doWrite() {
+    SharedBuffer message;
+    bool binary;
+    {
+        std::lock_guard<std::mutex> lock(write_mutex_);
+        message = write_queue_.front().first;
+        binary = write_queue_.front().second;
+    }
+
+    ws_.text(!binary);
     ws_.async_write(
-        net::buffer(outgoing_message),
-        [self](beast::error_code ec, std::size_t bytes_transferred) {
-            if (ec) {
-                if (self->server.errorHandler) {
-                    self->server.errorHandler("Write error: " + ec.message());
-                }
-                return;
-            }
+        net::buffer(*message),
+        [self = shared_from_this(), message](beast::error_code ec, std::size_t bytes_transferred) {
+            self->onWrite(ec, bytes_transferred);
         });
 }
 
@@ -216,18 +314,64 @@ void WebSocketSession::onRead(beast::error_code ec, std::size_t bytes_transferre
 }
 
 void WebSocketSession::send(const std::string& message) {
-    outgoing_message = message;    
-    // Set the message type according to configuration
-    ws_.text(!use_binary_);
-    
-    ws_.async_write(
-        net::buffer(outgoing_message),
-        beast::bind_front_handler(
-            &WebSocketSession::onWrite,
-            shared_from_this()));
+    send(makeSharedBuffer(message), use_binary_);
+}
+
+void WebSocketSession::send(const std::string& message, bool binary) {
+    send(makeSharedBuffer(message), binary);
+}
+
+void WebSocketSession::send(const SharedBuffer& message) {
+    send(message, use_binary_);
+}
+
+void WebSocketSession::send(const SharedBuffer& message, bool binary) {
+    {
+        std::lock_guard<std::mutex> lock(write_mutex_);
+        if (closing_) {
+            return;
         }
+        if (write_queue_.size() >= server.maxQueuedMessages) {
+            // A client this far behind is dropped rather than buffered without bound
+            std::cerr << "Dropping slow client with " << write_queue_.size() << " queued messages" << std::endl;
+            closeLocked();
+            return;
+        }
+        write_queue_.emplace_back(message, binary);
+        if (writing_) {
+            return; // onWrite picks it up when the write in flight completes
+        }
+        writing_ = true;
+    }
+
+    net::post(ws_.get_executor(), [self = shared_from_this()] { self->doWrite(); });
+}
+
+void WebSocketSession::closeLocked() {
+    closing_ = true;
+    net::post(ws_.get_executor(), [self = shared_from_this()] {
+        beast::error_code ec;
+        beast::get_lowest_layer(self->ws_).close(ec);
+    });
+}
 
 void WebSocketSession::onWrite(beast::error_code ec, std::size_t bytes_transferred) {
+    {
+        std::lock_guard<std::mutex> lock(write_mutex_);
+        write_queue_.pop_front();
+        if (ec || closing_) {
+            write_queue_.clear();
+            writing_ = false;
+            if (closing_) {
+                return; // Already being dropped; later sends are discarded
+            }
+            closeLocked();
+        } else if (write_queue_.empty()) {
+            writing_ = false;
+            return;
+        }
+    }
+
     if(ec) {
         if(server.errorHandler) {
             server.errorHandler("Write error: " + ec.message());
@@ -235,5 +379,5 @@ void WebSocketSession::onWrite(beast::error_code ec, std::size_t bytes_transferr
         return;
     }
 
-    outgoing_message.clear();
-}
\ No newline at end of file
+    doWrite();
+}
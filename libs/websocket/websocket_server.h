@@ -5,6 +5,9 @@
 #include <boost/beast/websocket.hpp>
 #include <boost/beast/http.hpp>
 #include <boost/asio/ip/tcp.hpp>
+#include <boost/asio/generic/stream_protocol.hpp>
+#include <boost/asio/local/stream_protocol.hpp>
+#include <deque>
 #include <functional>
 #include <string>
 #include <memory>
@@ -12,7 +15,9 @@
 #include <vector>
 #include <unordered_set>
 #include <mutex>
+#include <atomic>
 #include "env_handler.h"
+#include "message_deflate.h"
 
 namespace beast = boost::beast;
 namespace websocket = beast::websocket;
@@ -23,6 +28,24 @@ using tcp = boost::asio::ip::tcp;
 // Forward declaration
 class WebSocketSession;
 
+/**
+ * @brief Immutable, reference-counted message payload
+ *
+ * One buffer is shared by every session a message is sent to; each queued
+ * write holds a reference until it completes, so no session copies it.
+ */
+using SharedBuffer = std::shared_ptr<const std::string>;
+
+/**
+ * @brief Create a shared buffer by taking ownership of a message
+ * 
+ * @param message The message
+ * @return SharedBuffer The buffer
+ */
+inline SharedBuffer makeSharedBuffer(std::string message) {
+    return std::make_shared<const std::string>(std::move(message));
+}
+
 /**
  * @brief Class to manage WebSocket server operations
  */
@@ -41,6 +64,17 @@ public:
      */
     ~WebSocketServer();
 
+    /**
+     * @brief Also accept sessions on a Unix domain socket
+     * 
+     * Same-host clients connecting there get the same WebSocket protocol
+     * and sessions as TCP clients, without the loopback TCP stack. Call
+     * before run(); an existing file at the path is replaced.
+     * 
+     * @param path Filesystem path of the socket
+     */
+    void listenLocal(const std::string& path);
+
     /**
      * @brief Run the WebSocket server
      */
@@ -58,6 +92,13 @@ public:
      */
     void broadcast(const std::string& message);
 
+    /**
+     * @brief Broadcast a shared buffer to all connected clients without copying it
+     * 
+     * @param message The message to broadcast
+     */
+    void broadcast(const SharedBuffer& message);
+
     /**
      * @brief Set the callback for new connections
      * 
@@ -86,11 +127,21 @@ public:
      */
     void onError(std::function<void(const std::string&)> callback);
 
+    /**
+     * @brief Get the compression settings applied to sessions
+     * 
+     * @return const CompressionConfig& The settings read at construction
+     */
+    const CompressionConfig& compressionConfig() const { return compression; }
+
 private:
     /**
      * @brief Accept new connections
+     * 
+     * @param listener The TCP or Unix domain socket acceptor
      */
-    void doAccept();
+    template <typename Acceptor>
+    void doAccept(Acceptor& listener);
 
     /**
      * @brief Remove a session from the active sessions
@@ -101,11 +152,16 @@ private:
 
     net::io_context ioc; /**< IO context for asynchronous operations */
     tcp::acceptor acceptor; /**< TCP acceptor for incoming connections */
+    net::local::stream_protocol::acceptor localAcceptor; /**< Unix domain socket acceptor, open after listenLocal */
+    std::string localPath; /**< Path of the Unix domain socket, removed on stop */
     std::vector<std::thread> threads; /**< Threads for handling connections */
     bool running; /**< Flag to indicate if the server is running */
+    CompressionConfig compression; /**< Compression settings for sessions */
+    std::size_t maxQueuedMessages = 4096; /**< Writes a session may have queued before it is dropped, from WS_MAX_QUEUED_MESSAGES */
 
     std::unordered_set<std::shared_ptr<WebSocketSession>> sessions; /**< Set of active sessions */
-    std::mutex sessionsMutex; /**< Mutex for synchronizing access to sessions */
+    std::shared_ptr<const std::vector<std::shared_ptr<WebSocketSession>>> sessionList; /**< Copy of sessions, replaced on every change, that broadcasts iterate outside the lock */
+    std::mutex sessionsMutex; /**< Mutex for synchronizing access to sessions and sessionList */
 
     std::function<void(std::shared_ptr<WebSocketSession>)> connectHandler; /**< Callback for new connections */
     std::function<void(std::shared_ptr<WebSocketSession>, const std::string&)> messageHandler; /**< Callback for incoming messages */
@@ -131,9 +187,9 @@ public:
     /**
      * @brief Get the WebSocket stream
      * 
-     * @return websocket::stream<tcp::socket>& Reference to the WebSocket stream
+     * @return websocket::stream<net::generic::stream_protocol::socket>& Reference to the WebSocket stream
      */
-    websocket::stream<tcp::socket>& ws() { return ws_; }
+    websocket::stream<net::generic::stream_protocol::socket>& ws() { return ws_; }
 
     /**
      * @brief Start the WebSocket session
@@ -147,7 +203,68 @@ public:
      */
     void send(const std::string& message);
 
+    /**
+     * @brief Send a message to the client with an explicit frame type
+     * 
+     * @param message The message to send
+     * @param binary True for a binary frame, false for a text frame
+     */
+    void send(const std::string& message, bool binary);
+
+    /**
+     * @brief Queue a shared buffer for sending without copying it
+     * 
+     * May be called from any thread; writes are issued in order on the
+     * session's strand. A client that falls WS_MAX_QUEUED_MESSAGES writes
+     * behind is disconnected, and messages sent to a closing session are
+     * discarded.
+     * 
+     * @param message The message to send
+     * @param binary True for a binary frame, false for a text frame
+     */
+    void send(const SharedBuffer& message, bool binary);
+
+    /**
+     * @brief Queue a shared buffer for sending in the session's protocol mode
+     * 
+     * @param message The message to send
+     */
+    void send(const SharedBuffer& message);
+
+    /**
+     * @brief Opt the session in or out of shared broadcast compression
+     * 
+     * @param enabled True to receive large text updates as deflated binary frames
+     */
+    void setSharedCompression(bool enabled) { shared_compression_ = enabled; }
+
+    /**
+     * @brief Check if the session receives shared compressed broadcasts
+     * 
+     * @return true if opted in, false otherwise
+     */
+    bool usesSharedCompression() const { return shared_compression_; }
+
+    /**
+     * @brief Check if the client is on this host
+     * 
+     * @return true for Unix domain socket and loopback TCP clients
+     */
+    bool isLocal() const { return local_; }
+
+    /**
+     * @brief Check if the session uses the binary protocol
+     * 
+     * @return true if binary messages are sent, false for JSON text
+     */
+    bool isBinary() const { return use_binary_; }
+
 private:
+    /**
+     * @brief Perform the WebSocket handshake; runs on the session's strand
+     */
+    void accept();
+
     /**
      * @brief Read data from the client
      */
@@ -162,11 +279,17 @@ private:
     void onRead(beast::error_code ec, std::size_t bytes_transferred);
 
     /**
-     * @brief Write data to the client
+     * @brief Write the message at the front of the queue; runs on the session's strand
+     */
+    void doWrite();
+
+    /**
+     * @brief Stop queuing writes and close the socket
      * 
-     * @param message The message to write
+     * The pending read then fails, which unregisters the session. Must be
+     * called with write_mutex_ held.
      */
-    void doWrite(const std::string& message);
+    void closeLocked();
 
     /**
      * @brief Handle write completion
@@ -177,10 +300,17 @@ private:
     void onWrite(beast::error_code ec, std::size_t bytes_transferred);
 
     WebSocketServer& server; /**< Reference to the WebSocket server */
-    websocket::stream<tcp::socket> ws_; /**< WebSocket stream */
+    websocket::stream<net::generic::stream_protocol::socket> ws_; /**< WebSocket stream over a TCP or Unix domain socket */
     beast::flat_buffer buffer; /**< Buffer for reading data */
-    std::string outgoing_message; /**< Message to send */
+    std::deque<std::pair<SharedBuffer, bool>> write_queue_; /**< Messages waiting to be written, with their binary flag */
+    bool writing_ = false; /**< True while a write is in flight or posted */
+    bool closing_ = false; /**< True once the session is being dropped; nothing more is queued */
+    std::mutex write_mutex_; /**< Mutex for synchronizing access to write_queue_, writing_ and closing_ */
     bool use_binary_; /**< Flag to indicate if binary mode is used */
+    bool local_ = false; /**< Set on accept for Unix domain socket and loopback TCP clients */
+    std::atomic<bool> shared_compression_{false}; /**< Flag to indicate if shared compressed broadcasts are used */
+
+    friend class WebSocketServer;
 };
 
 #endif // WEBSOCKET_SERVER_H
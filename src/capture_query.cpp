@@ -0,0 +1,166 @@
+#include "capture_query.h"
+#include <ctime>
+#include <iostream>
+#include <string>
+#include <nlohmann/json.hpp>
+
+using json = nlohmann::json;
+
+// Function to print usage
+void printUsage()
+{
+    std::cout << "\nUsage: capture_query <capture_dir> <command> [args]\n"
+              << "----------------------------------------\n"
+              << "  info                                 - List segments and block counts\n"
+              << "  book <instrument> <time> [depth]     - Rebuild the book at a time\n"
+              << "  trades <instrument> <from> <to>      - Stream trades recorded in a range\n"
+              << "  frames <from> <to> [channel_filter]  - Stream raw frames in a range\n"
+              << "\nTimes are UTC and may be given as:\n"
+              << "  2024-12-27T14:03:12.5   date and time\n"
+              << "  14:03:12.5              time on the day the capture starts\n"
+              << "  1735308192500           epoch milliseconds (or seconds / nanoseconds)\n"
+              << "----------------------------------------\n";
+}
+
+/**
+ * @brief Parse a UTC time argument into nanoseconds since epoch
+ *
+ * @param text The argument
+ * @param referenceNs Timestamp whose UTC date is used for time-of-day arguments
+ * @return uint64_t Nanoseconds since epoch
+ */
+uint64_t parseTime(const std::string &text, uint64_t referenceNs)
+{
+    if (!text.empty() && text.find_first_not_of("0123456789") == std::string::npos)
+    {
+        uint64_t value = std::stoull(text);
+        if (text.size() >= 16)
+            return value;
+        if (text.size() >= 13)
+            return value * 1000000ULL;
+        return value * 1000000000ULL;
+    }
+
+    std::tm tm = {};
+    std::string clock = text;
+    auto separator = text.find_first_of("T ");
+    if (separator != std::string::npos)
+    {
+        if (std::sscanf(text.c_str(), "%d-%d-%d", &tm.tm_year, &tm.tm_mon, &tm.tm_mday) != 3)
+        {
+            throw std::invalid_argument("Invalid date: " + text);
+        }
+        tm.tm_year -= 1900;
+        tm.tm_mon -= 1;
+        clock = text.substr(separator + 1);
+    }
+    else
+    {
+        std::time_t reference = static_cast<std::time_t>(referenceNs / 1000000000ULL);
+        gmtime_r(&reference, &tm);
+    }
+
+    int hours = 0, minutes = 0;
+    double seconds = 0.0;
+    if (std::sscanf(clock.c_str(), "%d:%d:%lf", &hours, &minutes, &seconds) < 2)
+    {
+        throw std::invalid_argument("Invalid time: " + text);
+    }
+    tm.tm_hour = hours;
+    tm.tm_min = minutes;
+    tm.tm_sec = 0;
+
+    auto wholeSeconds = static_cast<uint64_t>(timegm(&tm));
+    return wholeSeconds * 1000000000ULL + static_cast<uint64_t>(seconds * 1e9 + 0.5);
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc < 3)
+    {
+        printUsage();
+        return 1;
+    }
+
+    try
+    {
+        CaptureQuery query(argv[1]);
+        std::string command = argv[2];
+        uint64_t reference = query.firstTimestamp();
+
+        if (command == "info")
+        {
+            for (std::size_t i = 0; i < query.segmentCount(); ++i)
+            {
+                CaptureReader &reader = query.reader(i);
+                uint64_t frames = 0, raw = 0, compressed = 0;
+                for (std::size_t b = 0; b < reader.blockCount(); ++b)
+                {
+                    frames += reader.block(b).frameCount;
+                    raw += reader.block(b).rawSize;
+                    compressed += reader.block(b).compressedSize;
+                }
+                std::cout << query.segmentPath(i) << ": "
+                          << reader.blockCount() << " blocks, "
+                          << frames << " frames, "
+                          << raw << " -> " << compressed << " bytes";
+                if (reader.blockCount() > 0)
+                {
+                    std::cout << ", " << reader.block(0).firstTimestampNs
+                              << " .. " << reader.block(reader.blockCount() - 1).lastTimestampNs;
+                }
+                std::cout << std::endl;
+            }
+        }
+        else if (command == "book" && argc >= 5)
+        {
+            std::string instrument = argv[3];
+            uint64_t at = parseTime(argv[4], reference);
+            std::size_t depth = argc >= 6 ? std::stoul(argv[5]) : 10;
+
+            OrderBook book;
+            if (!query.bookAt(instrument, at, book))
+            {
+                std::cerr << "No book snapshot for " << instrument << " at or before " << at << std::endl;
+                return 1;
+            }
+            std::cout << book.toJson(depth).dump(2) << std::endl;
+        }
+        else if (command == "trades" && argc >= 6)
+        {
+            std::string instrument = argv[3];
+            uint64_t from = parseTime(argv[4], reference);
+            uint64_t to = parseTime(argv[5], reference);
+
+            query.trades(instrument, from, to, [](uint64_t receivedNs, const json &trade)
+                         {
+                             std::cout << receivedNs << " " << trade.dump() << "\n";
+                             return true; });
+            std::cout.flush();
+        }
+        else if (command == "frames" && argc >= 5)
+        {
+            uint64_t from = parseTime(argv[3], reference);
+            uint64_t to = parseTime(argv[4], reference);
+            std::string filter = argc >= 6 ? argv[5] : "";
+
+            query.frames(from, to, filter, [](uint64_t receivedNs, std::string_view frame)
+                         {
+                             std::cout << receivedNs << " " << frame << "\n";
+                             return true; });
+            std::cout.flush();
+        }
+        else
+        {
+            printUsage();
+            return 1;
+        }
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "Query failed: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -73,10 +73,19 @@ void printHelp()
               << "  sell <instrument> <type> <amount> [price] - Place sell order\n"
               << "  cancel <order_id>       - Cancel specific order\n"
               << "  modify <order_id> <new_price> <new_amount> - Modify existing order\n"
+              << "  kill                    - Cancel all orders on every transport and halt trading\n"
+              << "  resume                  - Accept orders again after kill\n"
+              << "\nExecution Algorithms:\n"
+              << "  twap <instrument> <side> <amount> <lot> <seconds> [limit]  - Spread an order evenly over time\n"
+              << "  vwap <instrument> <side> <amount> <lot> <percent> <seconds> [limit] - Trade a share of market volume\n"
+              << "  algos                   - Show execution algorithms and their fills\n"
+              << "  stopalgo <id>           - Cancel an execution algorithm\n"
               << "\nInformation Commands:\n"
               << "  orders                  - Get active orders (optional: for specific instrument)\n"
               << "  orderbook <instrument>  - Get orderbook\n"
               << "  positions <currency>    - Get positions\n"
+              << "  feeds                   - Show win rates of the Deribit connections\n"
+              << "  latency                 - Show the exchange clock offset and request latency by leg\n"
               << "\nOther Commands:\n"
               << "  help                    - Show this help\n"
               << "  quit                    - Exit program\n"
@@ -94,13 +103,13 @@ int main()
             return 1;
         }
 
-        // Create order placement handler
-        OrderPlacement orderHandler;
-
         // Create and start WebSocket manager
         WebSocketManager wsManager("0.0.0.0", 8000);
         wsManager.start();
 
+        // Console commands share the manager's authenticated order path with local clients
+        OrderPlacement &orderHandler = wsManager.orders();
+
         std::cout << "\nConnecting to Deribit..." << std::endl;
         wsManager.connectToDeribit("www.deribit.com", "443", "/ws/api/v2");
 
@@ -110,7 +119,17 @@ int main()
         std::string input;
         while (wsManager.isRunning() && std::getline(std::cin, input))
         {
-            if (input == "quit")
+            if (input == "kill")
+            {
+                wsManager.killSwitch([](const json &report)
+                                     { std::cout << "Kill switch report: " << report.dump(2) << std::endl; });
+            }
+            else if (input == "resume")
+            {
+                orderHandler.resume();
+                std::cout << "Trading resumed" << std::endl;
+            }
+            else if (input == "quit")
             {
                 break;
             }
@@ -273,6 +292,69 @@ int main()
                     std::cerr << "Error modifying order: " << e.what() << std::endl;
                 }
             }
+            else if (input == "feeds")
+            {
+                std::cout << wsManager.feedStats().dump(2) << std::endl;
+            }
+            else if (input == "latency")
+            {
+                std::cout << orderHandler.latencyStats().dump(2) << std::endl;
+            }
+            else if (input.substr(0, 5) == "twap " || input.substr(0, 5) == "vwap ")
+            {
+                try
+                {
+                    std::istringstream iss(input);
+                    std::string algorithm, instrument, side, amountStr, lotStr, percentStr, secondsStr, limitStr;
+                    iss >> algorithm >> instrument >> side >> amountStr >> lotStr;
+                    if (algorithm == "vwap")
+                    {
+                        iss >> percentStr;
+                    }
+                    iss >> secondsStr >> limitStr;
+
+                    if (secondsStr.empty())
+                    {
+                        std::cout << "Usage: twap <instrument> <side> <amount> <lot> <seconds> [limit]\n"
+                                  << "       vwap <instrument> <side> <amount> <lot> <percent> <seconds> [limit]" << std::endl;
+                        continue;
+                    }
+
+                    ExecutionEngine::ParentSpec spec;
+                    spec.algorithm = ExecutionEngine::algorithmFromString(algorithm);
+                    spec.instrument = instrument;
+                    spec.side = side;
+                    spec.amount = std::stod(amountStr);
+                    spec.lotSize = std::stod(lotStr);
+                    spec.participation = percentStr.empty() ? 0.0 : std::stod(percentStr) / 100;
+                    spec.duration = std::chrono::milliseconds(static_cast<int64_t>(std::stod(secondsStr) * 1000));
+                    spec.limitPrice = limitStr.empty() ? 0.0 : std::stod(limitStr);
+
+                    uint64_t id = wsManager.executionEngine().submit(spec);
+                    std::cout << "Started " << algorithm << " " << id << std::endl;
+                }
+                catch (const std::exception &e)
+                {
+                    std::cerr << "Error starting algorithm: " << e.what() << std::endl;
+                }
+            }
+            else if (input == "algos")
+            {
+                std::cout << wsManager.executionEngine().status().dump(2) << std::endl;
+            }
+            else if (input.substr(0, 9) == "stopalgo ")
+            {
+                try
+                {
+                    uint64_t id = std::stoull(input.substr(9));
+                    bool cancelled = wsManager.executionEngine().cancel(id);
+                    std::cout << (cancelled ? "Cancelled algorithm " : "No running algorithm ") << id << std::endl;
+                }
+                catch (const std::exception &e)
+                {
+                    std::cerr << "Error cancelling algorithm: " << e.what() << std::endl;
+                }
+            }
             else if (input == "orders")
             {
                 try
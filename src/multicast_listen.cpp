@@ -0,0 +1,116 @@
+#include "multicast_receiver.h"
+#include "binary_protocol.h"
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <iostream>
+#include <string>
+#include <thread>
+
+std::atomic<bool> running{true};
+
+/**
+ * @brief Signal handler for graceful shutdown
+ */
+void signalHandler(int)
+{
+    running = false;
+}
+
+// Function to print usage
+void printUsage()
+{
+    std::cout << "\nUsage: multicast_listen <group> <port> <recovery_host> <recovery_port> [interface] [snapshot_instrument]\n"
+              << "----------------------------------------\n"
+              << "Joins the gateway's market data group (MULTICAST_GROUP) and prints\n"
+              << "every packet in sequence order. Gaps are filled from the recovery\n"
+              << "service. With snapshot_instrument, the current book of that\n"
+              << "instrument is requested first.\n"
+              << "Loopback test: multicast_listen 239.255.0.1 30001 127.0.0.1 30002 127.0.0.1\n"
+              << "----------------------------------------\n";
+}
+
+/**
+ * @brief Print one packet
+ *
+ * @param header The multicast header
+ * @param payload The binary protocol message
+ */
+void printPacket(const MulticastPacketHeader& header, std::string_view payload)
+{
+    std::cout << header.sequence;
+    if (header.flags & MULTICAST_FLAG_RETRANSMIT) std::cout << " [retransmit]";
+    if (header.flags & MULTICAST_FLAG_SNAPSHOT) std::cout << " [snapshot]";
+
+    BinaryMessageView view;
+    if (view.parse(payload.data(), payload.size()))
+    {
+        std::cout << " " << view.instrument()
+                  << " type " << view.header().type
+                  << " seq " << view.header().sequence
+                  << " (" << payload.size() << " bytes)";
+    }
+    else
+    {
+        std::cout << " invalid binary message";
+    }
+    std::cout << "\n";
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc < 5)
+    {
+        printUsage();
+        return 1;
+    }
+
+    std::signal(SIGINT, signalHandler);
+    std::signal(SIGTERM, signalHandler);
+
+    MulticastReceiverConfig config;
+    config.group = argv[1];
+    config.port = static_cast<unsigned short>(std::stoi(argv[2]));
+    config.recoveryHost = argv[3];
+    config.recoveryPort = static_cast<unsigned short>(std::stoi(argv[4]));
+    if (argc >= 6) config.interfaceAddress = argv[5];
+
+    try
+    {
+        MulticastReceiver receiver(config, printPacket);
+
+        if (argc >= 7)
+        {
+            std::string payload;
+            if (receiver.requestSnapshot(argv[6], payload))
+            {
+                MulticastPacketHeader header{};
+                header.flags = MULTICAST_FLAG_SNAPSHOT;
+                printPacket(header, payload);
+            }
+            else
+            {
+                std::cerr << "No book for " << argv[6] << std::endl;
+            }
+        }
+
+        receiver.start();
+        while (running)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        }
+        receiver.stop();
+
+        std::cout.flush();
+        std::cerr << "Received: " << receiver.received()
+                  << ", recovered: " << receiver.recovered()
+                  << ", lost: " << receiver.lost() << std::endl;
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "Failed to listen: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
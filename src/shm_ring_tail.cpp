@@ -0,0 +1,104 @@
+#include "shm_ring.h"
+#include "binary_protocol.h"
+#include <atomic>
+#include <csignal>
+#include <iostream>
+#include <string>
+#include <thread>
+
+std::atomic<bool> running{true};
+
+/**
+ * @brief Signal handler for graceful shutdown
+ */
+void signalHandler(int)
+{
+    running = false;
+}
+
+// Function to print usage
+void printUsage()
+{
+    std::cout << "\nUsage: shm_ring_tail <ring_name> [topic_prefix]\n"
+              << "----------------------------------------\n"
+              << "Attaches to the ring published by the gateway (SHM_RING_NAME)\n"
+              << "and prints every message whose topic starts with the prefix.\n"
+              << "Topics are <type>.<instrument>, e.g. orderbook.BTC-PERPETUAL\n"
+              << "----------------------------------------\n";
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc < 2)
+    {
+        printUsage();
+        return 1;
+    }
+
+    std::signal(SIGINT, signalHandler);
+    std::signal(SIGTERM, signalHandler);
+    std::string prefix = argc >= 3 ? argv[2] : "";
+
+    try
+    {
+        ShmRingReader reader(argv[1]);
+        ShmMessage message;
+        uint64_t idlePolls = 0;
+
+        while (running)
+        {
+            switch (reader.poll(message))
+            {
+            case ShmRingReader::Status::EMPTY:
+                // Spin briefly, then back off so an idle tail does not burn a core
+                if (++idlePolls > 1000)
+                {
+                    std::this_thread::sleep_for(std::chrono::microseconds(100));
+                }
+                break;
+
+            case ShmRingReader::Status::OVERRUN:
+                std::cerr << "Overrun: reader was lapped, skipping to newest data" << std::endl;
+                break;
+
+            case ShmRingReader::Status::MESSAGE:
+                idlePolls = 0;
+                if (message.topic.compare(0, prefix.size(), prefix) != 0)
+                {
+                    break;
+                }
+                std::cout << message.sequence << " " << message.topic << " ";
+                if (message.binary)
+                {
+                    BinaryMessageView view;
+                    if (view.parse(message.payload.data(), message.payload.size()))
+                    {
+                        std::cout << "binary type " << view.header().type
+                                  << " seq " << view.header().sequence
+                                  << " (" << message.payload.size() << " bytes)";
+                    }
+                    else
+                    {
+                        std::cout << "invalid binary message";
+                    }
+                }
+                else
+                {
+                    std::cout << message.payload;
+                }
+                std::cout << "\n";
+                break;
+            }
+        }
+
+        std::cout.flush();
+        std::cerr << "Messages lost to overruns: " << reader.lost() << std::endl;
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "Failed to attach: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}